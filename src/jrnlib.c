@@ -0,0 +1,6652 @@
+/***************************************************************************/
+/*                                                                         */
+/*  Module name:    JRNLIB                                                 */
+/*  Author:         Mark Phillips                                          */
+/*  Function:       Automate jrn maintenance in IBM MQ for IBM i - the     */
+/*                  library behind the JRNMAINT program.  Its interface    */
+/*                  is described in jrnmaint.h.                            */
+/*                                                                         */
+/* Copyright (c) 2003,2024 IBM Corp.                                       */
+/*                                                                         */
+/* Licensed under the Apache License, Version 2.0 (the "License");         */
+/* you may not use this file except in compliance with the License.        */
+/* You may obtain a copy of the License at                                 */
+/*                                                                         */
+/*    http://www.apache.org/licenses/LICENSE-2.0                           */
+/*                                                                         */
+/* Unless required by applicable law or agreed to in writing, software     */
+/* distributed under the License is distributed on an "AS IS" BASIS,       */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.*/
+/* See the License for the specific language governing permissions and     */
+/* limitations under the License.                                          */
+/*                                                                         */
+/***************************************************************************/
+#define _MULTI_THREADED
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <stddef.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "jrnplat.h"
+#include "jrnmaint.h"
+
+/***************************************************************************/
+/*  Constants used by this program                                         */
+/***************************************************************************/
+#define INITIAL_CHAIN 64      /* Receivers to allow for on the first call  */
+#define SPARE_CHAIN 16        /* Extra receivers allowed for on a retry    */
+#define MAX_RTV_ATTEMPTS 5    /* Calls to make while the chain is growing  */
+#define JRN_NAME "AMQAJRN   " /* Journal name                              */
+#define SPC_NAME "AMQJRNINF " /* User Space Name                           */
+#define MAX_QMGR_PARM 50      /* Max. libraries listed on QMGRLIB          */
+#define RCV_STATUS_SAVED '3'  /* Journal receiver status - saved           */
+#define RCV_STATUS_FREED '4'  /* - saved, and its storage freed            */
+#define MSG_TEXT_MAX 1024     /* Max. text in one consolidated message     */
+
+#define PHASE_CHKOBJ 0        /* Check the library exists (QUSROBJD)       */
+#define PHASE_USRSPC 1        /* Read AMQJRNINF (QUSPTRUS)                 */
+#define PHASE_CHAIN  2        /* Retrieve the receiver chain               */
+#define PHASE_SCAN   3        /* Index the chain and find the cutoff       */
+#define PHASE_DELETE 4        /* Save and delete the eligible receivers    */
+#define NUM_PHASES   5
+
+#define ANALYSIS_WINDOW 32    /* Recent receivers used to forecast growth  */
+#define MAX_EXIT_QMGRS 16     /* Queue managers cached by the exit program */
+#define PIN_BLOCK 512         /* Journal entries retrieved per call        */
+#define MAX_OPEN_CYCLES 256   /* Commit cycles tracked by FINDPIN(*YES)    */
+#define MAX_PIN_THREADS 4     /* Receivers scanned at the same time        */
+#define HIST_MAGIC "JRNHIST2" /* History file identifier and version       */
+#define HIST_RECORDS 8192     /* Records kept in each history file         */
+#define HIST_HEARTBEAT 3600   /* Seconds between records that only repeat  */
+                              /* the last one                              */
+#define TRACE_VERSION 1       /* TRACE file format                         */
+#define REPLAY_MICROS 1000000 /* Time spent measuring replay throughput    */
+#define ARC_MAGIC "JRNARC1"   /* Archive index file identifier             */
+#define ARC_MIN_CHUNK 2048    /* Smallest archive chunk ...                */
+#define ARC_MAX_CHUNK 65536   /* ... and largest                           */
+#define ARC_CHUNK_BITS 13     /* Chunks average about 2 ** 13 bytes more   */
+                              /* than ARC_MIN_CHUNK                        */
+#define ARC_BLOCK 4194304     /* Save file read and chunked at a time      */
+#define ARC_THREADS 4         /* Chunks compressed at the same time        */
+#define ARC_RECIPE_BLOCK 1024 /* Chunk numbers read at a time on restore   */
+#define LZ_HASH_BITS 12       /* Compression match table size              */
+#define FNV_BASIS 0xCBF29CE484222325ULL  /* FNV-1a 64 bit hash            */
+#define FNV_PRIME 0x100000001B3ULL
+#define PACE_MAX_SCALE 64     /* Slowest pace - 1/64 of DLTRATE/DLTPERMIN  */
+#define PACE_BACKOFF 1000000  /* Microseconds between deletes added at     */
+                              /* each step slower, with no budget set      */
+#define PACE_SLOW_FACTOR 3    /* A DLTJRNRCV this many times slower than   */
+#define PACE_SLOW_MICROS 10000   /* usual, and at least this long, means   */
+                              /* the system is busy                        */
+#define PACE_SLEEP 1000000    /* Longest wait before checking for the end  */
+
+#ifndef MQS_INI_PATH          /* Queue manager configuration file          */
+#define MQS_INI_PATH "/QIBM/UserData/mqm/mqs.ini"
+#endif
+
+#define RCV_TIME_RESOLUTION 1000  /* Receiver attach times are to the second */
+
+/***************************************************************************/
+/*  Compact index of the receiver chain, oldest receiver first.  Held as   */
+/*  separate arrays so the attach times searched by FindOldestNeeded() are */
+/*  contiguous, rather than spread across the 128 byte API entries.        */
+/***************************************************************************/
+struct RcvIndex {
+  int         Count;          /* Number of receivers in the index        */
+  int        *Number;         /* Receiver number (numeric name suffix)   */
+  JrnTime    *AttachTime;     /* Attach time (start of the second)       */
+  char      (*Name)[10];      /* Blank padded receiver name              */
+  char       *Status;         /* Receiver status ('3' = saved)           */
+  int        *SizeK;          /* Receiver size in K (0 if not reported)  */
+  int         Size;           /* Number of receivers allocated for       */
+};
+
+/***************************************************************************/
+/*  Structure defining format of AMQJRNINF user space                      */
+/***************************************************************************/
+struct JrnInf {
+  char    JrnName[20];        /* Journal + library name */
+  char    CC[2];              /* Year (century)         */
+  char    YY[2];              /* Year                   */
+  char    MM[2];              /* Month                  */
+  char    DD[2];              /* Day                    */
+  char    HH[2];              /* Hours                  */
+  char    mm[2];              /* Minutes                */
+  char    SS[2];              /* Seconds                */
+  char    mmm[3];             /* Milliseconds           */
+};
+
+/***************************************************************************/
+/*  Timings and counters for the METRICS file, from the last time the      */
+/*  queue manager was processed (or checked, in resident mode)             */
+/***************************************************************************/
+struct QmgrMetrics {
+  long long PhaseMicros[NUM_PHASES];  /* Time taken by each PHASE_        */
+  int       ChainCalls;       /* QjoRetrieveJournalInformation calls     */
+  long long ChainBytes;       /* Bytes of receiver chain retrieved       */
+  int       Kept;             /* Receivers still needed                  */
+  int       Distance;         /* Receivers attached after the oldest one */
+                              /* needed - 0 if it is the attached one    */
+  int       Saved;            /* Receivers saved (cumulative)            */
+  int       DeleteFailures;   /* Deletes that failed (cumulative)        */
+  int       Images;           /* Media images recorded by MEDIAIMG(*YES) */
+  long long OldestAge;        /* Seconds since the oldest entry needed   */
+  JrnTime   Cutoff;           /* The oldest entry needed ...             */
+  char      OldestRcv[10];    /* ... the receiver holding it ...         */
+  char      AttRcv[10];       /* ... and the attached receiver           */
+};
+
+/***************************************************************************/
+/*  HISTORY file for a queue manager - a header followed by a ring of      */
+/*  HIST_RECORDS fixed length records, one per check.  Once the ring is   */
+/*  full each record replaces the oldest, so the file never grows.        */
+/***************************************************************************/
+struct HistHeader {
+  char      Magic[8];         /* HIST_MAGIC                              */
+  int       RecordLen;        /* sizeof(struct HistRecord)               */
+  int       Capacity;         /* Records in the ring                     */
+  long long Written;          /* Records ever written - the next one     */
+                              /* goes in slot Written % Capacity         */
+  char      QmgrLib[10];
+  char      Reserved[22];
+};
+
+struct HistRecord {
+  JrnTime   Time;             /* When the check was made                 */
+  JrnTime   Cutoff;           /* Oldest journal entry needed             */
+  char      AttRcv[10];       /* Attached receiver                       */
+  char      OldestRcv[10];    /* Oldest receiver needed                  */
+  int       ChainLength;      /* Receivers in the chain                  */
+  int       Kept;             /* Receivers still needed                  */
+  int       Deleted;          /* Receivers deleted by this check         */
+  int       Retcode;          /* Result of the check                     */
+  long long PhaseMicros[NUM_PHASES];  /* Time taken by each PHASE_       */
+};
+
+/***************************************************************************/
+/*  Pacing of the deletes for a queue manager - DLTRATE, DLTPERMIN and     */
+/*  LOADPROBE.  Kept from one check to the next in resident mode, so the   */
+/*  pace it has settled on carries over.                                   */
+/***************************************************************************/
+struct DeletePacer {
+  int       Active;           /* Any of the three was given              */
+  int       Scale;            /* Budget used is 1/Scale of it - doubled  */
+                              /* when the system is busy, reduced by one */
+                              /* for each delete while it isn't          */
+  int       Busy;             /* The probe said busy before this delete  */
+  double    Tokens;           /* K that can be deleted without waiting   */
+  long long LastRefill;       /* When Tokens was last topped up          */
+  long long LastStart;        /* When the last delete started            */
+  long long UsualMicros;      /* Time a delete takes when it isn't busy  */
+  long long Deadline;         /* Leave the rest after this (0 - never)   */
+  long long WaitMicros;       /* Time spent waiting this time            */
+  int       Backoffs;         /* Times the pace was slowed this time     */
+  int       Deferred;         /* Receivers left for the next time        */
+};
+
+/***************************************************************************/
+/*  Maintenance of one queue manager - its settings and names, where its   */
+/*  output goes and the results of processing it.  This is the context     */
+/*  jrnmaint.h hands out.                                                  */
+/***************************************************************************/
+struct QmgrMaint {
+  struct JrnMaintConfig *pConfig;  /* Settings                           */
+  char    QmgrLib[10];        /* Blank padded Qmgr library name          */
+  char    szQmgrLib[11];      /* NULL terminated Qmgr lib. name          */
+  char    message_queue[20];  /* QMQMMSG in the Qmgr library             */
+  char    SavLib[10];         /* Library for receiver save files         */
+  int     retcode;            /* Result of processing this Qmgr          */
+  int     NumRcvrs;           /* Receivers in the chain                  */
+  int     SizeMult;           /* Multiplier for receiver sizes           */
+  int     deletecount;        /* Receivers deleted                       */
+  int     buffered;           /* Hold *PRINT output until finished?      */
+  char   *OutBuf;             /* Held output                             */
+  int     OutLen;
+  int     OutSize;
+  char    MsgBuf[MSG_TEXT_MAX];  /* *MSGQ lines not yet sent             */
+  int     MsgLen;
+  int     Cached;             /* Resident mode - Index etc. are set up   */
+  struct RcvIndex Index;      /* Receiver chain as last seen             */
+  struct JrnInf JrnInf;       /* AMQJRNINF contents as last loaded       */
+  int     Oldest;             /* Oldest receiver needed in Index         */
+  struct JrnInf LastJrnInf;   /* AMQJRNINF contents as last seen         */
+  char    LastAttRcv[10];     /* Attached receiver as last seen          */
+  char    LastOldest[10];     /* Oldest receiver needed as last reported */
+  struct DeleteResult *Deletes;  /* Outcome of each delete last time     */
+  int     NumDeletes;
+  int     DeletesSize;
+  char   *Plan;               /* PLAN_ for each receiver in the index    */
+  int     PlanSize;
+  int     Eligible;           /* Receivers planned to be deleted         */
+  int     AgeHeld;            /* Receivers only kept by MINAGE           */
+  struct QmgrMetrics Metrics; /* For the METRICS file                    */
+  struct HistHeader *pHist;   /* HISTORY file, mapped while it is open   */
+  int     HistFd;
+  int     HistDeleted;        /* deletecount when it was last recorded   */
+  char   *TraceBuf;           /* TRACE lines for this queue manager,     */
+  int     TraceLen;           /* written together when it is finished    */
+  int     TraceSize;
+  struct JrnMaintReceiver *PlanRcvrs;  /* Returned by JrnMaintPlan()     */
+  int     PlanRcvrsSize;
+  char    LastError[200];     /* Last error reported                     */
+  struct DeletePacer Pacer;   /* DLTRATE, DLTPERMIN and LOADPROBE        */
+  char    QmgrName[49];       /* Queue manager name, for MQMNAME - set   */
+                              /* by FindQmgrName() when it is needed     */
+};
+
+/***************************************************************************/
+/*  One queue manager's inputs and decisions, read back from a TRACE file  */
+/***************************************************************************/
+struct ReplayCase {
+  char    QmgrLib[10];
+  int     Line;               /* Line of the trace file it starts on     */
+  struct JrnInf JrnInf;       /* AMQJRNINF as captured                   */
+  Qjo_JN_Repeating_Key_1_Output_t *pChain;  /* Receiver chain as captured */
+  int     NumRcvrs;
+  int     Size;               /* Receivers allocated for                 */
+  int     Oldest;             /* Index of the oldest receiver needed     */
+  char    OldestRcv[10];
+  int     Deleting;           /* DLTRCV(*YES) or SAVRCV(*YES)            */
+  int     Retcode;            /* How the queue manager finished          */
+  char  (*Deleted)[10];       /* Receivers it tried to delete, in order  */
+  int     NumDeleted;
+  struct RetainPolicy Policy; /* Retention policy in effect, and the     */
+  JrnTime Now;                /* time it was applied                     */
+};
+
+/***************************************************************************/
+/*  ARCHIVE directory - a deduplicating store of receiver save files.      */
+/*  Each save file is cut into chunks where its content says to, so the    */
+/*  chunks of a receiver that repeats most of the one before are mostly    */
+/*  ones already stored.  Only new chunks are compressed and appended to   */
+/*  chunks.dat; the receiver is stored as its list of chunk numbers (its   */
+/*  recipe, in recipes.dat).  chunks.idx and receivers.idx are a header    */
+/*  followed by fixed length records, appended in order, and each file is  */
+/*  forced to disk before anything that refers to it is written.           */
+/***************************************************************************/
+struct ArcHeader {
+  char      Magic[8];         /* ARC_MAGIC                               */
+  int       RecordLen;        /* Length of the records that follow       */
+  char      Reserved[20];
+};
+
+struct ArcChunk {
+  unsigned long long Id[2];   /* 128 bit hash of the chunk's contents    */
+  long long Offset;           /* Where it is in chunks.dat               */
+  int       RawLen;           /* Length of the chunk                     */
+  int       StoredLen;        /* ... as stored - the same if it didn't   */
+                              /* compress                                */
+};
+
+struct ArcReceiver {
+  char      QmgrLib[10];      /* Queue manager library                   */
+  char      RcvName[10];      /* Receiver                                */
+  char      Reserved[4];
+  JrnTime   AttachTime;       /* When it was attached                    */
+  JrnTime   ArchiveTime;      /* When it was archived                    */
+  long long Length;           /* Save file length                        */
+  unsigned long long Checksum;  /* FNV-1a hash of the whole save file    */
+  long long Recipe;           /* First of its chunk numbers in           */
+  int       NumChunks;        /* recipes.dat, and how many               */
+  int       NewChunks;        /* Chunks it added to the archive          */
+  long long StoredBytes;      /* Bytes it added to chunks.dat            */
+};
+
+struct Archive {
+  char      Dir[257];         /* The ARCHIVE directory                   */
+  pthread_mutex_t Lock;       /* Serialises using the archive            */
+  int       Loaded;           /* The files below are (being) opened      */
+  int       LockFd;           /* archive.lck, locked while it is open    */
+  int       DataFd;           /* chunks.dat                              */
+  int       ChunkFd;          /* chunks.idx                              */
+  int       RecipeFd;         /* recipes.dat                             */
+  int       RcvFd;            /* receivers.idx                           */
+  long long DataLen;          /* Length of chunks.dat                    */
+  long long RecipeLen;        /* Chunk numbers in recipes.dat            */
+  struct ArcChunk *Chunks;    /* chunks.idx                              */
+  int       NumChunks;
+  int       ChunksSize;
+  int      *Hash;             /* Chunk number + 1 by Id, open addressing */
+  int       HashSize;         /* (a power of 2) - empty slots are 0      */
+  struct ArcReceiver *Rcvs;   /* receivers.idx                           */
+  int       NumRcvs;
+  int       RcvsSize;
+  unsigned long long Gear[256];  /* Chunk boundary hash of each byte     */
+};
+
+/***************************************************************************/
+/*  A new chunk to be compressed, and the threads compressing them         */
+/***************************************************************************/
+struct ArcJob {
+  unsigned char *pRaw;        /* The chunk ...                           */
+  int       RawLen;
+  unsigned char *pOut;        /* ... and room for it compressed          */
+  int       OutLen;           /* Compressed length, 0 if it didn't       */
+  int       Chunk;            /* Its chunk number                        */
+};
+
+struct ArcPool {
+  struct ArcJob *Jobs;
+  int       NumJobs;
+  int       Next;             /* Next job to be done                     */
+  pthread_mutex_t Lock;       /* Serialises Next                         */
+};
+
+/***************************************************************************/
+/*  Work shared by the threads saving and deleting receivers               */
+/***************************************************************************/
+struct SavePipe {
+  struct QmgrMaint *pQm;      /* Queue manager being processed           */
+  struct RcvIndex  *pIndex;   /* Its receivers                           */
+  int     Count;              /* Receivers [0, Count) are to be saved    */
+  int     Saved;              /* Receivers [0, Saved) have been saved    */
+  int     Failed;             /* The save of receiver Saved failed       */
+  int     Stop;               /* The deletes have stopped                */
+  char    ExceptionId[7];     /* Why the save failed                     */
+  int     NumSaved;           /* Saves done (not already saved)          */
+  long long SaveMicros;       /* Time taken by the saves                 */
+  long long MaxSaveMicros;    /* ... and by the longest one              */
+  int     ArchiveFailed;      /* The save failed adding it to ARCHIVE    */
+  int     ArchiveMismatch;    /* ... as it didn't read back the same     */
+  int     NumArchived;        /* Save files added to ARCHIVE ...         */
+  long long ArchivedBytes;    /* ... their length ...                    */
+  long long StoredBytes;      /* ... what they added to the archive ...  */
+  int     NewChunks;          /* ... as this many new chunks ...         */
+  int     TotalChunks;        /* ... of this many                        */
+  pthread_mutex_t Lock;       /* Serialises the above                    */
+  pthread_cond_t  Cond;       /* Signalled as each save completes        */
+};
+
+/***************************************************************************/
+/*  Work shared by the threads processing a list of queue managers         */
+/***************************************************************************/
+struct MaintPool {
+  struct QmgrMaint *pQmgrs;   /* Queue managers to process               */
+  int     NumQmgrs;
+  int     Next;               /* Next queue manager to be processed      */
+  pthread_mutex_t Lock;       /* Serialises Next                         */
+};
+
+/***************************************************************************/
+/*  Exit information passed to a Delete Journal Receiver exit program      */
+/*  (exit point QIBM_QJO_DLT_JRNRCV, format DRCV0100)                      */
+/***************************************************************************/
+struct DRCV0100 {
+  _INT4   Length;             /* Length of exit information              */
+  char    ExitPoint[20];      /* Exit point name                         */
+  char    Format[8];          /* Exit point format name                  */
+  char    RcvName[10];        /* Journal receiver being deleted          */
+  char    RcvLib[10];
+  char    JrnName[10];        /* Journal it is/was attached to           */
+  char    JrnLib[10];
+};
+
+#define EXIT_ELIGIBLE     '0' /* Exit program return code - delete it    */
+#define EXIT_NOT_ELIGIBLE '1' /* ... don't delete it                     */
+
+/***************************************************************************/
+/*  Delete Journal Receiver exit program - the receivers a queue manager   */
+/*  no longer needs, kept between calls and only worked out again when     */
+/*  the AMQJRNINF contents or the attached receiver change                 */
+/***************************************************************************/
+struct ExitCache {
+  struct QmgrMaint Qm;        /* The queue manager library               */
+  int     Valid;              /* Deletable is set up for ...             */
+  struct JrnInf JrnInf;       /* ... these AMQJRNINF contents            */
+  char    AttRcv[10];         /* ... and this attached receiver          */
+  char  (*Deletable)[10];     /* Hash set of receivers that can be       */
+                              /* deleted - empty slots are zeros         */
+  int     HashSize;           /* Slots in Deletable (a power of 2)       */
+  unsigned long LastUsed;     /* Exit.Clock when last asked about        */
+};
+
+/***************************************************************************/
+/*  A commit cycle that was open at the oldest journal entry needed        */
+/***************************************************************************/
+struct OpenCycle {
+  long long Id;               /* Commit cycle ID                         */
+  char    Job[26];            /* Job that started it                     */
+  JrnTime Started;
+  char    EndType[2];         /* CM or RB - blanks while it is open      */
+  char    EndRcv[10];         /* Receiver it ended in                    */
+  JrnTime Ended;
+};
+
+/***************************************************************************/
+/*  Receivers after the oldest entry needed, scanned by several threads    */
+/*  for the ends of the open commit cycles                                 */
+/***************************************************************************/
+struct PinScan {
+  struct QmgrMaint *pQm;
+  struct RcvIndex  *pIndex;
+  char    FromTime[17];       /* The oldest entry needed                 */
+  int     First;              /* Receiver holding it                     */
+  int     Next;               /* Next receiver to be scanned             */
+  int     Last;               /* The attached receiver                   */
+  struct OpenCycle *Cycles;   /* Open commit cycles, in ID order         */
+  int     NumCycles;
+  int     Failed;             /* A retrieve failed ...                   */
+  char    FailedRcv[10];      /* ... for this receiver                   */
+  char    ExceptionId[7];
+  pthread_mutex_t Lock;       /* Serialises Next and the cycle ends      */
+};
+
+/***************************************************************************/
+/*  Function prototypes                                                    */
+/***************************************************************************/
+static int GetReceiverChain(struct QmgrMaint *pQm, int *NumRcvrs,
+                            char **ppJrnData,
+                            Qjo_JN_Repeating_Key_1_Output_t **ppRcvDirectory);
+static void output_detail(struct QmgrMaint *pQm, char *print_buffer);
+static void output_error(struct QmgrMaint *pQm, char *print_buffer);
+static void output_config(struct JrnMaintConfig *pConfig,
+                          char *print_buffer);
+static void output_config_error(struct JrnMaintConfig *pConfig,
+                                char *print_buffer);
+static void HoldOutput(struct QmgrMaint *pQm, char *print_buffer);
+static void FlushOutput(struct QmgrMaint *pQm);
+static void SendMessages(struct QmgrMaint *pQm);
+static void SetLogClock(void);
+static void LogTime(char *HHMMSS);
+static long long LocalSeconds(void);
+static long long CivilSeconds(int Year, int Month, int Day, int Hour,
+                              int Minute, int Second);
+static int Digits(char *Text, int Length);
+static void RecordCutoff(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                         int oldestReceiverIndex, struct JrnInf *pJrnInf);
+static int WriteMetrics(struct JrnMaintConfig *pConfig,
+                        struct QmgrMaint *pQmgrs, int NumQmgrs,
+                        long long StartupMicros, long long RunMicros);
+static void WriteMetric(FILE *fp, struct QmgrMaint *pQmgrs, int NumQmgrs,
+                        char *Name, char *Help, size_t Offset);
+static int MaintainQmgr(struct QmgrMaint *pQm);
+static int ReadJrnInf(struct QmgrMaint *pQm, struct JrnInf *pJrnInf);
+static JrnTime JrnInfTime(struct JrnInf *pJrnInf);
+static JrnTime RcvAttachTime(char *CYYMMDDHHMMSS);
+static void FormatJrnTime(JrnTime Time, int Millis, char *Text);
+static int GetAttachedReceiver(struct QmgrMaint *pQm, char *AttRcvName);
+static int ProcessEligible(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                           int oldestReceiverIndex, int *pDeleteCount);
+static int DeleteReceivers(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                           int oldestReceiverIndex, int *pDeleteCount);
+static int StartDeletes(struct QmgrMaint *pQm, int Count);
+static int DeleteReceiver(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                          int Entry);
+static void EndDeletes(struct QmgrMaint *pQm);
+static int PaceDelete(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                      int Entry);
+static void PaceDeleted(struct QmgrMaint *pQm);
+static void SlowPace(struct QmgrMaint *pQm, char *Reason);
+static void DeferDeletes(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                         int Entry, int Count);
+static int SaveAndDeleteReceivers(struct QmgrMaint *pQm,
+                                  struct RcvIndex *pIndex,
+                                  int oldestReceiverIndex, int *pDeleteCount);
+static void *SaveWorker(void *pArg);
+static int RefreshQmgr(struct QmgrMaint *pQm);
+static void *MaintWorker(void *pArg);
+static int ReadMqsIni(struct JrnMaintConfig *pConfig,
+                      struct QmgrMaint **ppQmgrs, int *pNumQmgrs);
+static int AddQmgr(struct JrnMaintConfig *pConfig, struct QmgrMaint **ppQmgrs,
+                   int *pNumQmgrs, int *pMaxQmgrs, char *LibName, int LibLen);
+static void InitQmgr(struct JrnMaintConfig *pConfig, struct QmgrMaint *pQm,
+                     char *LibName, int LibLen);
+static void FreeQmgr(struct QmgrMaint *pQm);
+static int BuildReceiverIndex(Qjo_JN_Repeating_Key_1_Output_t *pRcvDirectory,
+                              int NumRcvrs, struct RcvIndex *pIndex);
+static void FreeReceiverIndex(struct RcvIndex *pIndex);
+static int SyncReceiverIndex(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                             Qjo_JN_Repeating_Key_1_Output_t *pRcvDirectory,
+                             int NumRcvrs);
+static void RemoveOldestReceivers(struct RcvIndex *pIndex, int Count);
+static int GrowReceiverIndex(struct RcvIndex *pIndex, int NumRcvrs);
+static void SetIndexEntry(struct RcvIndex *pIndex, int Entry,
+                          Qjo_JN_Repeating_Key_1_Output_t *pRcvr);
+static int FindOldestNeeded(struct RcvIndex *pIndex, JrnTime Cutoff);
+static void ReportReceivers(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                            int oldestReceiverIndex);
+static void AnalyseJournal(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                           int oldestReceiverIndex);
+static int ChangeJournal(struct QmgrMaint *pQm);
+static int RecordPinnedImages(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                              int oldestReceiverIndex, struct JrnInf *pJrnInf,
+                              int *pDeleteCount);
+static void FindQmgrName(struct QmgrMaint *pQm);
+static void FindPinning(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                        int oldestReceiverIndex, struct JrnInf *pJrnInf);
+static int FindOldestEntry(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                           int oldestReceiverIndex, struct JrnInf *pJrnInf,
+                           struct PlatJrnEntry *pEntry, int *pEntryRcv);
+static void *PinWorker(void *pArg);
+static int CompareCycles(const void *p1, const void *p2);
+static JrnTime EntryTime(char *Time);
+static void FormatJob(char *Job, char *Text);
+static void FormatObject(char *Object, char *Text);
+static struct ExitCache *FindExitCache(char *QmgrLib);
+static void DropExitCache(struct ExitCache *pCache);
+static int RefreshExitCache(struct ExitCache *pCache, struct JrnInf *pJrnInf,
+                            char *AttRcvName);
+static unsigned int HashReceiver(char *RcvName);
+static int IsDeletable(struct ExitCache *pCache, char *RcvName);
+static void ForecastAsp(struct QmgrMaint *pQm, double WriteRateK);
+static void FormatInterval(long long Seconds, char *Text);
+static int OpenHistory(struct QmgrMaint *pQm, int Create);
+static void CloseHistory(struct QmgrMaint *pQm);
+static void WriteHistory(struct QmgrMaint *pQmgrs, int NumQmgrs);
+static void AppendHistory(struct QmgrMaint *pQm);
+static int QueryHistory(struct QmgrMaint *pQm, int WindowHours);
+static void TraceLine(struct QmgrMaint *pQm, char *Line);
+static void TraceInputs(struct QmgrMaint *pQm, struct JrnInf *pJrnInf,
+                        Qjo_JN_Repeating_Key_1_Output_t *pRcvDirectory,
+                        int NumRcvrs);
+static void TraceDecision(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                          int oldestReceiverIndex);
+static void WriteTrace(struct QmgrMaint *pQm, int retcode, int deletecount);
+static int ReadReplayCases(struct JrnMaintConfig *pConfig, FILE *fp,
+                           struct ReplayCase **ppCases, int *pNumCases);
+static int CheckReplayCase(struct JrnMaintConfig *pConfig,
+                           struct ReplayCase *pCase, struct RcvIndex *pIndex,
+                           char *Plan);
+static void FreeReplayCases(struct ReplayCase *pCases, int NumCases);
+static int AddProtect(char *Value, struct RetainPolicy *pPolicy);
+static int PlanDeletes(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                       int oldestReceiverIndex);
+static int ClassifyReceivers(struct RetainPolicy *pPolicy,
+                             struct RcvIndex *pIndex, int oldestReceiverIndex,
+                             JrnTime Now, char *Plan);
+static int IsProtected(struct RetainPolicy *pPolicy, char *RcvName);
+static char *PlanReason(char Plan);
+static void ReportHeld(struct QmgrMaint *pQm, int oldestReceiverIndex);
+static void TracePolicy(struct QmgrMaint *pQm, JrnTime Now);
+static void RemoveDeletedReceivers(struct QmgrMaint *pQm,
+                                   struct RcvIndex *pIndex);
+static int LoadArchive(struct JrnMaintConfig *pConfig, 
+                       struct Archive *pArc);
+static void UnloadArchive(struct Archive *pArc);
+static int LoadArchiveIndex(int fd, int RecordLen, void **ppRecords, int *pNum,
+                            int *pSize);
+static int FindArchived(struct Archive *pArc, char *QmgrLib, char *RcvName,
+                        JrnTime AttachTime);
+static int ArchiveSaveFile(struct SavePipe *pPipe, int Entry,
+                           Qus_EC_t *pErrorData);
+static int ArchiveReceiver(struct JrnMaintConfig *pConfig,
+                           struct Archive *pArc, char *Path,
+                           struct ArcReceiver *pRcv, int *pMismatch);
+static int StoreChunks(struct Archive *pArc, struct ArcJob *Jobs, int NumJobs,
+                       struct ArcReceiver *pRcv);
+static void *ArcWorker(void *pArg);
+static int RestoreReceiver(struct QmgrMaint *pQm, char *RcvName);
+static int ReadArchived(struct Archive *pArc, struct ArcReceiver *pRcv, int fd,
+                        long long *pLength, unsigned long long *pChecksum);
+static int ChunkLength(struct Archive *pArc, unsigned char *pData, int Length);
+static void ChunkId(unsigned char *pData, int Length, unsigned long long *Id);
+static unsigned long long Fnv64(unsigned long long Hash, unsigned char *pData,
+                                int Length);
+static int FindChunk(struct Archive *pArc, unsigned long long *Id, int RawLen);
+static int AddChunk(struct Archive *pArc, unsigned long long *Id, int RawLen);
+static void HashChunk(struct Archive *pArc, int Chunk);
+static int LzCompress(unsigned char *In, int InLen, unsigned char *Out);
+static int LzExpand(unsigned char *In, int InLen, unsigned char *Out,
+                    int OutLen);
+static int WriteAt(int fd, void *pData, long long Length, long long Offset);
+
+/***************************************************************************/
+/*  Static storage, private to this file - the log clock, only set once,   */
+/*  the lock serialising output, and the exit program's cache, which only  */
+/*  JournalExit() uses, under its lock.  Everything else a run needs is in */
+/*  its JrnMaintConfig and queue manager contexts.                         */
+/***************************************************************************/
+static long long LogBaseSeconds;  /* Local time at startup (CivilSeconds) */
+static long long LogBaseMicros;   /* PlatMicroseconds() at startup        */
+static pthread_once_t LogClockOnce = PTHREAD_ONCE_INIT;
+static pthread_mutex_t OutputLock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct {
+  pthread_mutex_t Lock;       /* Serialises the calls                    */
+  struct JrnMaintConfig Config;  /* Settings of the contexts below       */
+  int     NumCaches;          /* Slots of Caches in use                  */
+  unsigned long Clock;        /* Orders the slots' use                   */
+  struct ExitCache Caches[MAX_EXIT_QMGRS];
+} Exit = {PTHREAD_MUTEX_INITIALIZER};
+
+
+/***************************************************************************/
+/* Function:  JrnMaintInitConfig()                                         */
+/*                                                                         */
+/* Description: The MQJRNMNT defaults - report only, to stdout, with a     */
+/*              line per receiver                                          */
+/*                                                                         */
+/***************************************************************************/
+void JrnMaintInitConfig(struct JrnMaintConfig *pConfig)
+{
+  InitLogClock();
+
+  memset(pConfig, 0, sizeof(struct JrnMaintConfig));
+  pConfig->PrintOutput = TRUE;
+  pConfig->LogLevel = LOG_RECEIVER;
+  memcpy(pConfig->SaveLibrary, "*QMGRLIB  ", 10);
+  pConfig->AspThreshold = 90;
+  pConfig->MaxImages = 10;
+  pthread_mutex_init(&pConfig->TraceLock, NULL);
+}
+
+/***************************************************************************/
+/* Function:  RunOnce()                                                    */
+/*                                                                         */
+/* Description: MODE(*ONCE) - process each queue manager once             */
+/*                                                                         */
+/***************************************************************************/
+int RunOnce(struct JrnMaintConfig *pConfig, struct QmgrMaint *pQmgrs,
+            int NumQmgrs, int NumThreads, long long StartMicros,
+            long long StartupMicros)
+{
+  int             retcode = OK,
+  count = 0, 
+  NumStarted = 0,
+  failcount = 0,
+  deletecount = 0;
+  char            print_buffer[200];
+  struct MaintPool Pool;
+  pthread_t       Threads[MAX_THREADS];
+
+  /*************************************************************************/
+  /* With a single queue manager just process it here...                   */
+  /*************************************************************************/
+  if (NumQmgrs == 1) {
+    retcode = MaintainQmgr(&pQmgrs[0]);
+    FlushOutput(&pQmgrs[0]);
+    WriteMetrics(pConfig, pQmgrs, NumQmgrs, StartupMicros, 
+                 PlatMicroseconds() - StartMicros);
+    WriteHistory(pQmgrs, NumQmgrs);
+    return retcode;
+  };
+
+  /*************************************************************************/
+  /* ...otherwise process them on a pool of threads, each taking the next  */
+  /* queue manager from the list when it finishes one, so a slow queue     */
+  /* manager does not hold up the others.  Output is held per queue        */
+  /* manager and printed as a block when it finishes.  This thread works   */
+  /* on the list too, so if threads can't be started in this job (it      */
+  /* must be able to run multiple threads) the list is processed serially. */
+  /*************************************************************************/
+  sprintf(print_buffer, "Processing %d queue managers, up to %d at a time",
+          NumQmgrs, NumThreads);
+  output_config(pConfig, print_buffer);
+
+  for (count = 0; count < NumQmgrs; count++) {
+    pQmgrs[count].buffered = pConfig->PrintOutput;
+  };
+
+  Pool.pQmgrs = pQmgrs;
+  Pool.NumQmgrs = NumQmgrs;
+  Pool.Next = 0;
+  pthread_mutex_init(&Pool.Lock, NULL);
+
+  if (NumThreads > MAX_THREADS) NumThreads = MAX_THREADS;
+  if (NumThreads > NumQmgrs) NumThreads = NumQmgrs;
+  for (NumStarted = 0; NumStarted < NumThreads - 1; NumStarted++) {
+    if (pthread_create(&Threads[NumStarted], NULL, MaintWorker, &Pool)) {
+      sprintf(print_buffer, "WARNING - only %d thread(s) could be started",
+              NumStarted + 1);
+      output_config(pConfig, print_buffer);
+      break;
+    };
+  };
+
+  MaintWorker(&Pool);
+
+  for (count = 0; count < NumStarted; count++) {
+    pthread_join(Threads[count], NULL);
+  };
+  pthread_mutex_destroy(&Pool.Lock);
+
+  /*************************************************************************/
+  /*  Aggregate the results                                                */
+  /*************************************************************************/
+  for (count = 0; count < NumQmgrs; count++) {
+    deletecount += pQmgrs[count].deletecount;
+    if (pQmgrs[count].retcode != OK) {
+      failcount++;
+      if (retcode == OK) retcode = pQmgrs[count].retcode;
+    };
+  };
+
+  sprintf(print_buffer, 
+          "JrnMaint finished - %d queue manager(s) processed, %d failed, "
+          "%d receiver(s) have been deleted.", 
+          NumQmgrs, failcount, deletecount);
+  output_config(pConfig, print_buffer);
+
+  WriteMetrics(pConfig, pQmgrs, NumQmgrs, StartupMicros, 
+               PlatMicroseconds() - StartMicros);
+  WriteHistory(pQmgrs, NumQmgrs);
+  return retcode;
+}
+
+/***************************************************************************/
+/* Function:  RunQuery()                                                   */
+/*                                                                         */
+/* Description: MODE(*HISTORY) - only report on the history files          */
+/*                                                                         */
+/***************************************************************************/
+int RunQuery(struct QmgrMaint *pQmgrs, int NumQmgrs, int WindowHours)
+{
+  int   retcode = OK,
+  count;
+
+  for (count = 0; count < NumQmgrs; count++) {
+    if (QueryHistory(&pQmgrs[count], WindowHours) != OK) {
+      retcode = ERR_HISTORY_FILE;
+    };
+    FlushOutput(&pQmgrs[count]);
+  };
+  return retcode;
+}
+
+/***************************************************************************/
+/* Function:  RunRestore()                                                 */
+/*                                                                         */
+/* Description: MODE(*RESTORE) - write a receiver's save file back out of  */
+/*              the archive                                                */
+/*                                                                         */
+/***************************************************************************/
+int RunRestore(struct QmgrMaint *pQmgrs, int NumQmgrs, char *RcvName)
+{
+  int   retcode = OK,
+  count;
+
+  for (count = 0; count < NumQmgrs; count++) {
+    if (RestoreReceiver(&pQmgrs[count], RcvName) != OK) {
+      retcode = ERR_ARCHIVE;
+    };
+    FlushOutput(&pQmgrs[count]);
+  };
+  return retcode;
+}
+
+
+/***************************************************************************/
+/* Function:  MaintWorker()                                                */
+/*                                                                         */
+/* Description: Thread body - process queue managers from the pool until   */
+/*              there are none left                                        */
+/*                                                                         */
+/***************************************************************************/
+static void *MaintWorker(void *pArg)
+{
+  struct MaintPool *pPool = (struct MaintPool*)pArg;
+  struct QmgrMaint *pQm;
+
+  for (;;) {
+    pthread_mutex_lock(&pPool->Lock);
+    pQm = (pPool->Next < pPool->NumQmgrs) ? &pPool->pQmgrs[pPool->Next++] : 0;
+    pthread_mutex_unlock(&pPool->Lock);
+
+    if (! pQm) break;
+
+    MaintainQmgr(pQm);
+    FlushOutput(pQm);
+  };
+  return NULL;
+}
+
+
+/***************************************************************************/
+/* Function:  MaintainQmgr()                                               */
+/*                                                                         */
+/* Description: Journal maintenance for one queue manager - find the       */
+/*              oldest receiver it needs and (optionally) delete the ones  */
+/*              older than that                                            */
+/*                                                                         */
+/***************************************************************************/
+static int MaintainQmgr(struct QmgrMaint *pQm)
+{
+  int             retcode = OK,
+  imagercode,
+  NumRcvrs = 0, 
+  deletecount = 0,
+  oldestReceiverIndex = -1;
+  char            print_buffer[200],
+  TimeText[24],
+  *JrnData = 0;        /* Buffer returned by GetReceiverChain */
+  JrnTime         Cutoff;
+  Qjo_JN_Repeating_Key_1_Output_t   *pRcvDirectory = 0;
+  struct RcvIndex RcvIndex = {0, 0, 0, 0, 0, 0, 0};
+  struct JrnInf   OldestJrnEntry;
+  long long      *pPhase = pQm->Metrics.PhaseMicros,
+  startTime;
+
+  if (pQm->pConfig->TraceFp) {
+    PlatLocalTime(TimeText);
+    sprintf(print_buffer, "Q %-10.10s %c %17.17s", pQm->QmgrLib,
+            pQm->pConfig->DeleteReceivers || pQm->pConfig->SaveReceivers ?
+            'Y' : 'N', TimeText);
+    TraceLine(pQm, print_buffer);
+  };
+
+  /*************************************************************************/
+  /* Check queue manager library exists                                    */
+  /*************************************************************************/
+  startTime = PlatMicroseconds();
+  retcode = PlatCheckLibrary(pQm->QmgrLib);
+  pPhase[PHASE_CHKOBJ] = PlatMicroseconds() - startTime;
+  if (retcode) {                        /* Check library exists */
+    sprintf(print_buffer, "ERROR: Queue manager library %1.10s not found",
+            pQm->szQmgrLib );
+    output_error(pQm, print_buffer);
+    retcode = ERR_QMGR_LIB_NOT_FOUND;
+    pQm->retcode = retcode;
+    WriteTrace(pQm, retcode, 0);
+    return retcode;
+  }
+
+  /*************************************************************************/
+  /* CHGJRN(*YES) - attach a new receiver first, so the receiver that was  */
+  /* attached stops growing and can be deleted as soon as the queue       */
+  /* manager no longer needs it, rather than waiting for it to fill        */
+  /*************************************************************************/
+  if ( pQm->pConfig->ChangeJournal == TRUE ) {
+    retcode = ChangeJournal(pQm);
+    if (retcode != OK) {
+      pQm->retcode = retcode;
+      WriteTrace(pQm, retcode, 0);
+      return retcode;
+    };
+  };
+
+  /*************************************************************************/
+  /* Get the timestamp of the oldest jrn entry from the AMQJRNINF *USRSPC  */
+  /* - if we didn't find the user space we can't go any further.           */
+  /*************************************************************************/
+  startTime = PlatMicroseconds();
+  retcode = ReadJrnInf(pQm, &OldestJrnEntry);
+  pPhase[PHASE_USRSPC] = PlatMicroseconds() - startTime;
+  if (retcode != OK) {
+    pQm->retcode = retcode;
+    WriteTrace(pQm, retcode, 0);
+    return retcode;
+  };
+  Cutoff = JrnInfTime(&OldestJrnEntry);
+
+  /*************************************************************************/
+  /* Issue call to get the receiver chain.  pRcvDirectory points into the  */
+  /* JrnData buffer returned by the API, so the chain is not copied again  */
+  /*************************************************************************/
+  startTime = PlatMicroseconds();
+  retcode = GetReceiverChain(pQm, &NumRcvrs, &JrnData, &pRcvDirectory);
+  pPhase[PHASE_CHAIN] = PlatMicroseconds() - startTime;
+  pQm->NumRcvrs = NumRcvrs;
+
+  /*************************************************************************/
+  /* If we got the data OK, build the compact index of the chain           */
+  /*************************************************************************/
+  startTime = PlatMicroseconds();
+  if (retcode == OK) {
+    retcode = BuildReceiverIndex(pRcvDirectory, NumRcvrs, &RcvIndex);
+    if (retcode != OK) {
+      output_error(pQm, "ERROR: Memory allocation error (RcvIndex)");
+    };
+  };
+
+  if (retcode == OK) {
+
+    if (pQm->pConfig->TraceFp) {
+      TraceInputs(pQm, &OldestJrnEntry, pRcvDirectory, NumRcvrs);
+    };
+
+    FormatJrnTime(Cutoff, TRUE, TimeText);
+    sprintf(print_buffer, "Timestamp of oldest journal entry: (%s)", 
+            TimeText);
+    output(pQm, print_buffer);
+
+    /***********************************************************************/
+    /* Find the newest receiver attached BEFORE the oldest journal entry.  */
+    /* That receiver contains the entry, so it is the oldest one we need   */
+    /* to keep and every receiver older than it can be deleted.            */
+    /***********************************************************************/
+    oldestReceiverIndex = FindOldestNeeded(&RcvIndex, Cutoff);
+    RecordCutoff(pQm, &RcvIndex, oldestReceiverIndex, &OldestJrnEntry);
+    if (pQm->pConfig->TraceFp) {
+      TraceDecision(pQm, &RcvIndex, oldestReceiverIndex);
+    };
+
+    /***********************************************************************/
+    /* ...and apply the retention policy to the receivers older than it    */
+    /***********************************************************************/
+    retcode = PlanDeletes(pQm, &RcvIndex, oldestReceiverIndex);
+  };
+
+  if (retcode == OK) {
+    ReportReceivers(pQm, &RcvIndex, oldestReceiverIndex);
+    pPhase[PHASE_SCAN] = PlatMicroseconds() - startTime;
+
+    if ( pQm->pConfig->AnalyseJournal == TRUE ) {
+      AnalyseJournal(pQm, &RcvIndex, oldestReceiverIndex);
+    };
+
+    if ( pQm->pConfig->FindPinning == TRUE ) {
+      FindPinning(pQm, &RcvIndex, oldestReceiverIndex, &OldestJrnEntry);
+    };
+
+    startTime = PlatMicroseconds();
+    retcode = ProcessEligible(pQm, &RcvIndex, oldestReceiverIndex,
+                              &deletecount);
+
+    /***********************************************************************/
+    /* MEDIAIMG(*YES) - then record the images holding the oldest          */
+    /* receiver back, and delete what each one releases.  A failed delete */
+    /* doesn't stop it, but is still the result.                           */
+    /***********************************************************************/
+    if ( pQm->pConfig->MediaImages == TRUE &&
+         ( retcode == OK || retcode == ERR_DELETE_FAILED ) ) {
+      imagercode = RecordPinnedImages(pQm, &RcvIndex, oldestReceiverIndex,
+                                      &OldestJrnEntry, &deletecount);
+      if (retcode == OK) retcode = imagercode;
+    };
+    pPhase[PHASE_DELETE] = PlatMicroseconds() - startTime;
+  };
+
+  /*************************************************************************/
+  /*  Finished - Free the receiver chain buffer if it was allocated        */
+  /*************************************************************************/
+  sprintf(print_buffer, 
+          "JrnMaint finished - %d receiver(s) have been deleted.", 
+          deletecount);
+  output(pQm, print_buffer);
+
+  WriteTrace(pQm, retcode, deletecount);
+  FreeReceiverIndex(&RcvIndex);
+  if (JrnData) {
+    free(JrnData);
+  }
+  if (pQm->Deletes) {
+    free(pQm->Deletes);
+    pQm->Deletes = 0;
+  };
+  if (pQm->Plan) {
+    free(pQm->Plan);
+    pQm->Plan = 0;
+    pQm->PlanSize = 0;
+  };
+
+  pQm->deletecount = deletecount;
+  pQm->retcode = retcode;
+  return retcode;
+}
+
+
+/***************************************************************************/
+/* Function:  ReadJrnInf()                                                 */
+/*                                                                         */
+/* Description: Read the AMQJRNINF user space in the queue manager library */
+/*              through a pointer to the space, rather than having         */
+/*              QUSRTVUS copy it.  The queue manager updates the space     */
+/*              while it runs, so the timestamp is taken from a copy that  */
+/*              was the same on two reads in a row, and the copy is        */
+/*              checked before it is used to work out the cutoff.          */
+/*                                                                         */
+/***************************************************************************/
+static int ReadJrnInf(struct QmgrMaint *pQm, struct JrnInf *pJrnInf)
+{
+  char            print_buffer[200],
+  AmqJrnIinfUsrSpc[20],
+  *pSpace = 0,
+  *p;
+  struct JrnInf   Check;
+  int             count;
+  Qus_EC_t        ErrorData;
+
+  memcpy(AmqJrnIinfUsrSpc, SPC_NAME, 10);         /* Setup user space name */
+  memcpy( &(AmqJrnIinfUsrSpc[10]), pQm->QmgrLib, 10);
+
+  ErrorData.Bytes_Available = 0;
+  ErrorData.Bytes_Provided =  sizeof(Qus_EC_t);
+  PlatPointToUserSpace( AmqJrnIinfUsrSpc, &pSpace, &ErrorData);
+
+  if ( ErrorData.Bytes_Available != OK || ! pSpace) {
+    sprintf(print_buffer, 
+            "ERROR: Journal user space (%s) not found in library %s.  "
+            "Error code: %7.7s", SPC_NAME, pQm->szQmgrLib, 
+            ErrorData.Exception_Id);
+    output_error(pQm, print_buffer);
+    return ERR_USER_SPACE_MISSING;
+  };
+
+  /*************************************************************************/
+  /* The space names the journal it describes - make sure it is this       */
+  /* library's AMQAJRN before trusting the timestamp                       */
+  /*************************************************************************/
+  if (memcmp(pSpace, JRN_NAME, 10) ||
+      memcmp(pSpace + 10, pQm->QmgrLib, 10)) {
+    sprintf(print_buffer, 
+            "ERROR: Journal user space (%s) in library %s is for journal "
+            "%10.10s/%10.10s", SPC_NAME, pQm->szQmgrLib, pSpace + 10, pSpace);
+    output_error(pQm, print_buffer);
+    return ERR_USER_SPACE_INVALID;
+  };
+
+  memcpy(pJrnInf, pSpace, sizeof(struct JrnInf));
+  for (count = 0; count < 3; count++) {
+    memcpy(&Check, pSpace, sizeof(struct JrnInf));
+    if (! memcmp(&Check, pJrnInf, sizeof(struct JrnInf))) break;
+    memcpy(pJrnInf, &Check, sizeof(struct JrnInf));
+  };
+
+  for (p = pJrnInf->CC; p < (char*)(pJrnInf + 1); p++) {
+    if (! isdigit((unsigned char)*p) || count == 3) {
+      sprintf(print_buffer, 
+              "ERROR: Journal user space (%s) in library %s has no valid "
+              "timestamp", SPC_NAME, pQm->szQmgrLib);
+      output_error(pQm, print_buffer);
+      return ERR_USER_SPACE_INVALID;
+    };
+  };
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  JrnInfTime()                                                 */
+/*                                                                         */
+/* Description: The AMQJRNINF timestamp, to the millisecond.  It holds the */
+/*              full four digit year.                                      */
+/*                                                                         */
+/***************************************************************************/
+static JrnTime JrnInfTime(struct JrnInf *pJrnInf)
+{
+  return CivilSeconds(Digits(pJrnInf->CC, 2) * 100 + Digits(pJrnInf->YY, 2),
+                      Digits(pJrnInf->MM, 2), Digits(pJrnInf->DD, 2),
+                      Digits(pJrnInf->HH, 2), Digits(pJrnInf->mm, 2),
+                      Digits(pJrnInf->SS, 2)) * 1000 + 
+         Digits(pJrnInf->mmm, 3);
+}
+
+/***************************************************************************/
+/* Function:  RcvAttachTime()                                              */
+/*                                                                         */
+/* Description: A receiver attach time, CYYMMDDHHMMSS where C is 0 for     */
+/*              19YY, 1 for 20YY and so on.  The API only gives the time   */
+/*              to the second, so this is the start of that second.        */
+/*                                                                         */
+/***************************************************************************/
+static JrnTime RcvAttachTime(char *CYYMMDDHHMMSS)
+{
+  char *p = CYYMMDDHHMMSS;
+
+  return CivilSeconds(1900 + Digits(p, 1) * 100 + Digits(p + 1, 2),
+                      Digits(p + 3, 2), Digits(p + 5, 2),
+                      Digits(p + 7, 2), Digits(p + 9, 2),
+                      Digits(p + 11, 2)) * 1000;
+}
+
+/***************************************************************************/
+/* Function:  FormatJrnTime()                                              */
+/*                                                                         */
+/* Description: Format a time as YYYY-MM-DD HH:MM:SS, followed by .mmm if  */
+/*              Millis is TRUE.  Text must have room for 24 characters.    */
+/*                                                                         */
+/***************************************************************************/
+static void FormatJrnTime(JrnTime Time, int Millis, char *Text)
+{
+  long long days,
+  secs;
+  int   era,
+  doe,
+  yoe,
+  doy,
+  mp,
+  year,
+  month,
+  day;
+
+  days = Time / 86400000;
+  if (Time < 0 && Time % 86400000) days--;
+  secs = (Time - days * 86400000) / 1000;
+
+  /*************************************************************************/
+  /* The inverse of CivilSeconds()                                         */
+  /*************************************************************************/
+  days += 719468;
+  era = (int)((days >= 0 ? days : days - 146096) / 146097);
+  doe = (int)(days - (long long)era * 146097);
+  yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  mp = (5 * doy + 2) / 153;
+  day = doy - (153 * mp + 2) / 5 + 1;
+  month = mp < 10 ? mp + 3 : mp - 9;
+  year = yoe + era * 400 + (month <= 2);
+
+  sprintf(Text, "%04d-%02d-%02d %02d:%02d:%02d", year, month, day,
+          (int)(secs / 3600), (int)(secs / 60 % 60), (int)(secs % 60));
+  if (Millis) {
+    sprintf(Text + 19, ".%03d", (int)(((Time % 1000) + 1000) % 1000));
+  };
+}
+
+/***************************************************************************/
+/* Function:  RecordCutoff()                                               */
+/*                                                                         */
+/* Description: Note the counters that describe where the cutoff falls -   */
+/*              how many receivers are kept, how far the oldest one needed */
+/*              is behind the attached receiver and how old the oldest     */
+/*              entry needed is.  A distance or age that keeps growing     */
+/*              means a long running transaction is pinning the journal.   */
+/*                                                                         */
+/***************************************************************************/
+static void RecordCutoff(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                         int oldestReceiverIndex, struct JrnInf *pJrnInf)
+{
+  int   eligible = oldestReceiverIndex > 0 ? oldestReceiverIndex : 0;
+
+  pQm->Metrics.Kept = pIndex->Count - eligible;
+  pQm->Metrics.Distance = pIndex->Count - 1 - eligible;
+  if (pQm->Metrics.Distance < 0) pQm->Metrics.Distance = 0;
+  pQm->Metrics.OldestAge = LocalSeconds() - JrnInfTime(pJrnInf) / 1000;
+  pQm->Metrics.Cutoff = JrnInfTime(pJrnInf);
+  if (pIndex->Count > 0) {
+    memcpy(pQm->Metrics.OldestRcv, pIndex->Name[eligible], 10);
+    memcpy(pQm->Metrics.AttRcv, pIndex->Name[pIndex->Count - 1], 10);
+  };
+}
+
+/***************************************************************************/
+/* Function:  ParseProtect()                                               */
+/*                                                                         */
+/* Description: Set the receivers protected by the PROTECT parameter in    */
+/*              the retention policy of pConfig                            */
+/*                                                                         */
+/***************************************************************************/
+int ParseProtect(struct JrnMaintConfig *pConfig, char *Parm)
+{
+  char  Values[MAX_PROTECT][21],
+  Value[22],
+  print_buffer[100];
+  int   NumValues,
+  count;
+
+  NumValues = PlatGetListParm(Parm, MAX_PROTECT, 21, (char*)Values);
+  for (count = 0; count < NumValues; count++) {
+    memcpy(Value, Values[count], 21);
+    Value[21] = '\0';
+    if (! memcmp(Value, "*NONE", 5)) continue;
+    if (AddProtect(Value, &pConfig->Policy) != OK) {
+      sprintf(print_buffer, "ERROR: PROTECT(%s) is not a receiver name, "
+              "generic name or range of receivers", Value);
+      output_config_error(pConfig, print_buffer);
+      return ERR_ARGUMENTS_ERROR;
+    };
+  };
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  AddProtect()                                                 */
+/*                                                                         */
+/* Description: Add one PROTECT value to the policy - a receiver name      */
+/*              (AMQA000123), a generic name (AMQA0001*) or a range of     */
+/*              receivers (AMQA000100-AMQA000199)                          */
+/*                                                                         */
+/***************************************************************************/
+static int AddProtect(char *Value, struct RetainPolicy *pPolicy)
+{
+  struct ProtectRange *pRange;
+  char *pDash;
+  int   len,
+  count;
+
+  for (len = strlen(Value); len > 0 && Value[len - 1] == ' '; len--);
+  if (len == 0) return OK;
+  if (pPolicy->NumProtect == MAX_PROTECT) return ERR_ARGUMENTS_ERROR;
+
+  pRange = &pPolicy->Protect[pPolicy->NumProtect];
+  memset(pRange, ' ', 20);
+  pRange->Generic = 0;
+  pDash = memchr(Value, '-', len);
+
+  if (pDash) {
+    if (pDash - Value < 1 || pDash - Value > 10 || 
+        len - (pDash - Value) - 1 < 1 || len - (pDash - Value) - 1 > 10)
+      return ERR_ARGUMENTS_ERROR;
+    memcpy(pRange->First, Value, pDash - Value);
+    memcpy(pRange->Last, pDash + 1, len - (pDash - Value) - 1);
+  }
+  else if (Value[len - 1] == '*') {
+    if (len < 2 || len > 10) return ERR_ARGUMENTS_ERROR;
+    pRange->Generic = len - 1;
+    memcpy(pRange->First, Value, len - 1);
+  }
+  else {
+    if (len > 10) return ERR_ARGUMENTS_ERROR;
+    memcpy(pRange->First, Value, len);
+    memcpy(pRange->Last, Value, len);
+  };
+
+  for (count = 0; count < 10; count++) {
+    pRange->First[count] = toupper(pRange->First[count]);
+    pRange->Last[count] = toupper(pRange->Last[count]);
+  };
+  if (! pRange->Generic && memcmp(pRange->First, pRange->Last, 10) > 0) {
+    return ERR_ARGUMENTS_ERROR;
+  };
+
+  pPolicy->NumProtect++;
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  PlanDeletes()                                                */
+/*                                                                         */
+/* Description: Apply the retention policy to the receivers older than     */
+/*              the one we need to keep, setting pQm->Plan for each        */
+/*              receiver in the index                                      */
+/*                                                                         */
+/***************************************************************************/
+static int PlanDeletes(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                       int oldestReceiverIndex)
+{
+  char   *pPlan;
+  int     count;
+  JrnTime Now = LocalSeconds() * 1000;
+
+  if (pQm->PlanSize < pIndex->Count || ! pQm->Plan) {
+    pPlan = (char*)realloc(pQm->Plan, pIndex->Count + SPARE_CHAIN);
+    if (! pPlan) {
+      output_error(pQm, "ERROR: Memory allocation error (Plan)");
+      return ERR_MEMORY_ERROR;
+    };
+    pQm->Plan = pPlan;
+    pQm->PlanSize = pIndex->Count + SPARE_CHAIN;
+  };
+
+  pQm->Eligible = ClassifyReceivers(&pQm->pConfig->Policy, pIndex,
+                                    oldestReceiverIndex,
+                                    Now, pQm->Plan);
+  pQm->Metrics.Kept = pIndex->Count - pQm->Eligible;
+  pQm->AgeHeld = 0;
+  for (count = 0; count < oldestReceiverIndex; count++) {
+    if (pQm->Plan[count] == PLAN_RECENT) pQm->AgeHeld++;
+  };
+
+  if (pQm->pConfig->TraceFp) {
+    TracePolicy(pQm, Now);
+  };
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  ClassifyReceivers()                                          */
+/*                                                                         */
+/* Description: Decide in one pass over the index what happens to each     */
+/*              receiver, from the fields the receiver chain already       */
+/*              holds.  Receivers from the oldest one needed on are        */
+/*              PLAN_NEEDED; older ones are kept if RETAIN, PROTECT,       */
+/*              MINAGE or REQSAVED says so, so no delete is tried that is  */
+/*              bound to fail or should not be done, and the rest are      */
+/*              PLAN_DELETE.  A receiver is detached when the next one is  */
+/*              attached, which is where its age for MINAGE is taken from. */
+/*                                                                         */
+/* Returns:     The number of receivers to delete                          */
+/*                                                                         */
+/***************************************************************************/
+static int ClassifyReceivers(struct RetainPolicy *pPolicy,
+                             struct RcvIndex *pIndex, int oldestReceiverIndex,
+                             JrnTime Now, char *Plan)
+{
+  int     count,
+  eligible = 0;
+  JrnTime MinAge = pPolicy->MinAgeHours * 3600000LL;
+
+  for (count = 0; count < pIndex->Count; count++) {
+    if ( count >= oldestReceiverIndex )
+      Plan[count] = PLAN_NEEDED;
+    else if ( count >= oldestReceiverIndex - pPolicy->Extra )
+      Plan[count] = PLAN_RETAIN;
+    else if ( pPolicy->NumProtect && 
+              IsProtected(pPolicy, pIndex->Name[count]) )
+      Plan[count] = PLAN_PROTECT;
+    else if ( MinAge && Now - pIndex->AttachTime[count + 1] < MinAge )
+      Plan[count] = PLAN_RECENT;
+    else if ( pPolicy->RequireSaved && 
+              pIndex->Status[count] != RCV_STATUS_SAVED &&
+              pIndex->Status[count] != RCV_STATUS_FREED )
+      Plan[count] = PLAN_UNSAVED;
+    else {
+      Plan[count] = PLAN_DELETE;
+      eligible++;
+    };
+  };
+  return eligible;
+}
+
+/***************************************************************************/
+/* Function:  IsProtected()                                                */
+/***************************************************************************/
+static int IsProtected(struct RetainPolicy *pPolicy, char *RcvName)
+{
+  struct ProtectRange *pRange;
+  int   count;
+
+  for (count = 0; count < pPolicy->NumProtect; count++) {
+    pRange = &pPolicy->Protect[count];
+    if (pRange->Generic) {
+      if (! memcmp(RcvName, pRange->First, pRange->Generic)) return TRUE;
+    }
+    else if (memcmp(RcvName, pRange->First, 10) >= 0 &&
+             memcmp(RcvName, pRange->Last, 10) <= 0) {
+      return TRUE;
+    };
+  };
+  return FALSE;
+}
+
+/***************************************************************************/
+/* Function:  PlanReason()                                                 */
+/*                                                                         */
+/* Description: Why the retention policy keeps a receiver                  */
+/*                                                                         */
+/***************************************************************************/
+static char *PlanReason(char Plan)
+{
+  switch (Plan) {
+  case PLAN_RETAIN:  return "retained (RETAIN)";
+  case PLAN_PROTECT: return "protected (PROTECT)";
+  case PLAN_RECENT:  return "detached too recently (MINAGE)";
+  case PLAN_UNSAVED: return "not saved (REQSAVED)";
+  };
+  return "needed";
+}
+
+/***************************************************************************/
+/* Function:  ReportHeld()                                                 */
+/*                                                                         */
+/* Description: Report how many receivers the queue manager doesn't need   */
+/*              are kept by the retention policy, and why, from the plan   */
+/*              ClassifyReceivers() left in pQm->Plan                      */
+/*                                                                         */
+/***************************************************************************/
+static void ReportHeld(struct QmgrMaint *pQm, int oldestReceiverIndex)
+{
+  int   count,
+  retained = 0,
+  protected = 0,
+  recent = 0,
+  unsaved = 0;
+  char  print_buffer[200];
+
+  for (count = 0; count < oldestReceiverIndex; count++) {
+    switch (pQm->Plan[count]) {
+    case PLAN_RETAIN:  retained++;  break;
+    case PLAN_PROTECT: protected++; break;
+    case PLAN_RECENT:  recent++;    break;
+    case PLAN_UNSAVED: unsaved++;   break;
+    };
+  };
+  if (retained + protected + recent + unsaved == 0) return;
+
+  sprintf(print_buffer, "%d receiver(s) not needed are kept by the "
+          "retention policy - %d by RETAIN, %d by PROTECT, %d by MINAGE "
+          "and %d by REQSAVED", retained + protected + recent + unsaved,
+          retained, protected, recent, unsaved);
+  output(pQm, print_buffer);
+}
+
+/***************************************************************************/
+/* Function:  ProcessEligible()                                            */
+/*                                                                         */
+/* Description: Deal with the receivers older than the one we need to      */
+/*              keep according to the DLTRCV and SAVRCV options           */
+/*                                                                         */
+/***************************************************************************/
+static int ProcessEligible(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                           int oldestReceiverIndex, int *pDeleteCount)
+{
+  *pDeleteCount = 0;
+
+  if ( pQm->pConfig->SaveReceivers == TRUE ) {
+    return SaveAndDeleteReceivers(pQm, pIndex, oldestReceiverIndex,
+                                  pDeleteCount);
+  };
+  if ( pQm->pConfig->DeleteReceivers == TRUE ) {
+    return DeleteReceivers(pQm, pIndex, oldestReceiverIndex, pDeleteCount);
+  };
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  DeleteReceivers()                                            */
+/*                                                                         */
+/* Description: Delete the receivers older than the one we need to keep   */
+/*              that PlanDeletes() found the retention policy allows to be */
+/*              deleted, oldest first.  Those it keeps are skipped rather  */
+/*              than tried, and a delete that fails doesn't stop the rest. */
+/*              The outcome and time taken by each delete are recorded in  */
+/*              pQm->Deletes.  With DLTRATE, DLTPERMIN or LOADPROBE each   */
+/*              delete waits its turn (see PaceDelete), and the receivers  */
+/*              still to be deleted when the pacing runs out of time are   */
+/*              left, still oldest first, for the next time.               */
+/*                                                                         */
+/***************************************************************************/
+static int DeleteReceivers(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                           int oldestReceiverIndex, int *pDeleteCount)
+{
+  int   retcode = OK,
+  count;
+
+  *pDeleteCount = 0;
+  retcode = StartDeletes(pQm, oldestReceiverIndex);
+  if (retcode != OK) {
+    return retcode;
+  };
+
+  for (count = 0; count < oldestReceiverIndex; count++) {
+    if (pQm->Plan[count] != PLAN_DELETE) continue;
+    if (! PaceDelete(pQm, pIndex, count)) {
+      DeferDeletes(pQm, pIndex, count, oldestReceiverIndex);
+      break;
+    };
+    if (DeleteReceiver(pQm, pIndex, count) == OK)
+      (*pDeleteCount)++;
+    else
+      retcode = ERR_DELETE_FAILED;
+    PaceDeleted(pQm);
+  };
+
+  EndDeletes(pQm);
+  return retcode;
+}
+
+/***************************************************************************/
+/* Function:  StartDeletes()                                               */
+/*                                                                         */
+/* Description: Make room to record the outcome of up to Count deletes,    */
+/*              and start pacing them afresh - other than the pace         */
+/*              itself, which carries on from the last time                */
+/*                                                                         */
+/***************************************************************************/
+static int StartDeletes(struct QmgrMaint *pQm, int Count)
+{
+  struct DeleteResult *pResult;
+  struct JrnMaintConfig *pConfig = pQm->pConfig;
+  struct DeletePacer *pPacer = &pQm->Pacer;
+
+  pQm->NumDeletes = 0;
+
+  pPacer->Active = pConfig->DeleteRateK > 0 || pConfig->DeletesPerMin > 0 ||
+                   pConfig->LoadProbe[0];
+  if (pPacer->Scale < 1) pPacer->Scale = 1;
+  pPacer->Tokens = pConfig->DeleteRateK / pPacer->Scale;
+  pPacer->LastRefill = PlatMicroseconds();
+  pPacer->LastStart = 0;
+  pPacer->WaitMicros = 0;
+  pPacer->Backoffs = 0;
+  pPacer->Deferred = 0;
+
+  if (Count > 0 && pQm->DeletesSize < Count) {
+    pResult = (struct DeleteResult*)realloc(pQm->Deletes, 
+                                       sizeof(struct DeleteResult) * Count);
+    if (! pResult) {
+      output_error(pQm, "ERROR: Memory allocation error (DeleteResult)");
+      return ERR_MEMORY_ERROR;
+    };
+    pQm->Deletes = pResult;
+    pQm->DeletesSize = Count;
+  };
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  DeleteReceiver()                                             */
+/*                                                                         */
+/* Description: Delete receiver Entry of the index, recording the outcome  */
+/*                                                                         */
+/***************************************************************************/
+static int DeleteReceiver(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                          int Entry)
+{
+  int   retcode;
+  char  print_buffer[200],
+  TimeText[24];
+  long long startTime;
+  struct DeleteResult *pResult;
+  Qus_EC_t  ErrorData;
+
+  FormatJrnTime(pIndex->AttachTime[Entry], FALSE, TimeText);
+  sprintf(print_buffer, 
+          "Deleting Receiver %10.10s attached at: %s",
+          pIndex->Name[Entry], TimeText);
+  output_detail(pQm, print_buffer);
+
+  pResult = &pQm->Deletes[pQm->NumDeletes++];
+  memcpy(pResult->Name, pIndex->Name[Entry], 10);
+  memset(pResult->ExceptionId, ' ', 7);
+
+  ErrorData.Bytes_Available = 0;
+  ErrorData.Bytes_Provided =  sizeof(Qus_EC_t);
+  startTime = PlatMicroseconds();
+  retcode = PlatDeleteReceiver(pQm->szQmgrLib, pIndex->Name[Entry],
+                               &ErrorData);
+  pResult->Micros = PlatMicroseconds() - startTime;
+
+  if ( retcode ) {
+    if ( ErrorData.Bytes_Available ) {
+      memcpy(pResult->ExceptionId, ErrorData.Exception_Id, 7);
+    };
+    sprintf(print_buffer, 
+            "ERROR: %7.7s from DLTJRNRCV of %10.10s.  "
+            "See job log for details", 
+            pResult->ExceptionId, pResult->Name );
+    output_error(pQm, print_buffer);
+    pQm->Metrics.DeleteFailures++;
+    return ERR_DELETE_FAILED;
+  };
+
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  EndDeletes()                                                 */
+/*                                                                         */
+/* Description: Report the time taken by the deletes                       */
+/*                                                                         */
+/***************************************************************************/
+static void EndDeletes(struct QmgrMaint *pQm)
+{
+  int   count;
+  char  print_buffer[200];
+  long long totalMicros = 0,
+  maxMicros = 0;
+
+  if (pQm->NumDeletes == 0) return;
+
+  for (count = 0; count < pQm->NumDeletes; count++) {
+    totalMicros += pQm->Deletes[count].Micros;
+    if (pQm->Deletes[count].Micros > maxMicros)
+      maxMicros = pQm->Deletes[count].Micros;
+  };
+
+  sprintf(print_buffer, 
+          "%d DLTJRNRCV(s) took %lld ms, the longest %lld ms",
+          pQm->NumDeletes, totalMicros / 1000, maxMicros / 1000);
+  output(pQm, print_buffer);
+
+  if (pQm->Pacer.Active) {
+    sprintf(print_buffer, 
+            "Deletes were paced - waited %lld ms in all, slowed %d "
+            "time(s), now at 1/%d of the budget", 
+            pQm->Pacer.WaitMicros / 1000, pQm->Pacer.Backoffs, 
+            pQm->Pacer.Scale);
+    output(pQm, print_buffer);
+  };
+}
+
+/***************************************************************************/
+/* Function:  PaceDelete()                                                 */
+/*                                                                         */
+/* Description: Wait until receiver Entry may be deleted.  Returns FALSE   */
+/*              if it should be left for the next time instead - the job   */
+/*              is ending, or (in resident mode) waiting would take the    */
+/*              deletes past the next check.                               */
+/*                                                                         */
+/*              Three budgets apply, each divided by the pace's Scale:     */
+/*              DLTRATE, as a bucket of K that fills at that rate and      */
+/*              holds a second's worth (or one receiver, if that is        */
+/*              more), DLTPERMIN, as a gap between the start of one        */
+/*              delete and the next, and, with neither, a gap of           */
+/*              PACE_BACKOFF for each step the pace has been slowed.       */
+/*              Receivers whose size isn't reported don't use the bucket.  */
+/*                                                                         */
+/*              The LOADPROBE command is run before each delete; if it     */
+/*              fails the system is busy, and the pace is slowed before    */
+/*              the wait is worked out.                                    */
+/*                                                                         */
+/***************************************************************************/
+static int PaceDelete(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                      int Entry)
+{
+  struct JrnMaintConfig *pConfig = pQm->pConfig;
+  struct DeletePacer *pPacer = &pQm->Pacer;
+  char  print_buffer[200],
+  *Reason = 0;
+  int   rate = 0;
+  long long now,
+  gap,
+  sizeK,
+  waitMicros = 0,
+  startWait,
+  step;
+  Qus_EC_t  ErrorData;
+
+  if (! pPacer->Active) return TRUE;
+
+  pPacer->Busy = FALSE;
+  if (pConfig->LoadProbe[0]) {
+    ErrorData.Bytes_Available = 0;
+    ErrorData.Bytes_Provided =  sizeof(Qus_EC_t);
+    if (PlatRunProbe(pConfig->LoadProbe, &ErrorData)) {
+      sprintf(print_buffer, "LOADPROBE ended with %7.7s - the system is busy",
+              ErrorData.Bytes_Available ? ErrorData.Exception_Id : "       ");
+      SlowPace(pQm, print_buffer);
+      pPacer->Busy = TRUE;
+    };
+  };
+
+  /*************************************************************************/
+  /* The gap since the last delete started - DLTPERMIN, or the backoff     */
+  /* when there is no budget to divide                                     */
+  /*************************************************************************/
+  now = PlatMicroseconds();
+  if (pConfig->DeletesPerMin > 0)
+    gap = 60000000LL * pPacer->Scale / pConfig->DeletesPerMin;
+  else if (pConfig->DeleteRateK > 0)
+    gap = 0;
+  else
+    gap = (long long)(pPacer->Scale - 1) * PACE_BACKOFF;
+  if (pPacer->LastStart && pPacer->LastStart + gap > now) {
+    waitMicros = pPacer->LastStart + gap - now;
+    Reason = pConfig->DeletesPerMin > 0 ? "DLTPERMIN" : "backing off";
+  };
+
+  /*************************************************************************/
+  /* DLTRATE - wait for the bucket to hold the receiver's size             */
+  /*************************************************************************/
+  sizeK = (long long)pIndex->SizeK[Entry] * pQm->SizeMult;
+  if (pConfig->DeleteRateK > 0) {
+    rate = pConfig->DeleteRateK / pPacer->Scale;
+    if (rate < 1) rate = 1;
+    pPacer->Tokens += (now - pPacer->LastRefill) * (double)rate / 1e6;
+    pPacer->LastRefill = now;
+    if (pPacer->Tokens > (sizeK > rate ? sizeK : rate))
+      pPacer->Tokens = sizeK > rate ? sizeK : rate;
+    if (pPacer->Tokens < sizeK &&
+        (sizeK - pPacer->Tokens) * 1e6 / rate > waitMicros) {
+      waitMicros = (long long)((sizeK - pPacer->Tokens) * 1e6 / rate);
+      Reason = "DLTRATE";
+    };
+  };
+
+  /*************************************************************************/
+  /* Wait, a second at a time so the end of the job is noticed             */
+  /*************************************************************************/
+  if (waitMicros > 0) {
+    if (pPacer->Deadline && now + waitMicros > pPacer->Deadline) {
+      return FALSE;
+    };
+    sprintf(print_buffer, 
+            "Waiting %lld ms to delete %10.10s (%lld K) - %s, at 1/%d of "
+            "the budget", waitMicros / 1000, pIndex->Name[Entry], sizeK,
+            Reason, pPacer->Scale);
+    output_detail(pQm, print_buffer);
+
+    startWait = now;
+    while (now < startWait + waitMicros && 
+           ! (pConfig->pStop && *pConfig->pStop)) {
+      step = startWait + waitMicros - now;
+      usleep(step < PACE_SLEEP ? step : PACE_SLEEP);
+      now = PlatMicroseconds();
+    };
+    pPacer->WaitMicros += now - startWait;
+  };
+  if (pConfig->pStop && *pConfig->pStop) {
+    return FALSE;
+  };
+
+  if (pConfig->DeleteRateK > 0) {
+    pPacer->Tokens += (now - pPacer->LastRefill) * (double)rate / 1e6;
+    pPacer->LastRefill = now;
+    pPacer->Tokens -= sizeK;
+  };
+  pPacer->LastStart = now;
+  return TRUE;
+}
+
+/***************************************************************************/
+/* Function:  PaceDeleted()                                                */
+/*                                                                         */
+/* Description: Adjust the pace after a delete.  How long DLTJRNRCV takes  */
+/*              stands for how busy the ASP is: one that takes             */
+/*              PACE_SLOW_FACTOR times as long as usual slows the pace     */
+/*              down.  Otherwise, unless the probe said the system was     */
+/*              busy, the pace speeds up by one step.                      */
+/*                                                                         */
+/***************************************************************************/
+static void PaceDeleted(struct QmgrMaint *pQm)
+{
+  struct DeletePacer *pPacer = &pQm->Pacer;
+  struct DeleteResult *pResult;
+  char  print_buffer[200];
+
+  if (! pPacer->Active || pQm->NumDeletes == 0) return;
+
+  pResult = &pQm->Deletes[pQm->NumDeletes - 1];
+  if (pResult->ExceptionId[0] != ' ') return;
+
+  if (pPacer->UsualMicros > 0 && pResult->Micros >= PACE_SLOW_MICROS &&
+      pResult->Micros > pPacer->UsualMicros * PACE_SLOW_FACTOR) {
+    if (! pPacer->Busy) {
+      sprintf(print_buffer, 
+              "DLTJRNRCV of %10.10s took %lld ms, against %lld ms usually "
+              "- the system is busy", pResult->Name, pResult->Micros / 1000,
+              pPacer->UsualMicros / 1000);
+      SlowPace(pQm, print_buffer);
+    };
+    return;
+  };
+
+  pPacer->UsualMicros = pPacer->UsualMicros > 0 ?
+                        (pPacer->UsualMicros * 3 + pResult->Micros) / 4 :
+                        pResult->Micros;
+  if (! pPacer->Busy && pPacer->Scale > 1) {
+    pPacer->Scale--;
+  };
+}
+
+/***************************************************************************/
+/* Function:  SlowPace()                                                   */
+/*                                                                         */
+/* Description: The system is busy - halve the pace (down to               */
+/*              1/PACE_MAX_SCALE of the budget)                            */
+/*                                                                         */
+/***************************************************************************/
+static void SlowPace(struct QmgrMaint *pQm, char *Reason)
+{
+  struct DeletePacer *pPacer = &pQm->Pacer;
+  char  print_buffer[300];
+
+  if (pPacer->Scale < PACE_MAX_SCALE) {
+    pPacer->Scale *= 2;
+    if (pPacer->Scale > PACE_MAX_SCALE) pPacer->Scale = PACE_MAX_SCALE;
+  };
+  pPacer->Backoffs++;
+
+  sprintf(print_buffer, "%s - slowing the deletes to 1/%d of the budget", 
+          Reason, pPacer->Scale);
+  output_detail(pQm, print_buffer);
+}
+
+/***************************************************************************/
+/* Function:  DeferDeletes()                                               */
+/*                                                                         */
+/* Description: Leave the receivers still to be deleted, from Entry on,    */
+/*              for the next time                                          */
+/*                                                                         */
+/***************************************************************************/
+static void DeferDeletes(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                         int Entry, int Count)
+{
+  int   count;
+  char  print_buffer[200];
+
+  pQm->Pacer.Deferred = 0;
+  for (count = Entry; count < Count; count++) {
+    if (pQm->Plan[count] == PLAN_DELETE) pQm->Pacer.Deferred++;
+  };
+
+  sprintf(print_buffer, 
+          "%d receiver(s) from %10.10s on are left to be deleted next time",
+          pQm->Pacer.Deferred, pIndex->Name[Entry]);
+  output(pQm, print_buffer);
+}
+
+/***************************************************************************/
+/* Function:  SaveAndDeleteReceivers()                                     */
+/*                                                                         */
+/* Description: SAVRCV(*YES) - save each receiver older than the one we    */
+/*              need to keep to a save file, and delete it (if DLTRCV is   */
+/*              *YES) only once its save has completed.                    */
+/*                                                                         */
+/*              The saves are done by a second thread, so receiver N+1 is  */
+/*              being saved while receiver N is deleted.  Both threads go  */
+/*              oldest first, skipping the receivers the retention policy  */
+/*              keeps; the first save that fails stops both.  Receivers    */
+/*              already saved (by an earlier run that was interrupted, for */
+/*              instance) are not saved again.  If the thread can't be     */
+/*              started the saves are done in this thread.                 */
+/*                                                                         */
+/*              With an ARCHIVE, each save file is added to the archive    */
+/*              and then deleted, and receivers already in the archive     */
+/*              are not saved again.                                       */
+/*                                                                         */
+/***************************************************************************/
+static int SaveAndDeleteReceivers(struct QmgrMaint *pQm,
+                                  struct RcvIndex *pIndex,
+                                  int oldestReceiverIndex, int *pDeleteCount)
+{
+  int   retcode = OK,
+  count,
+  threaded;
+  char  print_buffer[300];
+  pthread_t SaveThread;
+  struct SavePipe Pipe;
+  struct Archive *pArc = pQm->pConfig->pArchive;
+
+  *pDeleteCount = 0;
+  if (oldestReceiverIndex <= 0) {
+    return OK;
+  };
+
+  retcode = StartDeletes(pQm, oldestReceiverIndex);
+  if (retcode != OK) {
+    return retcode;
+  };
+
+  memset(&Pipe, 0, sizeof(Pipe));
+  Pipe.pQm = pQm;
+  Pipe.pIndex = pIndex;
+  Pipe.Count = oldestReceiverIndex;
+  pthread_mutex_init(&Pipe.Lock, NULL);
+  pthread_cond_init(&Pipe.Cond, NULL);
+
+  threaded = ! pthread_create(&SaveThread, NULL, SaveWorker, &Pipe);
+  if (! threaded) {
+    SaveWorker(&Pipe);
+  };
+
+  for (count = 0; count < oldestReceiverIndex; count++) {
+    if (pQm->Plan[count] != PLAN_DELETE) continue;
+
+    /***********************************************************************/
+    /* Wait until this receiver has been saved                             */
+    /***********************************************************************/
+    pthread_mutex_lock(&Pipe.Lock);
+    while (Pipe.Saved <= count && ! Pipe.Failed) {
+      pthread_cond_wait(&Pipe.Cond, &Pipe.Lock);
+    };
+    pthread_mutex_unlock(&Pipe.Lock);
+
+    if (Pipe.Saved <= count && Pipe.ArchiveMismatch) {
+      sprintf(print_buffer, 
+              "ERROR: Save file %10.10s/%10.10s didn't read back the same "
+              "from archive %.150s - it has been kept", pQm->SavLib,
+              pIndex->Name[count], pArc->Dir);
+      output_error(pQm, print_buffer);
+      retcode = ERR_ARCHIVE;
+      break;
+    };
+    if (Pipe.Saved <= count && Pipe.ArchiveFailed) {
+      sprintf(print_buffer, 
+              "ERROR: %7.7s adding save file %10.10s/%10.10s to archive "
+              "%.150s", Pipe.ExceptionId, pQm->SavLib, pIndex->Name[count],
+              pArc->Dir);
+      output_error(pQm, print_buffer);
+      retcode = ERR_ARCHIVE;
+      break;
+    };
+    if (Pipe.Saved <= count) {
+      sprintf(print_buffer, 
+              "ERROR: %7.7s saving %10.10s to save file %10.10s/%10.10s.  "
+              "See job log for details", Pipe.ExceptionId, 
+              pIndex->Name[count], pQm->SavLib, pIndex->Name[count]);
+      output_error(pQm, print_buffer);
+      retcode = ERR_SAVE_FAILED;
+      break;
+    };
+
+    if (pArc)
+      sprintf(print_buffer, "Receiver %10.10s is in archive %.150s",
+              pIndex->Name[count], pArc->Dir);
+    else
+      sprintf(print_buffer, 
+              pIndex->Status[count] == RCV_STATUS_SAVED ||
+              pIndex->Status[count] == RCV_STATUS_FREED ?
+              "Receiver %10.10s was already saved" :
+              "Saved receiver %10.10s to save file %10.10s/%10.10s",
+              pIndex->Name[count], pQm->SavLib, pIndex->Name[count]);
+    output_detail(pQm, print_buffer);
+
+    if ( pQm->pConfig->DeleteReceivers == TRUE ) {
+      if (! PaceDelete(pQm, pIndex, count)) {
+        DeferDeletes(pQm, pIndex, count, oldestReceiverIndex);
+        break;
+      };
+      if (DeleteReceiver(pQm, pIndex, count) == OK)
+        (*pDeleteCount)++;
+      else
+        retcode = ERR_DELETE_FAILED;
+      PaceDeleted(pQm);
+    };
+  };
+
+  /*************************************************************************/
+  /* Tell the save thread to stop if we stopped early, and wait for it     */
+  /*************************************************************************/
+  pthread_mutex_lock(&Pipe.Lock);
+  Pipe.Stop = TRUE;
+  pthread_mutex_unlock(&Pipe.Lock);
+  if (threaded) {
+    pthread_join(SaveThread, NULL);
+  };
+  pthread_mutex_destroy(&Pipe.Lock);
+  pthread_cond_destroy(&Pipe.Cond);
+
+  sprintf(print_buffer, 
+          "%d receiver(s) saved, taking %lld ms, the longest %lld ms",
+          Pipe.NumSaved, Pipe.SaveMicros / 1000, Pipe.MaxSaveMicros / 1000);
+  output(pQm, print_buffer);
+  if (pArc) {
+    sprintf(print_buffer, 
+            "%d save file(s) archived - %lld K stored as %lld K, %d of %d "
+            "chunk(s) new", Pipe.NumArchived, Pipe.ArchivedBytes / 1024,
+            Pipe.StoredBytes / 1024, Pipe.NewChunks, Pipe.TotalChunks);
+    output(pQm, print_buffer);
+  };
+  pQm->Metrics.Saved += Pipe.NumSaved;
+  EndDeletes(pQm);
+
+  return retcode;
+}
+
+/***************************************************************************/
+/* Function:  SaveWorker()                                                 */
+/*                                                                         */
+/* Description: Save thread body - save the receivers to be deleted,       */
+/*              oldest first, until they are all saved, a save fails or    */
+/*              we're told to stop.  With an ARCHIVE the save time         */
+/*              includes adding the save file to it.                       */
+/*                                                                         */
+/***************************************************************************/
+static void *SaveWorker(void *pArg)
+{
+  struct SavePipe *pPipe = (struct SavePipe*)pArg;
+  struct RcvIndex *pIndex = pPipe->pIndex;
+  char *Plan = pPipe->pQm->Plan;
+  struct Archive *pArc = pPipe->pQm->pConfig->pArchive;
+  int   count,
+  saving,
+  archived,
+  archiveFailed,
+  stop,
+  retcode;
+  long long startTime,
+  micros = 0;
+  Qus_EC_t  ErrorData;
+
+  for (count = 0; count < pPipe->Count; count++) {
+
+    pthread_mutex_lock(&pPipe->Lock);
+    stop = pPipe->Stop;
+    pthread_mutex_unlock(&pPipe->Lock);
+    if (stop) break;
+
+    retcode = OK;
+    archiveFailed = FALSE;
+    archived = FALSE;
+    if (Plan[count] == PLAN_DELETE && pArc) {
+      pthread_mutex_lock(&pArc->Lock);
+      archived = FindArchived(pArc, pPipe->pQm->QmgrLib, 
+                              pIndex->Name[count],
+                              pIndex->AttachTime[count]) >= 0;
+      pthread_mutex_unlock(&pArc->Lock);
+    };
+    saving = Plan[count] == PLAN_DELETE && ! archived &&
+             ( pArc ||
+               ( pIndex->Status[count] != RCV_STATUS_SAVED &&
+                 pIndex->Status[count] != RCV_STATUS_FREED ) );
+    if (saving) {
+      ErrorData.Bytes_Available = 0;
+      ErrorData.Bytes_Provided =  sizeof(Qus_EC_t);
+      startTime = PlatMicroseconds();
+      retcode = PlatSaveReceiver(pPipe->pQm->szQmgrLib, pIndex->Name[count],
+                                 pPipe->pQm->SavLib, &ErrorData);
+      if (retcode == OK && pArc) {
+        retcode = ArchiveSaveFile(pPipe, count, &ErrorData);
+        archiveFailed = retcode != OK;
+      };
+      micros = PlatMicroseconds() - startTime;
+    };
+
+    pthread_mutex_lock(&pPipe->Lock);
+    if (retcode) {
+      pPipe->Failed = TRUE;
+      pPipe->ArchiveFailed = archiveFailed;
+      memcpy(pPipe->ExceptionId, 
+             ErrorData.Bytes_Available ? ErrorData.Exception_Id : "       ",
+             7);
+    }
+    else {
+      if (saving) {
+        pPipe->NumSaved++;
+        pPipe->SaveMicros += micros;
+        if (micros > pPipe->MaxSaveMicros) pPipe->MaxSaveMicros = micros;
+      };
+      pPipe->Saved = count + 1;
+    };
+    pthread_cond_broadcast(&pPipe->Cond);
+    pthread_mutex_unlock(&pPipe->Lock);
+
+    if (retcode) break;
+  };
+
+  return NULL;
+}
+
+
+/***************************************************************************/
+/* Function:  RunResident()                                                */
+/*                                                                         */
+/* Description: MODE(*RESIDENT) - stay active, keeping each queue          */
+/*              manager's receiver index in memory, and every INTERVAL     */
+/*              seconds check for anything that changes which receivers    */
+/*              can be deleted.  Runs until *pEnding is set - by the       */
+/*              program's signal handler when the job is ended.            */
+/*                                                                         */
+/***************************************************************************/
+int RunResident(struct JrnMaintConfig *pConfig, struct QmgrMaint *pQmgrs,
+                int NumQmgrs, int Interval, long long StartupMicros,
+                volatile sig_atomic_t *pEnding)
+{
+  int   count,
+  slept,
+  deletecount = 0;
+  char  print_buffer[200];
+  long long deadline;
+
+  sprintf(print_buffer, 
+          "Running resident - checking %d queue manager(s) every %d "
+          "second(s)", NumQmgrs, Interval);
+  output_config(pConfig, print_buffer);
+
+  while (! *pEnding) {
+
+    /***********************************************************************/
+    /* Paced deletes that would run past the next check are left until     */
+    /* then, so the other queue managers still get checked on time         */
+    /***********************************************************************/
+    deadline = PlatMicroseconds() + Interval * 1000000LL;
+    for (count = 0; count < NumQmgrs && ! *pEnding; count++) {
+      pQmgrs[count].Pacer.Deadline = deadline;
+      RefreshQmgr(&pQmgrs[count]);
+      FlushOutput(&pQmgrs[count]);
+    };
+    WriteMetrics(pConfig, pQmgrs, NumQmgrs, StartupMicros, 
+                 PlatMicroseconds() - LogBaseMicros);
+    WriteHistory(pQmgrs, NumQmgrs);
+    fflush(stdout);
+
+    for (slept = 0; slept < Interval && ! *pEnding; slept++) {
+      sleep(1);
+    };
+  };
+
+  /*************************************************************************/
+  /*  Ended - total up.  The cached indexes are freed with the list.       */
+  /*************************************************************************/
+  for (count = 0; count < NumQmgrs; count++) {
+    deletecount += pQmgrs[count].deletecount;
+  };
+
+  sprintf(print_buffer, 
+          "JrnMaint ended - %d receiver(s) have been deleted.", deletecount);
+  output_config(pConfig, print_buffer);
+
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  RefreshQmgr()                                                */
+/*                                                                         */
+/* Description: Bring one queue manager up to date in resident mode.       */
+/*                                                                         */
+/*              Two cheap checks tell us whether anything has changed -    */
+/*              the AMQJRNINF contents (the oldest entry needed moves on)  */
+/*              and the attached receiver (a new receiver was attached).   */
+/*              If neither has, there is nothing to do.  If a receiver     */
+/*              was attached, the new receivers are appended to the cached */
+/*              index; then the cutoff is recalculated and the receivers   */
+/*              that have become eligible are deleted (or reported).       */
+/*              Receivers kept by MINAGE, or left by the delete pacing,    */
+/*              are looked at again each time even if nothing changed.     */
+/*              Each step is one of the jrnmaint.h calls.                  */
+/*                                                                         */
+/***************************************************************************/
+static int RefreshQmgr(struct QmgrMaint *pQm)
+{
+  int             retcode = OK,
+  changed,
+  recheck,
+  count;
+  char            print_buffer[200],
+  TimeText[24];
+  struct JrnMaintState  State;
+  struct JrnMaintCutoff Cutoff;
+  struct JrnMaintPlan   Plan;
+  struct JrnMaintResult Result;
+  long long      *pPhase = pQm->Metrics.PhaseMicros,
+  startTime;
+
+  memset(pPhase, 0, sizeof(pQm->Metrics.PhaseMicros));
+  retcode = JrnMaintLoad(pQm, &State);
+  if (retcode != OK) {
+    return retcode;
+  };
+
+  /*************************************************************************/
+  /* Nothing changed since we last looked                                  */
+  /*************************************************************************/
+  recheck = pQm->AgeHeld || pQm->Pacer.Deferred;
+  if ( ! State.Changed && ! recheck ) {
+    pQm->Metrics.OldestAge = LocalSeconds() - State.Cutoff / 1000;
+    return OK;
+  };
+  pQm->Pacer.Deferred = 0;
+
+  /*************************************************************************/
+  /* Recalculate the cutoff                                                */
+  /*************************************************************************/
+  startTime = PlatMicroseconds();
+  JrnMaintCutoff(pQm, &Cutoff);
+  changed = Cutoff.Oldest >= 0 && memcmp(Cutoff.OldestRcv, pQm->LastOldest,
+                                         10);
+  if (changed || recheck) {
+    retcode = JrnMaintPlan(pQm, &Plan);
+  };
+  pPhase[PHASE_SCAN] = PlatMicroseconds() - startTime;
+
+  /*************************************************************************/
+  /* Receivers kept by MINAGE are checked again each time, as they become  */
+  /* old enough to delete without anything else changing, and so are the   */
+  /* receivers the pacing left                                             */
+  /*************************************************************************/
+  if ( retcode == OK && ( changed || recheck ) ) {
+    if (changed) {
+      FormatJrnTime(Cutoff.Cutoff, TRUE, TimeText);
+      sprintf(print_buffer, 
+              "Timestamp of oldest journal entry: (%s) - "
+              "%10.10s is the oldest *JRNRCV that we need to keep",
+              TimeText, Cutoff.OldestRcv);
+      output(pQm, print_buffer);
+      memcpy(pQm->LastOldest, Cutoff.OldestRcv, 10);
+    };
+
+    /***********************************************************************/
+    /* Delete (or report) the receivers that have become eligible, and     */
+    /* drop the deleted ones from the cached index                         */
+    /***********************************************************************/
+    if (changed) {
+      ReportHeld(pQm, Cutoff.Oldest);
+    };
+    if ( ( pQm->pConfig->DeleteReceivers == TRUE || 
+           pQm->pConfig->SaveReceivers == TRUE ) &&
+         Plan.Eligible > 0 ) {
+      startTime = PlatMicroseconds();
+      retcode = JrnMaintExecute(pQm, &Result);
+      pPhase[PHASE_DELETE] = PlatMicroseconds() - startTime;
+    }
+    else if (changed) {
+      for (count = 0; count < Cutoff.Oldest; count++) {
+        if (Plan.Rcvrs[count].Plan != PLAN_DELETE) continue;
+        FormatJrnTime(Plan.Rcvrs[count].AttachTime, FALSE, TimeText);
+        sprintf(print_buffer, 
+                "Receiver %10.10s attached at: %s can be deleted",
+                Plan.Rcvrs[count].Name, TimeText);
+        output_detail(pQm, print_buffer);
+      };
+      sprintf(print_buffer, "%d receiver(s) can be deleted", Plan.Eligible);
+      output(pQm, print_buffer);
+    };
+  };
+
+  /*************************************************************************/
+  /* If a delete failed, forget the AMQJRNINF contents so the deletes are  */
+  /* retried next time                                                     */
+  /*************************************************************************/
+  if (retcode != OK) {
+    memset(&pQm->LastJrnInf, 0, sizeof(pQm->LastJrnInf));
+    memset(pQm->LastOldest, 0, 10);
+  };
+  pQm->retcode = retcode;
+
+  return retcode;
+}
+
+
+/***************************************************************************/
+/* Function:  JrnMaintCreate()                                             */
+/*                                                                         */
+/* Description: A context for one queue manager library, to be used with   */
+/*              the settings in *pConfig                                   */
+/*                                                                         */
+/***************************************************************************/
+struct QmgrMaint *JrnMaintCreate(struct JrnMaintConfig *pConfig,
+                                 char *QmgrLib)
+{
+  struct QmgrMaint *pQm;
+
+  pQm = (struct QmgrMaint*)calloc(1, sizeof(struct QmgrMaint));
+  if (pQm) {
+    InitQmgr(pConfig, pQm, QmgrLib, 10);
+  };
+  return pQm;
+}
+
+/***************************************************************************/
+/* Function:  JrnMaintDestroy()                                            */
+/***************************************************************************/
+void JrnMaintDestroy(struct QmgrMaint *pQm)
+{
+  if (! pQm) return;
+
+  FlushOutput(pQm);
+  FreeQmgr(pQm);
+  free(pQm);
+}
+
+/***************************************************************************/
+/* Function:  JrnMaintLastError()                                          */
+/***************************************************************************/
+char *JrnMaintLastError(struct QmgrMaint *pQm)
+{
+  return pQm->LastError;
+}
+
+/***************************************************************************/
+/* Function:  JrnMaintLoad()                                               */
+/*                                                                         */
+/* Description: Read AMQJRNINF and the attached receiver.  The first time, */
+/*              or when a receiver has been attached since, the receivers  */
+/*              new since the index was last brought up to date are        */
+/*              retrieved and appended to it.                              */
+/*                                                                         */
+/***************************************************************************/
+int JrnMaintLoad(struct QmgrMaint *pQm, struct JrnMaintState *pState)
+{
+  int             retcode = OK,
+  NumRcvrs = 0;
+  char            AttRcvName[10],
+  *JrnData = 0;
+  Qjo_JN_Repeating_Key_1_Output_t   *pRcvDirectory = 0;
+  struct JrnInf   JrnInf;
+  long long      *pPhase = pQm->Metrics.PhaseMicros,
+  startTime;
+
+  memset(pState, 0, sizeof(struct JrnMaintState));
+  pQm->LastError[0] = '\0';
+
+  startTime = PlatMicroseconds();
+  retcode = ReadJrnInf(pQm, &JrnInf);
+  pPhase[PHASE_USRSPC] = PlatMicroseconds() - startTime;
+  if (retcode == OK) {
+    startTime = PlatMicroseconds();
+    retcode = GetAttachedReceiver(pQm, AttRcvName);
+    pPhase[PHASE_CHAIN] = PlatMicroseconds() - startTime;
+  };
+  if (retcode != OK) {
+    pQm->retcode = retcode;
+    return retcode;
+  };
+
+  pState->Changed = ! pQm->Cached ||
+                    memcmp(&JrnInf, &pQm->LastJrnInf, sizeof(JrnInf)) ||
+                    memcmp(AttRcvName, pQm->LastAttRcv, 10);
+
+  if ( ! pQm->Cached || memcmp(AttRcvName, pQm->LastAttRcv, 10) ) {
+    startTime = PlatMicroseconds();
+    retcode = GetReceiverChain(pQm, &NumRcvrs, &JrnData, &pRcvDirectory);
+    pPhase[PHASE_CHAIN] += PlatMicroseconds() - startTime;
+    if (retcode == OK) {
+      retcode = SyncReceiverIndex(pQm, &pQm->Index, pRcvDirectory, NumRcvrs);
+      if (retcode != OK) {
+        output_error(pQm, "ERROR: Memory allocation error (RcvIndex)");
+      };
+    };
+    if (JrnData) {
+      free(JrnData);
+    };
+    if (retcode != OK) {
+      pQm->retcode = retcode;
+      return retcode;
+    };
+    pQm->NumRcvrs = pQm->Index.Count;
+  };
+
+  memcpy(&pQm->JrnInf, &JrnInf, sizeof(JrnInf));
+  memcpy(&pQm->LastJrnInf, &JrnInf, sizeof(JrnInf));
+  memcpy(pQm->LastAttRcv, AttRcvName, 10);
+  pQm->Cached = TRUE;
+
+  pState->Cutoff = JrnInfTime(&JrnInf);
+  memcpy(pState->AttRcv, AttRcvName, 10);
+  pState->NumRcvrs = pQm->Index.Count;
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  JrnMaintCutoff()                                             */
+/*                                                                         */
+/* Description: Find the oldest receiver needed in the chain as last       */
+/*              loaded                                                     */
+/*                                                                         */
+/***************************************************************************/
+int JrnMaintCutoff(struct QmgrMaint *pQm, struct JrnMaintCutoff *pCutoff)
+{
+  memset(pCutoff, 0, sizeof(struct JrnMaintCutoff));
+  if (! pQm->Cached) {
+    output_error(pQm, "ERROR: JrnMaintLoad() has not been called");
+    return ERR_ARGUMENTS_ERROR;
+  };
+
+  pCutoff->Cutoff = JrnInfTime(&pQm->JrnInf);
+  pQm->Oldest = FindOldestNeeded(&pQm->Index, pCutoff->Cutoff);
+  RecordCutoff(pQm, &pQm->Index, pQm->Oldest, &pQm->JrnInf);
+
+  pCutoff->Oldest = pQm->Oldest;
+  if (pQm->Oldest >= 0) {
+    memcpy(pCutoff->OldestRcv, pQm->Index.Name[pQm->Oldest], 10);
+  }
+  else {
+    memset(pCutoff->OldestRcv, ' ', 10);
+  };
+  pCutoff->Kept = pQm->Metrics.Kept;
+  pCutoff->Distance = pQm->Metrics.Distance;
+  pCutoff->OldestAge = pQm->Metrics.OldestAge;
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  JrnMaintPlan()                                               */
+/*                                                                         */
+/* Description: Apply the retention policy to the receivers older than     */
+/*              the one found by JrnMaintCutoff(), and return the plan for */
+/*              each receiver in the chain                                 */
+/*                                                                         */
+/***************************************************************************/
+int JrnMaintPlan(struct QmgrMaint *pQm, struct JrnMaintPlan *pPlan)
+{
+  struct JrnMaintReceiver *pRcvrs;
+  struct RcvIndex *pIndex = &pQm->Index;
+  int   retcode,
+  count;
+
+  memset(pPlan, 0, sizeof(struct JrnMaintPlan));
+  if (! pQm->Cached) {
+    output_error(pQm, "ERROR: JrnMaintLoad() has not been called");
+    return ERR_ARGUMENTS_ERROR;
+  };
+
+  retcode = PlanDeletes(pQm, pIndex, pQm->Oldest);
+  if (retcode != OK) {
+    return retcode;
+  };
+
+  if (pQm->PlanRcvrsSize < pIndex->Count || ! pQm->PlanRcvrs) {
+    pRcvrs = (struct JrnMaintReceiver*)realloc(pQm->PlanRcvrs,
+               sizeof(struct JrnMaintReceiver) * 
+               (pIndex->Count + SPARE_CHAIN));
+    if (! pRcvrs) {
+      output_error(pQm, "ERROR: Memory allocation error (Plan)");
+      return ERR_MEMORY_ERROR;
+    };
+    pQm->PlanRcvrs = pRcvrs;
+    pQm->PlanRcvrsSize = pIndex->Count + SPARE_CHAIN;
+  };
+
+  for (count = 0; count < pIndex->Count; count++) {
+    pRcvrs = &pQm->PlanRcvrs[count];
+    memcpy(pRcvrs->Name, pIndex->Name[count], 10);
+    pRcvrs->AttachTime = pIndex->AttachTime[count];
+    pRcvrs->SizeK = pIndex->SizeK[count];
+    pRcvrs->Status = pIndex->Status[count];
+    pRcvrs->Plan = pQm->Plan[count];
+  };
+
+  pPlan->NumRcvrs = pIndex->Count;
+  pPlan->Rcvrs = pQm->PlanRcvrs;
+  pPlan->Eligible = pQm->Eligible;
+  pPlan->AgeHeld = pQm->AgeHeld;
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  JrnMaintExecute()                                            */
+/*                                                                         */
+/* Description: Save and/or delete the receivers JrnMaintPlan() planned to */
+/*              be deleted, as the DLTRCV and SAVRCV settings say, and     */
+/*              drop the ones deleted from the chain                       */
+/*                                                                         */
+/***************************************************************************/
+int JrnMaintExecute(struct QmgrMaint *pQm, struct JrnMaintResult *pResult)
+{
+  int   retcode = OK,
+  deletecount = 0,
+  saved = pQm->Metrics.Saved;
+
+  memset(pResult, 0, sizeof(struct JrnMaintResult));
+  if (! pQm->Plan) {
+    output_error(pQm, "ERROR: JrnMaintPlan() has not been called");
+    return ERR_ARGUMENTS_ERROR;
+  };
+
+  pQm->NumDeletes = 0;
+  pQm->Pacer.Deferred = 0;
+  if (pQm->Eligible > 0) {
+    retcode = ProcessEligible(pQm, &pQm->Index, pQm->Oldest, &deletecount);
+    RemoveDeletedReceivers(pQm, &pQm->Index);
+    pQm->NumRcvrs = pQm->Index.Count;
+    pQm->Metrics.Kept = pQm->Index.Count;
+    pQm->deletecount += deletecount;
+  };
+
+  /*************************************************************************/
+  /* The index has changed, so the plan must be made again before the next */
+  /* execute                                                               */
+  /*************************************************************************/
+  pQm->Eligible = 0;
+
+  pResult->Retcode = retcode;
+  pResult->Saved = pQm->Metrics.Saved - saved;
+  pResult->Deleted = deletecount;
+  pResult->Deferred = pQm->Pacer.Deferred;
+  pResult->NumDeletes = pQm->NumDeletes;
+  pResult->Deletes = pQm->Deletes;
+  return retcode;
+}
+
+
+/***************************************************************************/
+/* Function:  GetQmgrLibraries()                                           */
+/*                                                                         */
+/* Description: Build the list of queue managers to process from the       */
+/*              QMGRLIB parameter - a list of library names, or *ALL for   */
+/*              every queue manager library named in mqs.ini               */
+/*                                                                         */
+/***************************************************************************/
+int GetQmgrLibraries(struct JrnMaintConfig *pConfig, char *Parm,
+                     struct QmgrMaint **ppQmgrs, int *pNumQmgrs)
+{
+  int   retcode = OK,
+  NumLibs,
+  MaxQmgrs = 0,
+  count;
+  char  Libs[MAX_QMGR_PARM][10];
+
+  *ppQmgrs = 0;
+  *pNumQmgrs = 0;
+
+  NumLibs = PlatGetListParm(Parm, MAX_QMGR_PARM, 10, (char*)Libs);
+
+  if (NumLibs == 1 && ! memcmp(Libs[0], "*ALL      ", 10)) {
+    retcode = ReadMqsIni(pConfig, ppQmgrs, pNumQmgrs);
+  }
+  else {
+    for (count = 0; count < NumLibs && retcode == OK; count++) {
+      retcode = AddQmgr(pConfig, ppQmgrs, pNumQmgrs, &MaxQmgrs, Libs[count],
+                        10);
+    };
+  };
+
+  if (retcode == OK && *pNumQmgrs == 0) {
+    output_config_error(pConfig, "ERROR: Invalid Arguments - no queue "
+                        "manager libraries found");
+    retcode = ERR_ARGUMENTS_ERROR;
+  };
+
+  if (retcode != OK && *ppQmgrs) {
+    free(*ppQmgrs);
+    *ppQmgrs = 0;
+    *pNumQmgrs = 0;
+  };
+  return retcode;
+}
+
+/***************************************************************************/
+/* Function:  ReadMqsIni()                                                 */
+/*                                                                         */
+/* Description: Add the library of every QueueManager stanza in mqs.ini    */
+/*                                                                         */
+/***************************************************************************/
+static int ReadMqsIni(struct JrnMaintConfig *pConfig,
+                      struct QmgrMaint **ppQmgrs, int *pNumQmgrs)
+{
+  int   retcode = OK,
+  MaxQmgrs = 0,
+  inQmgrStanza = FALSE,
+  len;
+  char  line[256],
+  *p;
+  FILE *fp;
+
+  fp = fopen(MQS_INI_PATH, "r");
+  if (! fp) {
+    output_config_error(pConfig, "ERROR: Unable to open " MQS_INI_PATH);
+    return ERR_MQS_INI;
+  };
+
+  while (retcode == OK && fgets(line, sizeof(line), fp)) {
+
+    /***********************************************************************/
+    /* Stanza names start in column 1, their attributes are indented       */
+    /***********************************************************************/
+    if (! isspace(line[0])) {
+      inQmgrStanza = ! strncmp(line, "QueueManager:", 13);
+      continue;
+    };
+    if (! inQmgrStanza) continue;
+
+    for (p = line; isspace(*p); p++);
+    if (strncmp(p, "Library=", 8)) continue;
+
+    p += 8;
+    for (len = 0; p[len] && ! isspace(p[len]); len++);
+    if (len > 0 && len <= 10) {
+      retcode = AddQmgr(pConfig, ppQmgrs, pNumQmgrs, &MaxQmgrs, p, len);
+    };
+  };
+
+  fclose(fp);
+  return retcode;
+}
+
+/***************************************************************************/
+/* Function:  AddQmgr()                                                    */
+/*                                                                         */
+/* Description: Add a queue manager library to the list to be processed    */
+/*                                                                         */
+/***************************************************************************/
+static int AddQmgr(struct JrnMaintConfig *pConfig, struct QmgrMaint **ppQmgrs,
+                   int *pNumQmgrs, int *pMaxQmgrs, char *LibName, int LibLen)
+{
+  struct QmgrMaint *pQm;
+
+  if (*pNumQmgrs == *pMaxQmgrs) {
+    *pMaxQmgrs = *pMaxQmgrs ? *pMaxQmgrs * 2 : 16;
+    pQm = (struct QmgrMaint*)realloc(*ppQmgrs, 
+                                     sizeof(struct QmgrMaint) * *pMaxQmgrs);
+    if (! pQm) {
+      output_config_error(pConfig, 
+                          "ERROR: Memory allocation error (QmgrMaint)");
+      return ERR_MEMORY_ERROR;
+    };
+    *ppQmgrs = pQm;
+  };
+
+  pQm = &((*ppQmgrs)[*pNumQmgrs]);
+  memset(pQm, 0, sizeof(struct QmgrMaint));
+  InitQmgr(pConfig, pQm, LibName, LibLen);
+
+  (*pNumQmgrs)++;
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  InitQmgr()                                                   */
+/*                                                                         */
+/* Description: Set up a (zeroed) queue manager context - its settings,    */
+/*              and its blank padded & null terminated names in upper case */
+/*                                                                         */
+/***************************************************************************/
+static void InitQmgr(struct JrnMaintConfig *pConfig, struct QmgrMaint *pQm,
+                     char *LibName, int LibLen)
+{
+  int   count;
+  char *p;
+
+  pQm->pConfig = pConfig;
+
+  memset(pQm->QmgrLib, ' ', 10);
+  for (count = 0; count < LibLen && LibName[count]; count++) {
+    pQm->QmgrLib[count] = toupper(LibName[count]);          /* Upper case */
+  };
+
+  memcpy(pQm->szQmgrLib, pQm->QmgrLib, 10);    
+  pQm->szQmgrLib[10] = '\0';
+  p = strchr(pQm->szQmgrLib, ' ');                 /* Find trailing spaces */
+  if (p) *p = '\0';                                /* and strip them off   */
+
+  memcpy( pQm->message_queue, "QMQMMSG   ", 10);
+  memcpy( &(pQm->message_queue[10]), pQm->QmgrLib, 10);
+
+  if (memcmp(pConfig->SaveLibrary, "*QMGRLIB  ", 10)) 
+    memcpy(pQm->SavLib, pConfig->SaveLibrary, 10);
+  else
+    memcpy(pQm->SavLib, pQm->QmgrLib, 10);
+  pQm->Pacer.Scale = 1;
+}
+
+/***************************************************************************/
+/* Function:  FreeQmgr()                                                   */
+/*                                                                         */
+/* Description: Free what a queue manager context holds (but not the       */
+/*              context itself)                                            */
+/*                                                                         */
+/***************************************************************************/
+static void FreeQmgr(struct QmgrMaint *pQm)
+{
+  FreeReceiverIndex(&pQm->Index);
+  CloseHistory(pQm);
+  if (pQm->Deletes) free(pQm->Deletes);
+  if (pQm->Plan) free(pQm->Plan);
+  if (pQm->PlanRcvrs) free(pQm->PlanRcvrs);
+  if (pQm->OutBuf) free(pQm->OutBuf);
+  if (pQm->TraceBuf) free(pQm->TraceBuf);
+  pQm->Deletes = 0;
+  pQm->Plan = 0;
+  pQm->PlanRcvrs = 0;
+  pQm->OutBuf = 0;
+  pQm->TraceBuf = 0;
+  pQm->NumDeletes = pQm->DeletesSize = 0;
+  pQm->PlanSize = pQm->PlanRcvrsSize = 0;
+  pQm->OutLen = pQm->OutSize = 0;
+  pQm->TraceLen = pQm->TraceSize = 0;
+}
+
+/***************************************************************************/
+/* Function:  FreeQmgrs()                                                  */
+/*                                                                         */
+/* Description: Free a list of queue managers from GetQmgrLibraries()      */
+/*                                                                         */
+/***************************************************************************/
+void FreeQmgrs(struct QmgrMaint *pQmgrs, int NumQmgrs)
+{
+  int   count;
+
+  if (! pQmgrs) return;
+  for (count = 0; count < NumQmgrs; count++) {
+    FreeQmgr(&pQmgrs[count]);
+  };
+  free(pQmgrs);
+}
+
+
+/***************************************************************************/
+/* Function:  ReportReceivers()                                            */
+/*                                                                         */
+/* Description: Report the receivers in the chain from the newest to the   */
+/*              oldest, marking the oldest receiver we need to keep.  When */
+/*              receivers are being deleted the older receivers are        */
+/*              reported by the delete loop instead.                       */
+/*                                                                         */
+/***************************************************************************/
+static void ReportReceivers(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                            int oldestReceiverIndex)
+{
+  int   count;
+  char  print_buffer[200],
+  TimeText[24];
+
+  for (count = pIndex->Count - 1; count >= 0; count--) {
+    FormatJrnTime(pIndex->AttachTime[count], FALSE, TimeText);
+
+    /***********************************************************************/
+    /*  Receivers attached after the oldest journal entry, and the one     */
+    /*  containing it, are kept                                            */
+    /***********************************************************************/
+    if ( pQm->Plan[count] == PLAN_NEEDED ) {
+      sprintf(print_buffer, 
+              "Keeping receiver: %10.10s attached at: %s",
+              pIndex->Name[count], TimeText);
+      output_detail(pQm, print_buffer);
+
+      if ( count == oldestReceiverIndex ) {
+        sprintf(print_buffer, 
+                "** %10.10s is the oldest *JRNRCV that we need to keep **",
+                pIndex->Name[count]);
+        output(pQm, print_buffer);
+      };
+    }
+    /***********************************************************************/
+    /*  ...as are older ones the retention policy keeps...                 */
+    /***********************************************************************/
+    else if ( pQm->Plan[count] != PLAN_DELETE ) {
+      sprintf(print_buffer, 
+              "Keeping receiver: %10.10s attached at: %s - %s",
+              pIndex->Name[count], TimeText, PlanReason(pQm->Plan[count]));
+      output_detail(pQm, print_buffer);
+    }
+    /***********************************************************************/
+    /*  ...and if we're not deleting receivers the rest are just reported  */
+    /*  as eligible for deletion                                           */
+    /***********************************************************************/
+    else if ( pQm->pConfig->DeleteReceivers == FALSE ) {
+      sprintf(print_buffer, 
+              "Receiver %10.10s attached at: %s can be deleted",
+              pIndex->Name[count], TimeText);
+      output_detail(pQm, print_buffer);
+    };
+  };
+
+  /*************************************************************************/
+  /*  The totals, which are all that's reported with DETAIL(*SUMMARY)      */
+  /*************************************************************************/
+  sprintf(print_buffer, 
+          "Keeping %d receiver(s), %d older receiver(s) are not needed",
+          pIndex->Count - pQm->Eligible, pQm->Eligible);
+  output(pQm, print_buffer);
+  ReportHeld(pQm, oldestReceiverIndex);
+}
+
+/***************************************************************************/
+/* Function:  AnalyseJournal()                                             */
+/*                                                                         */
+/* Description: ANALYZE(*YES) - forecast from the recent receivers how     */
+/*              fast the journal is growing: the average time between      */
+/*              receiver switches, the write rate (when the API reports    */
+/*              receiver sizes), when the attached receiver is likely to   */
+/*              be switched, how much space deleting the receivers that    */
+/*              are no longer needed releases and, with ASPTHLD, when the  */
+/*              system ASP will reach the threshold.                       */
+/*                                                                         */
+/***************************************************************************/
+static void AnalyseJournal(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                           int oldestReceiverIndex)
+{
+  int   count,
+  first,
+  attached = pIndex->Count - 1,
+  window;
+  long long spanMillis,
+  windowK = 0,
+  reclaimK = 0,
+  retainedK = 0,
+  averageMillis,
+  ageSeconds,
+  nextSeconds;
+  double writeRateK = 0;
+  char  print_buffer[200],
+  Interval[40],
+  Interval2[40];
+
+  if (attached < 1) {
+    output(pQm, "Analysis - not enough receivers to forecast from");
+    return;
+  };
+
+  /*************************************************************************/
+  /* The space held by the receivers, before and after the cutoff          */
+  /*************************************************************************/
+  for (count = 0; count <= attached; count++) {
+    if (count < oldestReceiverIndex)
+      reclaimK += pIndex->SizeK[count];
+    else
+      retainedK += pIndex->SizeK[count];
+  };
+  reclaimK *= pQm->SizeMult;
+  retainedK *= pQm->SizeMult;
+
+  /*************************************************************************/
+  /* Receivers switched in the window - each of them was attached for the  */
+  /* time between its attach and the next one's                            */
+  /*************************************************************************/
+  window = attached < ANALYSIS_WINDOW ? attached : ANALYSIS_WINDOW;
+  first = attached - window;
+  spanMillis = pIndex->AttachTime[attached] - pIndex->AttachTime[first];
+  for (count = first; count < attached; count++) {
+    windowK += pIndex->SizeK[count];
+  };
+  windowK *= pQm->SizeMult;
+  averageMillis = spanMillis / window;
+  if (spanMillis > 0) {
+    writeRateK = windowK * 1000.0 / spanMillis;
+  };
+
+  FormatInterval(averageMillis / 1000, Interval);
+  sprintf(print_buffer, 
+          "Analysis - a receiver was attached every %s over the last %d",
+          Interval, window);
+  output(pQm, print_buffer);
+
+  /*************************************************************************/
+  /* When the attached receiver will be switched - from its size if we     */
+  /* know the sizes, otherwise from how long receivers usually last        */
+  /*************************************************************************/
+  ageSeconds = LocalSeconds() - pIndex->AttachTime[attached] / 1000;
+  if (ageSeconds < 0) ageSeconds = 0;
+  if (windowK > 0 && writeRateK > 0) {
+    nextSeconds = (long long)((windowK / window - 
+                               (long long)pIndex->SizeK[attached] * 
+                               pQm->SizeMult) / writeRateK);
+    sprintf(print_buffer, 
+            "Analysis - journal write rate %.1f K/second, %lld K in the "
+            "receivers kept, %lld K can be released", 
+            writeRateK, retainedK, reclaimK);
+    output(pQm, print_buffer);
+  }
+  else {
+    nextSeconds = averageMillis / 1000 - ageSeconds;
+    output(pQm, "Analysis - receiver sizes were not reported, so the write "
+                "rate is not known");
+  };
+
+  FormatInterval(ageSeconds, Interval);
+  FormatInterval(nextSeconds >= 0 ? nextSeconds : -nextSeconds, Interval2);
+  sprintf(print_buffer, 
+          "Analysis - %10.10s was attached %s ago and is likely to be "
+          "switched %s%s", pIndex->Name[attached], Interval, 
+          nextSeconds >= 0 ? "in " : "- it is overdue by ", Interval2);
+  output(pQm, print_buffer);
+
+  if ( pQm->pConfig->AspThreshold > 0 ) {
+    ForecastAsp(pQm, writeRateK);
+  };
+}
+
+/***************************************************************************/
+/* Function:  ForecastAsp()                                                */
+/*                                                                         */
+/* Description: Forecast when the system ASP will reach ASPTHLD percent if */
+/*              the journal keeps growing at WriteRateK and nothing else   */
+/*              changes.  Receivers in an independent ASP aren't covered.  */
+/*                                                                         */
+/***************************************************************************/
+static void ForecastAsp(struct QmgrMaint *pQm, double WriteRateK)
+{
+  long long capacityMB,
+  usedK,
+  thresholdK,
+  seconds;
+  int   percentUsed;
+  char  print_buffer[200],
+  Interval[40],
+  When[24];
+  Qus_EC_t  ErrorData;
+
+  ErrorData.Bytes_Available = 0;
+  ErrorData.Bytes_Provided =  sizeof(Qus_EC_t);
+  if (PlatGetAspUsage(&capacityMB, &percentUsed, &ErrorData)) {
+    sprintf(print_buffer, "ERROR: %7.7s from QWCRSSTS", 
+            ErrorData.Exception_Id);
+    output_error(pQm, print_buffer);
+    return;
+  };
+
+  usedK = (long long)(capacityMB * 1024.0 * percentUsed / 1000000);
+  thresholdK = capacityMB * 1024 * pQm->pConfig->AspThreshold / 100;
+
+  if (usedK >= thresholdK) {
+    sprintf(print_buffer, 
+            "Analysis - system ASP is %.2f%% used, over the %d%% threshold",
+            percentUsed / 10000.0, pQm->pConfig->AspThreshold);
+  }
+  else if (WriteRateK <= 0) {
+    sprintf(print_buffer, 
+            "Analysis - system ASP is %.2f%% used - can't forecast when it "
+            "will reach %d%% without the write rate",
+            percentUsed / 10000.0, pQm->pConfig->AspThreshold);
+  }
+  else {
+    seconds = (long long)((thresholdK - usedK) / WriteRateK);
+    FormatInterval(seconds, Interval);
+    FormatJrnTime((LocalSeconds() + seconds) * 1000, FALSE, When);
+    sprintf(print_buffer, 
+            "Analysis - system ASP is %.2f%% used and will reach %d%% in %s "
+            "(%16.16s) if no receivers are deleted",
+            percentUsed / 10000.0, pQm->pConfig->AspThreshold, Interval, When);
+  };
+  output(pQm, print_buffer);
+}
+
+/***************************************************************************/
+/* Function:  FormatInterval()                                             */
+/*                                                                         */
+/* Description: Format a number of seconds as days, hours, minutes and     */
+/*              seconds, leaving out the leading units that are zero       */
+/*                                                                         */
+/***************************************************************************/
+static void FormatInterval(long long Seconds, char *Text)
+{
+  if (Seconds >= 86400)
+    sprintf(Text, "%lldd %lldh %lldm", Seconds / 86400, 
+            Seconds / 3600 % 24, Seconds / 60 % 60);
+  else if (Seconds >= 3600)
+    sprintf(Text, "%lldh %lldm %llds", Seconds / 3600, 
+            Seconds / 60 % 60, Seconds % 60);
+  else if (Seconds >= 60)
+    sprintf(Text, "%lldm %llds", Seconds / 60, Seconds % 60);
+  else
+    sprintf(Text, "%llds", Seconds);
+}
+
+/***************************************************************************/
+/* Function:  FindPinning()                                                */
+/*                                                                         */
+/* Description: FINDPIN(*YES) - work out what is holding on to the oldest  */
+/*              receiver needed, rather than leaving it to DSPJRN:         */
+/*                                                                         */
+/*              1. Stream the commitment control entries of the receivers  */
+/*                 up to the oldest entry needed, to find the commit       */
+/*                 cycles that were open at that entry.  Only receivers    */
+/*                 attached by then can hold them, as a cycle started      */
+/*                 earlier would have made the queue manager keep an       */
+/*                 older receiver.                                         */
+/*              2. Report the oldest entry needed - its job, program,      */
+/*                 object and commit cycle (see FindOldestEntry).          */
+/*              3. Scan the receivers from there to the attached one for   */
+/*                 the commits and rollbacks of those cycles.  Each        */
+/*                 receiver is scanned on its own, so they are spread      */
+/*                 across up to MAX_PIN_THREADS threads.                   */
+/*                                                                         */
+/*              The API selects the entries, and they are read PIN_BLOCK  */
+/*              at a time, so the memory used doesn't depend on the size  */
+/*              of the receivers.                                          */
+/*                                                                         */
+/***************************************************************************/
+static void FindPinning(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                        int oldestReceiverIndex, struct JrnInf *pJrnInf)
+{
+  struct PinScan Scan;
+  struct PlatJrnEntry *pEntries,
+  Pin;
+  struct OpenCycle *pCycle,
+  Cycles[MAX_OPEN_CYCLES];
+  pthread_t Threads[MAX_PIN_THREADS];
+  char  print_buffer[200],
+  ToTime[17],
+  TimeText[24],
+  JobText[29],
+  ObjText[34];
+  int   NumCycles = 0,
+  Untracked = 0,
+  NumEntries = 0,
+  NumThreads,
+  NumStarted,
+  last,
+  current,
+  count,
+  more,
+  retcode = OK;
+  long long Sequence;
+  Qus_EC_t  ErrorData;
+
+  if (oldestReceiverIndex < 0 || oldestReceiverIndex >= pIndex->Count) {
+    return;
+  };
+
+  pEntries = (struct PlatJrnEntry*)malloc(PIN_BLOCK * 
+                                          sizeof(struct PlatJrnEntry));
+  if (! pEntries) {
+    output_error(pQm, "ERROR: Can't allocate memory to scan the journal");
+    return;
+  };
+
+  /*************************************************************************/
+  /* AMQJRNINF holds the timestamp as the digits YYYYMMDDHHMISS999         */
+  /*************************************************************************/
+  memcpy(ToTime, pJrnInf->CC, 17);
+  last = oldestReceiverIndex;
+  while (last + 1 < pIndex->Count && 
+         pIndex->AttachTime[last + 1] <= JrnInfTime(pJrnInf)) {
+    last++;
+  };
+
+  /*************************************************************************/
+  /* 1. Commit cycles open at the oldest entry needed                      */
+  /*************************************************************************/
+  ErrorData.Bytes_Provided = sizeof(Qus_EC_t);
+  for (current = oldestReceiverIndex; 
+       current <= last && retcode == OK; current++) {
+    Sequence = 0;
+    do {
+      ErrorData.Bytes_Available = 0;
+      retcode = PlatRetrieveEntries(pQm->szQmgrLib, pIndex->Name[current],
+                                    " ", ToTime, 'C', "SCCMRB", 3, 
+                                    &Sequence, pEntries, PIN_BLOCK, 
+                                    &NumEntries, &more, &ErrorData);
+      for (count = 0; retcode == OK && count < NumEntries; count++) {
+        if (! memcmp(pEntries[count].Type, "SC", 2)) {
+          if (NumCycles == MAX_OPEN_CYCLES) {
+            Untracked++;
+            continue;
+          };
+          pCycle = &Cycles[NumCycles++];
+          memset(pCycle, ' ', sizeof(struct OpenCycle));
+          pCycle->Id = pEntries[count].CommitCycle;
+          memcpy(pCycle->Job, pEntries[count].Job, 26);
+          pCycle->Started = EntryTime(pEntries[count].Time);
+          pCycle->Ended = 0;
+        }
+        else {
+          for (pCycle = Cycles; pCycle < &Cycles[NumCycles]; pCycle++) {
+            if (pCycle->Id == pEntries[count].CommitCycle) {
+              *pCycle = Cycles[--NumCycles];
+              break;
+            };
+          };
+        };
+      };
+    } while (retcode == OK && more);
+  };
+
+  if (retcode != OK) {
+    sprintf(print_buffer, 
+            "ERROR: %7.7s retrieving journal entries from %10.10s", 
+            ErrorData.Exception_Id, pIndex->Name[current - 1]);
+    output_error(pQm, print_buffer);
+    free(pEntries);
+    return;
+  };
+
+  /*************************************************************************/
+  /* 2. The oldest entry needed itself                                     */
+  /*************************************************************************/
+  if (FindOldestEntry(pQm, pIndex, oldestReceiverIndex, pJrnInf, &Pin,
+                      &current) != OK) {
+    free(pEntries);
+    return;
+  };
+
+  if (current >= 0) {
+    FormatJrnTime(EntryTime(Pin.Time), TRUE, TimeText);
+    sprintf(print_buffer, 
+            "Pinning - oldest entry needed is %c/%2.2s sequence %lld at %s "
+            "in %10.10s", Pin.Code, Pin.Type, Pin.Sequence, TimeText, 
+            pIndex->Name[current]);
+    output(pQm, print_buffer);
+    FormatJob(Pin.Job, JobText);
+    FormatObject(Pin.Object, ObjText);
+    sprintf(print_buffer, 
+            "Pinning - written by job %s program %10.10s for object %s",
+            JobText, Pin.Program, ObjText);
+    output(pQm, print_buffer);
+  }
+  else {
+    output(pQm, "Pinning - the oldest entry needed wasn't found");
+  };
+
+  /*************************************************************************/
+  /* No open commit cycle means the entry is held for media recovery -     */
+  /* recording new media images moves it on                                */
+  /*************************************************************************/
+  if (NumCycles == 0) {
+    output(pQm, "Pinning - no commit cycle was open at the oldest entry "
+                "needed, so it is held for media recovery - record media "
+                "images with RCDMQMIMG to release it");
+    free(pEntries);
+    return;
+  };
+
+  /*************************************************************************/
+  /* 3. Where the open commit cycles ended, scanning the receivers from    */
+  /* the oldest entry needed to the attached one in parallel               */
+  /*************************************************************************/
+  qsort(Cycles, NumCycles, sizeof(struct OpenCycle), CompareCycles);
+
+  Scan.pQm = pQm;
+  Scan.pIndex = pIndex;
+  memcpy(Scan.FromTime, ToTime, 17);
+  Scan.First = last;
+  Scan.Next = last;
+  Scan.Last = pIndex->Count - 1;
+  Scan.Cycles = Cycles;
+  Scan.NumCycles = NumCycles;
+  Scan.Failed = FALSE;
+  pthread_mutex_init(&Scan.Lock, NULL);
+
+  NumThreads = Scan.Last - Scan.First + 1;
+  if (NumThreads > MAX_PIN_THREADS) NumThreads = MAX_PIN_THREADS;
+  for (NumStarted = 0; NumStarted < NumThreads - 1; NumStarted++) {
+    if (pthread_create(&Threads[NumStarted], NULL, PinWorker, &Scan)) {
+      break;
+    };
+  };
+
+  PinWorker(&Scan);
+
+  for (count = 0; count < NumStarted; count++) {
+    pthread_join(Threads[count], NULL);
+  };
+  pthread_mutex_destroy(&Scan.Lock);
+
+  if (Scan.Failed) {
+    sprintf(print_buffer, 
+            "ERROR: %7.7s retrieving journal entries from %10.10s", 
+            Scan.ExceptionId, Scan.FailedRcv);
+    output_error(pQm, print_buffer);
+  };
+
+  for (pCycle = Cycles; pCycle < &Cycles[NumCycles]; pCycle++) {
+    FormatJrnTime(pCycle->Started, TRUE, TimeText);
+    FormatJob(pCycle->Job, JobText);
+    sprintf(print_buffer, 
+            "Pinning - commit cycle %lld started at %s by job %s", 
+            pCycle->Id, TimeText, JobText);
+    output(pQm, print_buffer);
+
+    if (pCycle->Ended) {
+      FormatJrnTime(pCycle->Ended, TRUE, TimeText);
+      sprintf(print_buffer, 
+              "Pinning - ... %s at %s in %10.10s - the queue manager will "
+              "move the oldest entry needed on at its next checkpoint", 
+              memcmp(pCycle->EndType, "CM", 2) ? "rolled back" : 
+              "committed", TimeText, pCycle->EndRcv);
+    }
+    else {
+      sprintf(print_buffer, 
+              "Pinning - ... is still open - a long running transaction or "
+              "an in-doubt channel");
+    };
+    output(pQm, print_buffer);
+  };
+
+  if (Untracked) {
+    sprintf(print_buffer, 
+            "Pinning - %d more commit cycle(s) were open but not tracked", 
+            Untracked);
+    output(pQm, print_buffer);
+  };
+  free(pEntries);
+}
+
+/***************************************************************************/
+/* Function:  FindOldestEntry()                                            */
+/*                                                                         */
+/* Description: Retrieve the oldest journal entry needed, from the         */
+/*              receivers attached by the time it was written, starting    */
+/*              with the oldest receiver needed.  *pEntryRcv is set to the */
+/*              receiver it is in, or -1 if it wasn't found.               */
+/*                                                                         */
+/***************************************************************************/
+static int FindOldestEntry(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                           int oldestReceiverIndex, struct JrnInf *pJrnInf,
+                           struct PlatJrnEntry *pEntry, int *pEntryRcv)
+{
+  char  print_buffer[200],
+  FromTime[17];
+  int   current,
+  NumEntries = 0,
+  more;
+  long long Sequence;
+  JrnTime   Cutoff = JrnInfTime(pJrnInf);
+  Qus_EC_t  ErrorData;
+
+  *pEntryRcv = -1;
+  memcpy(FromTime, pJrnInf->CC, 17);
+  ErrorData.Bytes_Provided = sizeof(Qus_EC_t);
+
+  for (current = oldestReceiverIndex; 
+       current < pIndex->Count && 
+       ( current == oldestReceiverIndex || 
+         pIndex->AttachTime[current] <= Cutoff ); current++) {
+    Sequence = 0;
+    ErrorData.Bytes_Available = 0;
+    if (PlatRetrieveEntries(pQm->szQmgrLib, pIndex->Name[current],
+                            FromTime, " ", ' ', "", 0, &Sequence, pEntry, 1,
+                            &NumEntries, &more, &ErrorData)) {
+      sprintf(print_buffer, 
+              "ERROR: %7.7s retrieving journal entries from %10.10s", 
+              ErrorData.Exception_Id, pIndex->Name[current]);
+      output_error(pQm, print_buffer);
+      return ERR_RETRIEVE_JRN_INF;
+    };
+    if (NumEntries == 1) {
+      *pEntryRcv = current;
+      return OK;
+    };
+  };
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  PinWorker()                                                  */
+/*                                                                         */
+/* Description: Take the next receiver and scan it for the commits and     */
+/*              rollbacks of the open commit cycles, until there are no    */
+/*              receivers left.  The first receiver is only scanned from   */
+/*              the oldest entry needed.                                   */
+/*                                                                         */
+/***************************************************************************/
+static void *PinWorker(void *pArg)
+{
+  struct PinScan *pScan = (struct PinScan*)pArg;
+  struct PlatJrnEntry *pEntries;
+  struct OpenCycle Key,
+  *pCycle;
+  int   current,
+  NumEntries,
+  count,
+  more,
+  retcode;
+  long long Sequence;
+  JrnTime   Ended;
+  Qus_EC_t  ErrorData;
+
+  pEntries = (struct PlatJrnEntry*)malloc(PIN_BLOCK * 
+                                          sizeof(struct PlatJrnEntry));
+  for (;;) {
+    pthread_mutex_lock(&pScan->Lock);
+    if (! pEntries && ! pScan->Failed) {
+      pScan->Failed = TRUE;
+      memcpy(pScan->ExceptionId, "CPF1001", 7);
+      memcpy(pScan->FailedRcv, pScan->pIndex->Name[pScan->First], 10);
+    };
+    current = pScan->Failed ? pScan->Last + 1 : pScan->Next++;
+    pthread_mutex_unlock(&pScan->Lock);
+    if (current > pScan->Last) break;
+
+    Sequence = 0;
+    ErrorData.Bytes_Provided = sizeof(Qus_EC_t);
+    do {
+      ErrorData.Bytes_Available = 0;
+      retcode = PlatRetrieveEntries(pScan->pQm->szQmgrLib, 
+                                    pScan->pIndex->Name[current],
+                                    current == pScan->First ? 
+                                    pScan->FromTime : " ", " ", 'C', 
+                                    "CMRB", 2, &Sequence, pEntries, 
+                                    PIN_BLOCK, &NumEntries, &more, 
+                                    &ErrorData);
+      for (count = 0; retcode == OK && count < NumEntries; count++) {
+        Key.Id = pEntries[count].CommitCycle;
+        pCycle = (struct OpenCycle*)bsearch(&Key, pScan->Cycles, 
+                                            pScan->NumCycles, 
+                                            sizeof(struct OpenCycle), 
+                                            CompareCycles);
+        if (! pCycle) continue;
+
+        Ended = EntryTime(pEntries[count].Time);
+        pthread_mutex_lock(&pScan->Lock);
+        if (! pCycle->Ended || Ended < pCycle->Ended) {
+          pCycle->Ended = Ended;
+          memcpy(pCycle->EndType, pEntries[count].Type, 2);
+          memcpy(pCycle->EndRcv, pScan->pIndex->Name[current], 10);
+        };
+        pthread_mutex_unlock(&pScan->Lock);
+      };
+    } while (retcode == OK && more);
+
+    if (retcode != OK) {
+      pthread_mutex_lock(&pScan->Lock);
+      if (! pScan->Failed) {
+        pScan->Failed = TRUE;
+        memcpy(pScan->ExceptionId, ErrorData.Exception_Id, 7);
+        memcpy(pScan->FailedRcv, pScan->pIndex->Name[current], 10);
+      };
+      pthread_mutex_unlock(&pScan->Lock);
+    };
+  };
+
+  if (pEntries) {
+    free(pEntries);
+  };
+  return NULL;
+}
+
+/***************************************************************************/
+/* Function:  CompareCycles()                                              */
+/***************************************************************************/
+static int CompareCycles(const void *p1, const void *p2)
+{
+  long long Id1 = ((struct OpenCycle*)p1)->Id,
+  Id2 = ((struct OpenCycle*)p2)->Id;
+
+  return Id1 < Id2 ? -1 : (Id1 > Id2 ? 1 : 0);
+}
+
+/***************************************************************************/
+/* Function:  EntryTime()                                                  */
+/*                                                                         */
+/* Description: A journal entry's time, YYYYMMDDHHMISS999                  */
+/*                                                                         */
+/***************************************************************************/
+static JrnTime EntryTime(char *Time)
+{
+  return CivilSeconds(Digits(Time, 4), Digits(Time + 4, 2), 
+                      Digits(Time + 6, 2), Digits(Time + 8, 2), 
+                      Digits(Time + 10, 2), Digits(Time + 12, 2)) * 1000 +
+         Digits(Time + 14, 3);
+}
+
+/***************************************************************************/
+/* Function:  FormatJob()                                                  */
+/*                                                                         */
+/* Description: Job name, user and number as number/user/name              */
+/*                                                                         */
+/***************************************************************************/
+static void FormatJob(char *Job, char *Text)
+{
+  int   nameLen = 10,
+  userLen = 10;
+
+  while (nameLen > 1 && Job[nameLen - 1] == ' ') nameLen--;
+  while (userLen > 1 && Job[10 + userLen - 1] == ' ') userLen--;
+  sprintf(Text, "%6.6s/%.*s/%.*s", Job + 20, userLen, Job + 10, 
+          nameLen, Job);
+}
+
+/***************************************************************************/
+/* Function:  FormatObject()                                               */
+/*                                                                         */
+/* Description: Object name, library and member as library/name(member),  */
+/*              without the member if there isn't one, or *NONE if the     */
+/*              entry isn't for an object                                  */
+/*                                                                         */
+/***************************************************************************/
+static void FormatObject(char *Object, char *Text)
+{
+  int   nameLen = 10,
+  libLen = 10,
+  mbrLen = 10;
+
+  while (nameLen > 0 && Object[nameLen - 1] == ' ') nameLen--;
+  while (libLen > 0 && Object[10 + libLen - 1] == ' ') libLen--;
+  while (mbrLen > 0 && Object[20 + mbrLen - 1] == ' ') mbrLen--;
+  if (nameLen == 0) {
+    strcpy(Text, "*NONE");
+  }
+  else if (mbrLen == 0) {
+    sprintf(Text, "%.*s/%.*s", libLen, Object + 10, nameLen, Object);
+  }
+  else {
+    sprintf(Text, "%.*s/%.*s(%.*s)", libLen, Object + 10, nameLen, Object,
+            mbrLen, Object + 20);
+  };
+}
+
+/***************************************************************************/
+/* Function:  ChangeJournal()                                              */
+/*                                                                         */
+/* Description: CHGJRN JRNRCV(*GEN) for the queue manager's AMQAJRN        */
+/*                                                                         */
+/***************************************************************************/
+static int ChangeJournal(struct QmgrMaint *pQm)
+{
+  char  print_buffer[200];
+  Qus_EC_t  ErrorData;
+
+  ErrorData.Bytes_Available = 0;
+  ErrorData.Bytes_Provided =  sizeof(Qus_EC_t);
+  if (PlatChangeJournal(pQm->szQmgrLib, &ErrorData)) {
+    sprintf(print_buffer, 
+            "ERROR: %7.7s from CHGJRN of AMQAJRN in %s.  "
+            "See job log for details", 
+            ErrorData.Bytes_Available ? ErrorData.Exception_Id : "       ",
+            pQm->szQmgrLib);
+    output_error(pQm, print_buffer);
+    return ERR_CHGJRN_FAILED;
+  };
+
+  output(pQm, "Attached a new receiver to AMQAJRN (CHGJRN JRNRCV(*GEN))");
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  RecordPinnedImages()                                         */
+/*                                                                         */
+/* Description: MEDIAIMG(*YES) - rather than RCDMQMIMG OBJ(*ALL), record   */
+/*              the media image of just the object whose entry is the      */
+/*              oldest one needed, find the cutoff again, and delete (or   */
+/*              report) the receivers that released.  Then the same for    */
+/*              the object holding the new cutoff, until the attached      */
+/*              receiver is the oldest one needed, IMGMAX images have been */
+/*              recorded, or the oldest entry needed isn't held for media  */
+/*              recovery.  IMGWAIT spreads the images out, so the queue    */
+/*              manager isn't writing them all at once.                    */
+/*                                                                         */
+/*              The entry names the object's file, not the MQ object, so   */
+/*              the MQ object is looked up from it (PlatFindMQObject).     */
+/*              When there isn't one, OBJ(*ALL) is recorded instead, and   */
+/*              that is the last image.                                    */
+/*                                                                         */
+/***************************************************************************/
+static int RecordPinnedImages(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                              int oldestReceiverIndex, struct JrnInf *pJrnInf,
+                              int *pDeleteCount)
+{
+  struct JrnMaintConfig *pConfig = pQm->pConfig;
+  struct JrnInf JrnInf = *pJrnInf;
+  struct PlatJrnEntry Pin;
+  char  print_buffer[300],
+  TimeText[24],
+  ObjText[34],
+  ObjName[49],
+  ObjType[11];
+  int   retcode = OK,
+  failed = OK,
+  all = FALSE,
+  oldest,
+  newOldest,
+  entryRcv,
+  count,
+  deletecount,
+  images = 0,
+  released = 0;
+  long long releasedK = 0,
+  stepK,
+  startTime,
+  stepMicros,
+  totalMicros = 0,
+  waited;
+  JrnTime   Cutoff;
+  Qus_EC_t  ErrorData;
+
+  if (! pQm->QmgrName[0]) FindQmgrName(pQm);
+
+  /*************************************************************************/
+  /* What CHGJRN and the queue manager's own checkpoints released first    */
+  /*************************************************************************/
+  stepK = 0;
+  for (count = 0; count < oldestReceiverIndex; count++) {
+    stepK += (long long)pIndex->SizeK[count] * pQm->SizeMult;
+  };
+  sprintf(print_buffer, "Media images - before recording any, %d "
+          "receiver(s), %lld K are not needed", 
+          oldestReceiverIndex > 0 ? oldestReceiverIndex : 0, stepK);
+  output(pQm, print_buffer);
+
+  for (;;) {
+
+    /***********************************************************************/
+    /* Drop the receivers deleted last time round and find the oldest one  */
+    /* needed now                                                          */
+    /***********************************************************************/
+    RemoveDeletedReceivers(pQm, pIndex);
+    Cutoff = JrnInfTime(&JrnInf);
+    oldest = FindOldestNeeded(pIndex, Cutoff);
+    if (oldest < 0 || oldest >= pIndex->Count - 1) {
+      output(pQm, "Media images - the attached receiver is the oldest "
+             "one needed");
+      break;
+    };
+    if (images >= pConfig->MaxImages) {
+      sprintf(print_buffer, "Media images - stopping after IMGMAX(%d), "
+              "%10.10s is the oldest receiver needed", 
+              pConfig->MaxImages, pIndex->Name[oldest]);
+      output(pQm, print_buffer);
+      break;
+    };
+
+    /***********************************************************************/
+    /* The oldest entry needed says which object's image holds it back     */
+    /***********************************************************************/
+    retcode = FindOldestEntry(pQm, pIndex, oldest, &JrnInf, &Pin, 
+                              &entryRcv);
+    if (retcode != OK) break;
+    if (entryRcv < 0) {
+      output(pQm, "Media images - the oldest entry needed wasn't found");
+      break;
+    };
+    if (Pin.CommitCycle != 0) {
+      sprintf(print_buffer, "Media images - the oldest entry needed is in "
+              "commit cycle %lld, not held for media recovery - see "
+              "FINDPIN(*YES)", Pin.CommitCycle);
+      output(pQm, print_buffer);
+      break;
+    };
+    FormatObject(Pin.Object, ObjText);
+    if (PlatFindMQObject(pQm->szQmgrLib, pQm->QmgrName, Pin.Object,
+                         ObjName, ObjType)) {
+      sprintf(print_buffer, "Media images - no MQ object found for the "
+              "oldest entry needed (object %s), recording them all", 
+              ObjText);
+      output(pQm, print_buffer);
+      strcpy(ObjName, "*ALL");
+      strcpy(ObjType, "*ALL");
+      all = TRUE;
+    };
+
+    /***********************************************************************/
+    /* IMGWAIT between images - stopping early if the job is ending        */
+    /***********************************************************************/
+    for (waited = 0; images > 0 && waited < pConfig->ImageWait &&
+         ! (pConfig->pStop && *pConfig->pStop); waited++) {
+      sleep(1);
+    };
+    if (pConfig->pStop && *pConfig->pStop) break;
+
+    ErrorData.Bytes_Available = 0;
+    ErrorData.Bytes_Provided =  sizeof(Qus_EC_t);
+    startTime = PlatMicroseconds();
+    if (PlatRecordImage(pQm->szQmgrLib, pQm->QmgrName, ObjName, ObjType,
+                        &ErrorData)) {
+      sprintf(print_buffer, 
+              "ERROR: %7.7s from RCDMQMIMG of %s (%s).  See job log for "
+              "details",
+              ErrorData.Bytes_Available ? ErrorData.Exception_Id : "       ",
+              ObjName, ObjType);
+      output_error(pQm, print_buffer);
+      retcode = ERR_RCDMQMIMG;
+      break;
+    };
+    stepMicros = PlatMicroseconds() - startTime;
+    totalMicros += stepMicros;
+    images++;
+    pQm->Metrics.Images++;
+
+    /***********************************************************************/
+    /* See how far the oldest entry needed moved on, and what it released  */
+    /***********************************************************************/
+    retcode = ReadJrnInf(pQm, &JrnInf);
+    if (retcode != OK) break;
+    newOldest = FindOldestNeeded(pIndex, JrnInfTime(&JrnInf));
+    stepK = 0;
+    for (count = oldest; count < newOldest; count++) {
+      stepK += (long long)pIndex->SizeK[count] * pQm->SizeMult;
+    };
+    if (newOldest > oldest) {
+      released += newOldest - oldest;
+      releasedK += stepK;
+    };
+    FormatJrnTime(JrnInfTime(&JrnInf), TRUE, TimeText);
+    sprintf(print_buffer, "Media images - RCDMQMIMG of %s (%s) took %lld "
+            "ms, released %d receiver(s), %lld K - oldest entry needed now "
+            "(%s) in %10.10s", ObjName, ObjType, stepMicros / 1000,
+            newOldest > oldest ? newOldest - oldest : 0, stepK, TimeText,
+            pIndex->Name[newOldest >= 0 ? newOldest : 0]);
+    output(pQm, print_buffer);
+
+    if (JrnInfTime(&JrnInf) <= Cutoff) {
+      output(pQm, "Media images - the oldest entry needed didn't move on");
+      break;
+    };
+
+    /***********************************************************************/
+    /* Apply the retention policy to the receivers released and delete    */
+    /* them.  A failed delete is kept for the result, but the images go on */
+    /***********************************************************************/
+    if (newOldest > oldest) {
+      retcode = PlanDeletes(pQm, pIndex, newOldest);
+      if (retcode != OK) break;
+      retcode = ProcessEligible(pQm, pIndex, newOldest, &deletecount);
+      *pDeleteCount += deletecount;
+      if (retcode == ERR_DELETE_FAILED) {
+        failed = retcode;
+        retcode = OK;
+      };
+      if (retcode != OK) break;
+    };
+    if (all) break;
+  };
+
+  RecordCutoff(pQm, pIndex, FindOldestNeeded(pIndex, JrnInfTime(&JrnInf)),
+               &JrnInf);
+  *pJrnInf = JrnInf;
+
+  sprintf(print_buffer, "Media images - %d recorded in %lld ms, released "
+          "%d more receiver(s), %lld K", images, totalMicros / 1000, 
+          released, releasedK);
+  output(pQm, print_buffer);
+  return retcode != OK ? retcode : failed;
+}
+
+/***************************************************************************/
+/* Function:  FindQmgrName()                                               */
+/*                                                                         */
+/* Description: The queue manager's name, for MQMNAME - from the           */
+/*              QueueManager stanza in mqs.ini with its library.  The      */
+/*              library name is used if there isn't one.                   */
+/*                                                                         */
+/***************************************************************************/
+static void FindQmgrName(struct QmgrMaint *pQm)
+{
+  int   inQmgrStanza = FALSE,
+  libMatch = FALSE,
+  len;
+  char  line[256],
+  print_buffer[200],
+  Name[49] = "",
+  *p;
+  FILE *fp;
+
+  fp = fopen(MQS_INI_PATH, "r");
+  while (fp && ! (libMatch && Name[0]) && fgets(line, sizeof(line), fp)) {
+    if (! isspace(line[0])) {
+      inQmgrStanza = ! strncmp(line, "QueueManager:", 13);
+      libMatch = FALSE;
+      Name[0] = '\0';
+      continue;
+    };
+    if (! inQmgrStanza) continue;
+
+    for (p = line; isspace(*p); p++);
+    if (! strncmp(p, "Name=", 5)) {
+      p += 5;
+      for (len = 0; p[len] && ! isspace(p[len]) && len < 48; len++);
+      memcpy(Name, p, len);
+      Name[len] = '\0';
+    } else if (! strncmp(p, "Library=", 8)) {
+      p += 8;
+      for (len = 0; p[len] && ! isspace(p[len]); len++);
+      libMatch = len == strlen(pQm->szQmgrLib);
+      for (len--; libMatch && len >= 0; len--) {
+        libMatch = toupper(p[len]) == pQm->szQmgrLib[len];
+      };
+    };
+  };
+  if (fp) fclose(fp);
+
+  if (libMatch && Name[0]) {
+    strcpy(pQm->QmgrName, Name);
+    return;
+  };
+
+  strcpy(pQm->QmgrName, pQm->szQmgrLib);
+  sprintf(print_buffer, "Queue manager for library %s not found in %s - "
+          "using MQMNAME(%s)", pQm->szQmgrLib, MQS_INI_PATH, 
+          pQm->QmgrName);
+  output_detail(pQm, print_buffer);
+}
+
+/***************************************************************************/
+/* Function:  JournalExit()                                                */
+/*                                                                         */
+/* Description: Delete Journal Receiver exit program.  Every DLTJRNRCV in  */
+/*              the job - from MQJRNMNT, an operator or a backup product - */
+/*              calls this to ask whether the receiver may be deleted.     */
+/*              Receivers of AMQAJRN that the queue manager still needs    */
+/*              are refused; all other receivers are eligible.             */
+/*                                                                         */
+/*              Each call only reads AMQJRNINF and the attached receiver   */
+/*              name.  While neither changes the answer comes from a hash  */
+/*              set of the receivers that can be deleted, so a bulk delete */
+/*              doesn't retrieve the receiver chain once per receiver.     */
+/*              The set is kept in static storage, so the program must     */
+/*              run in a named activation group.                           */
+/*                                                                         */
+/***************************************************************************/
+void JournalExit(char *ExitInfo, char *pReturnCode)
+{
+  struct DRCV0100  *pExitInfo = (struct DRCV0100*)ExitInfo;
+  struct ExitCache *pCache;
+  struct JrnInf     JrnInf;
+  char              AttRcvName[10];
+  int               retcode;
+
+  *pReturnCode = EXIT_ELIGIBLE;
+  if (memcmp(pExitInfo->JrnName, JRN_NAME, 10)) {
+    return;                                       /* Not an MQ journal    */
+  };
+
+  InitLogClock();
+  pthread_mutex_lock(&Exit.Lock);
+
+  pCache = FindExitCache(pExitInfo->JrnLib);
+
+  /*************************************************************************/
+  /* Without AMQJRNINF this isn't (or is no longer) a queue manager        */
+  /* library, so there's nothing to protect - and nothing worth keeping a  */
+  /* slot of the cache for                                                 */
+  /*************************************************************************/
+  retcode = ReadJrnInf(&pCache->Qm, &JrnInf);
+  if (retcode == ERR_USER_SPACE_MISSING) {
+    DropExitCache(pCache);
+  }
+  else if (retcode != OK) {
+    pCache->Valid = FALSE;
+    *pReturnCode = EXIT_NOT_ELIGIBLE;
+  }
+  else {
+    retcode = GetAttachedReceiver(&pCache->Qm, AttRcvName);
+    if (retcode == OK &&
+        ( ! pCache->Valid ||
+          memcmp(&JrnInf, &pCache->JrnInf, sizeof(JrnInf)) ||
+          memcmp(AttRcvName, pCache->AttRcv, 10) )) {
+      retcode = RefreshExitCache(pCache, &JrnInf, AttRcvName);
+    };
+    if (retcode != OK || ! IsDeletable(pCache, pExitInfo->RcvName)) {
+      *pReturnCode = EXIT_NOT_ELIGIBLE;
+    };
+  };
+
+  pthread_mutex_unlock(&Exit.Lock);
+}
+
+/***************************************************************************/
+/* Function:  FindExitCache()                                              */
+/*                                                                         */
+/* Description: The exit program's cache for a queue manager library,      */
+/*              added if it is new.  When all MAX_EXIT_QMGRS slots are in  */
+/*              use the least recently used one is given up for it, so a   */
+/*              library is only ever slower to answer for, never refused.  */
+/*              Nobody reads the exit program's output, so its contexts    */
+/*              use LOG_NONE.                                              */
+/*                                                                         */
+/***************************************************************************/
+static struct ExitCache *FindExitCache(char *QmgrLib)
+{
+  struct ExitCache *pCache;
+  int   count;
+
+  Exit.Clock++;
+  for (count = 0; count < Exit.NumCaches; count++) {
+    if (! memcmp(Exit.Caches[count].Qm.QmgrLib, QmgrLib, 10)) {
+      Exit.Caches[count].LastUsed = Exit.Clock;
+      return &Exit.Caches[count];
+    };
+  };
+
+  if (Exit.Clock == 1) {
+    JrnMaintInitConfig(&Exit.Config);
+    Exit.Config.LogLevel = LOG_NONE;
+  };
+
+  if (Exit.NumCaches < MAX_EXIT_QMGRS) {
+    pCache = &Exit.Caches[Exit.NumCaches++];
+  }
+  else {
+    pCache = &Exit.Caches[0];
+    for (count = 1; count < Exit.NumCaches; count++) {
+      if (Exit.Caches[count].LastUsed < pCache->LastUsed) {
+        pCache = &Exit.Caches[count];
+      };
+    };
+    FreeQmgr(&pCache->Qm);
+    if (pCache->Deletable) free(pCache->Deletable);
+  };
+
+  memset(pCache, 0, sizeof(struct ExitCache));
+  InitQmgr(&Exit.Config, &pCache->Qm, QmgrLib, 10);
+  pCache->LastUsed = Exit.Clock;
+  return pCache;
+}
+
+/***************************************************************************/
+/* Function:  DropExitCache()                                              */
+/*                                                                         */
+/* Description: Give up a slot of the exit program's cache, moving the     */
+/*              last slot into its place                                   */
+/*                                                                         */
+/***************************************************************************/
+static void DropExitCache(struct ExitCache *pCache)
+{
+  FreeQmgr(&pCache->Qm);
+  if (pCache->Deletable) free(pCache->Deletable);
+
+  Exit.NumCaches--;
+  if (pCache != &Exit.Caches[Exit.NumCaches]) {
+    memcpy(pCache, &Exit.Caches[Exit.NumCaches], sizeof(struct ExitCache));
+  };
+}
+
+/***************************************************************************/
+/* Function:  RefreshExitCache()                                           */
+/*                                                                         */
+/* Description: Work out the cutoff again and rebuild the set of           */
+/*              receivers that can be deleted                              */
+/*                                                                         */
+/***************************************************************************/
+static int RefreshExitCache(struct ExitCache *pCache, struct JrnInf *pJrnInf,
+                            char *AttRcvName)
+{
+  int   retcode,
+  NumRcvrs = 0,
+  oldestReceiverIndex,
+  count;
+  unsigned int slot;
+  char *JrnData = 0;
+  char (*pDeletable)[10];
+  Qjo_JN_Repeating_Key_1_Output_t *pRcvDirectory = 0;
+  struct RcvIndex RcvIndex = {0, 0, 0, 0, 0, 0, 0};
+
+  pCache->Valid = FALSE;
+
+  retcode = GetReceiverChain(&pCache->Qm, &NumRcvrs, &JrnData, 
+                             &pRcvDirectory);
+  if (retcode == OK) {
+    retcode = BuildReceiverIndex(pRcvDirectory, NumRcvrs, &RcvIndex);
+  };
+  if (JrnData) {
+    free(JrnData);
+  };
+
+  if (retcode == OK) {
+    oldestReceiverIndex = FindOldestNeeded(&RcvIndex, JrnInfTime(pJrnInf));
+
+    /***********************************************************************/
+    /* Size the set for a load factor of no more than a half               */
+    /***********************************************************************/
+    if (pCache->HashSize < 2 * RcvIndex.Count || ! pCache->Deletable) {
+      for (pCache->HashSize = 64; pCache->HashSize < 2 * RcvIndex.Count; )
+        pCache->HashSize *= 2;
+      pDeletable = (char(*)[10])realloc(pCache->Deletable, 
+                                        10 * pCache->HashSize);
+      if (! pDeletable) {
+        FreeReceiverIndex(&RcvIndex);
+        pCache->HashSize = 0;
+        return ERR_MEMORY_ERROR;
+      };
+      pCache->Deletable = pDeletable;
+    };
+    memset(pCache->Deletable, 0, 10 * pCache->HashSize);
+
+    for (count = 0; count < oldestReceiverIndex; count++) {
+      slot = HashReceiver(RcvIndex.Name[count]) & (pCache->HashSize - 1);
+      while (pCache->Deletable[slot][0]) {
+        slot = (slot + 1) & (pCache->HashSize - 1);
+      };
+      memcpy(pCache->Deletable[slot], RcvIndex.Name[count], 10);
+    };
+
+    memcpy(&pCache->JrnInf, pJrnInf, sizeof(struct JrnInf));
+    memcpy(pCache->AttRcv, AttRcvName, 10);
+    pCache->Valid = TRUE;
+  };
+
+  FreeReceiverIndex(&RcvIndex);
+  return retcode;
+}
+
+/***************************************************************************/
+/* Function:  HashReceiver()                                               */
+/*                                                                         */
+/* Description: FNV-1a hash of a receiver name                             */
+/*                                                                         */
+/***************************************************************************/
+static unsigned int HashReceiver(char *RcvName)
+{
+  unsigned int hash = 2166136261u;
+  int   count;
+
+  for (count = 0; count < 10; count++) {
+    hash = (hash ^ (unsigned char)RcvName[count]) * 16777619u;
+  };
+  return hash;
+}
+
+/***************************************************************************/
+/* Function:  IsDeletable()                                                */
+/***************************************************************************/
+static int IsDeletable(struct ExitCache *pCache, char *RcvName)
+{
+  unsigned int slot;
+
+  if (! pCache->Deletable) return FALSE;
+
+  slot = HashReceiver(RcvName) & (pCache->HashSize - 1);
+  while (pCache->Deletable[slot][0]) {
+    if (! memcmp(pCache->Deletable[slot], RcvName, 10)) return TRUE;
+    slot = (slot + 1) & (pCache->HashSize - 1);
+  };
+  return FALSE;
+}
+
+/***************************************************************************/
+/* Function:  FindOldestNeeded()                                           */
+/*                                                                         */
+/* Description: Binary search the index for the newest receiver attached   */
+/*              before Cutoff.  Receivers are attached in time order, so   */
+/*              attach times increase along the chain.                     */
+/*                                                                         */
+/*              Attach times are only to the second, so a receiver only    */
+/*              counts as attached before the cutoff if the whole of its   */
+/*              second is.  A receiver attached in the same second as the  */
+/*              oldest entry might have been attached after it, so the     */
+/*              receiver before it is kept too.                            */
+/*                                                                         */
+/* Returns:     Index of the oldest receiver to keep, or -1 if the cutoff  */
+/*              is before every receiver in the index                      */
+/*                                                                         */
+/***************************************************************************/
+static int FindOldestNeeded(struct RcvIndex *pIndex, JrnTime Cutoff)
+{
+  int   low = 0,
+  high = pIndex->Count,
+  mid;
+
+  /*************************************************************************/
+  /* Find the first receiver that may have been attached at or after the   */
+  /* cutoff...                                                             */
+  /*************************************************************************/
+  while (low < high) {
+    mid = low + (high - low) / 2;
+    if ( pIndex->AttachTime[mid] + RCV_TIME_RESOLUTION - 1 < Cutoff )
+      low = mid + 1;
+    else
+      high = mid;
+  };
+
+  /*************************************************************************/
+  /* ...the receiver before it is the one containing the oldest entry      */
+  /*************************************************************************/
+  return low - 1;
+}
+
+/***************************************************************************/
+/* Function:  BuildReceiverIndex()                                         */
+/*                                                                         */
+/* Description: Build the compact receiver index from the receiver entries */
+/*              returned by GetReceiverChain()                             */
+/*                                                                         */
+/***************************************************************************/
+static int BuildReceiverIndex(Qjo_JN_Repeating_Key_1_Output_t *pRcvDirectory,
+                              int NumRcvrs, struct RcvIndex *pIndex)
+{
+  int   count;
+
+  pIndex->Count = 0;
+  if (GrowReceiverIndex(pIndex, NumRcvrs) != OK) {
+    return ERR_MEMORY_ERROR;
+  };
+
+  for (count = 0; count < NumRcvrs; count++) {
+    SetIndexEntry(pIndex, count, &pRcvDirectory[count]);
+  };
+  pIndex->Count = NumRcvrs;
+
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  SyncReceiverIndex()                                          */
+/*                                                                         */
+/* Description: Bring a cached receiver index up to date with a newly      */
+/*              retrieved chain.  Receivers attached since the index was   */
+/*              built are appended, and any deleted by something else are  */
+/*              dropped from the front.  If the newest cached receiver is  */
+/*              no longer in the chain the index is rebuilt.               */
+/*                                                                         */
+/***************************************************************************/
+static int SyncReceiverIndex(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                             Qjo_JN_Repeating_Key_1_Output_t *pRcvDirectory,
+                             int NumRcvrs)
+{
+  int   count,
+  matched = -1;
+  char  print_buffer[200];
+
+  /*************************************************************************/
+  /* Find the newest cached receiver, searching from the newest end of the */
+  /* chain as that is where it will normally be                            */
+  /*************************************************************************/
+  if (pIndex->Count > 0) {
+    for (count = NumRcvrs - 1; count >= 0; count--) {
+      if (! memcmp(pRcvDirectory[count].Jrn_Rcv_Name, 
+                   pIndex->Name[pIndex->Count - 1], 10)) {
+        matched = count;
+        break;
+      };
+    };
+  };
+
+  if (matched < 0 || matched + 1 > pIndex->Count ||
+      memcmp(pRcvDirectory[0].Jrn_Rcv_Name,
+             pIndex->Name[pIndex->Count - matched - 1], 10)) {
+    if (pIndex->Count > 0) {
+      sprintf(print_buffer, 
+              "Receiver chain for AMQAJRN in %10.10s has changed - "
+              "rebuilding index", pQm->QmgrLib);
+      output(pQm, print_buffer);
+    };
+    return BuildReceiverIndex(pRcvDirectory, NumRcvrs, pIndex);
+  };
+
+  /*************************************************************************/
+  /* Drop receivers deleted since we last looked, then append the new ones */
+  /*************************************************************************/
+  RemoveOldestReceivers(pIndex, pIndex->Count - (matched + 1));
+
+  /*************************************************************************/
+  /* Only the names and attach times of the receivers already in the index */
+  /* stay the same - the receiver that was attached has since been         */
+  /* detached, a backup may have saved others, and sizes change            */
+  /*************************************************************************/
+  for (count = 0; count <= matched; count++) {
+    pIndex->Status[count] = pRcvDirectory[count].Jrn_Rcv_Status;
+    pIndex->SizeK[count] = pRcvDirectory[count].Jrn_Rcv_Size;
+  };
+
+  if (GrowReceiverIndex(pIndex, NumRcvrs) != OK) {
+    return ERR_MEMORY_ERROR;
+  };
+  for (count = matched + 1; count < NumRcvrs; count++) {
+    SetIndexEntry(pIndex, count, &pRcvDirectory[count]);
+  };
+  pIndex->Count = NumRcvrs;
+
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  RemoveOldestReceivers()                                      */
+/*                                                                         */
+/* Description: Drop the oldest Count receivers from the index             */
+/*                                                                         */
+/***************************************************************************/
+static void RemoveOldestReceivers(struct RcvIndex *pIndex, int Count)
+{
+  if (Count <= 0) return;
+  if (Count > pIndex->Count) Count = pIndex->Count;
+
+  pIndex->Count -= Count;
+  memmove(pIndex->Number, pIndex->Number + Count, 
+          sizeof(int) * pIndex->Count);
+  memmove(pIndex->AttachTime, pIndex->AttachTime + Count, 
+          sizeof(long long) * pIndex->Count);
+  memmove(pIndex->Name, pIndex->Name + Count, 10 * pIndex->Count);
+  memmove(pIndex->Status, pIndex->Status + Count, pIndex->Count);
+  memmove(pIndex->SizeK, pIndex->SizeK + Count, 
+          sizeof(int) * pIndex->Count);
+}
+
+/***************************************************************************/
+/* Function:  RemoveDeletedReceivers()                                     */
+/*                                                                         */
+/* Description: Drop the receivers recorded in pQm->Deletes as deleted     */
+/*              from the index.  The retention policy may have kept some   */
+/*              older receivers, so they are not always the oldest ones.  */
+/*              Both are in chain order, so one pass over each will do.    */
+/*                                                                         */
+/***************************************************************************/
+static void RemoveDeletedReceivers(struct QmgrMaint *pQm,
+                                   struct RcvIndex *pIndex)
+{
+  int   count,
+  kept = 0,
+  next = 0;
+
+  for (count = 0; count < pIndex->Count; count++) {
+    if (next < pQm->NumDeletes &&
+        ! memcmp(pIndex->Name[count], pQm->Deletes[next].Name, 10)) {
+      if (pQm->Deletes[next++].ExceptionId[0] == ' ') continue;
+    };
+    if (kept != count) {
+      pIndex->Number[kept] = pIndex->Number[count];
+      pIndex->AttachTime[kept] = pIndex->AttachTime[count];
+      memcpy(pIndex->Name[kept], pIndex->Name[count], 10);
+      pIndex->Status[kept] = pIndex->Status[count];
+      pIndex->SizeK[kept] = pIndex->SizeK[count];
+    };
+    kept++;
+  };
+  pIndex->Count = kept;
+}
+
+/***************************************************************************/
+/* Function:  GrowReceiverIndex()                                          */
+/*                                                                         */
+/* Description: Make sure the index has room for NumRcvrs receivers,       */
+/*              keeping the entries it already holds                       */
+/*                                                                         */
+/***************************************************************************/
+static int GrowReceiverIndex(struct RcvIndex *pIndex, int NumRcvrs)
+{
+  int        *pNumber;
+  JrnTime    *pAttachTime;
+  char      (*pName)[10],
+  *pStatus;
+  int        *pSizeK;
+
+  if (NumRcvrs < pIndex->Size && pIndex->Name) return OK;
+
+  NumRcvrs += SPARE_CHAIN;
+  pNumber = (int*)realloc(pIndex->Number, sizeof(int) * NumRcvrs);
+  if (pNumber) pIndex->Number = pNumber;
+  pAttachTime = (JrnTime*)realloc(pIndex->AttachTime, 
+                                  sizeof(JrnTime) * NumRcvrs);
+  if (pAttachTime) pIndex->AttachTime = pAttachTime;
+  pName = (char(*)[10])realloc(pIndex->Name, 10 * NumRcvrs);
+  if (pName) pIndex->Name = pName;
+  pStatus = (char*)realloc(pIndex->Status, NumRcvrs);
+  if (pStatus) pIndex->Status = pStatus;
+  pSizeK = (int*)realloc(pIndex->SizeK, sizeof(int) * NumRcvrs);
+  if (pSizeK) pIndex->SizeK = pSizeK;
+
+  if ( ! pNumber || ! pAttachTime || ! pName || ! pStatus || ! pSizeK ) {
+    FreeReceiverIndex(pIndex);
+    return ERR_MEMORY_ERROR;
+  };
+
+  pIndex->Size = NumRcvrs;
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  SetIndexEntry()                                              */
+/*                                                                         */
+/* Description: Set index entry Entry from a receiver directory entry      */
+/*                                                                         */
+/***************************************************************************/
+static void SetIndexEntry(struct RcvIndex *pIndex, int Entry,
+                          Qjo_JN_Repeating_Key_1_Output_t *pRcvr)
+{
+  int   digit;
+  char *pName = pRcvr->Jrn_Rcv_Name;
+
+  memcpy(pIndex->Name[Entry], pName, 10);
+  pIndex->AttachTime[Entry] = RcvAttachTime(pRcvr->Jrn_Rcv_Att_Date_Time);
+  pIndex->Status[Entry] = pRcvr->Jrn_Rcv_Status;
+  pIndex->SizeK[Entry] = pRcvr->Jrn_Rcv_Size;
+
+  /*************************************************************************/
+  /* The receiver number is the numeric suffix of the name (AMQAnnnnnn)    */
+  /*************************************************************************/
+  pIndex->Number[Entry] = 0;
+  for (digit = 0; digit < 10; digit++) {
+    if ( isdigit(pName[digit]) )
+      pIndex->Number[Entry] = pIndex->Number[Entry] * 10 + 
+                              (pName[digit] - '0');
+    else if ( pName[digit] != ' ' )
+      pIndex->Number[Entry] = 0;
+  };
+}
+
+/***************************************************************************/
+/* Function:  FreeReceiverIndex()                                          */
+/***************************************************************************/
+static void FreeReceiverIndex(struct RcvIndex *pIndex)
+{
+  if (pIndex->Number) free(pIndex->Number);
+  if (pIndex->AttachTime) free(pIndex->AttachTime);
+  if (pIndex->Name) free(pIndex->Name);
+  if (pIndex->Status) free(pIndex->Status);
+  if (pIndex->SizeK) free(pIndex->SizeK);
+  pIndex->Number = 0;
+  pIndex->Status = 0;
+  pIndex->SizeK = 0;
+  pIndex->AttachTime = 0;
+  pIndex->Name = 0;
+  pIndex->Count = 0;
+  pIndex->Size = 0;
+}
+
+/***************************************************************************/
+/* Function:  output()                                                     */
+/*                                                                         */
+/* Description: Print messages preceded by a timestamp or send to          */
+/*              the queue manager message queue depending on the           */
+/*              OUTPUT() options specified.  Output for no particular      */
+/*              queue manager (pQm == 0) is always printed, and printed    */
+/*              output is held while several queue managers are processed  */
+/*              in parallel.  Lines for the message queue are collected    */
+/*              and sent as a few longer messages by SendMessages().       */
+/*                                                                         */
+/***************************************************************************/
+void output(struct QmgrMaint *pQm, char *print_buffer) 
+{
+  char      hhmmss[9],
+  line[420];
+  int       len;
+
+  if (pQm && pQm->pConfig->LogLevel == LOG_NONE) return;
+
+  if (! pQm || pQm->pConfig->PrintOutput) {
+    LogTime(hhmmss);
+    sprintf(line, "%s-%.400s \n", hhmmss, print_buffer);
+    HoldOutput(pQm, line);
+  }
+  else {
+    len = strlen(print_buffer);
+    if (pQm->MsgLen && pQm->MsgLen + len + 2 > MSG_TEXT_MAX) {
+      SendMessages(pQm);
+    };
+    if (len + 2 > MSG_TEXT_MAX) len = MSG_TEXT_MAX - 2;
+    if (pQm->MsgLen) {
+      memcpy(pQm->MsgBuf + pQm->MsgLen, "; ", 2);
+      pQm->MsgLen += 2;
+    };
+    memcpy(pQm->MsgBuf + pQm->MsgLen, print_buffer, len);
+    pQm->MsgLen += len;
+  };
+}
+
+/***************************************************************************/
+/* Function:  output_detail()                                              */
+/*                                                                         */
+/* Description: Output a line about a single receiver - only when         */
+/*              DETAIL(*RECEIVER) is in effect                             */
+/*                                                                         */
+/***************************************************************************/
+static void output_detail(struct QmgrMaint *pQm, char *print_buffer)
+{
+  if (pQm->pConfig->LogLevel >= LOG_RECEIVER) {
+    output(pQm, print_buffer);
+  };
+}
+
+/***************************************************************************/
+/* Function:  SendMessages()                                               */
+/*                                                                         */
+/* Description: Send the lines collected for the message queue as one      */
+/*              message                                                    */
+/*                                                                         */
+/***************************************************************************/
+static void SendMessages(struct QmgrMaint *pQm)
+{
+  char      line[40];
+  Qus_EC_t  ErrorData;
+
+  if (pQm->MsgLen == 0) return;
+
+  ErrorData.Bytes_Available = 0;
+  ErrorData.Bytes_Provided =  sizeof(Qus_EC_t);
+  PlatSendMessage( pQm->MsgBuf,          
+                   pQm->MsgLen,
+                   pQm->message_queue,
+                   &ErrorData);
+  pQm->MsgLen = 0;
+    
+  /*************************************************************************/
+  /* Report errors from send message                                       */
+  /*************************************************************************/
+  if ( ErrorData.Bytes_Available ) {
+    sprintf(line, "ERROR: %7.7s from QMHSNDM", ErrorData.Exception_Id);
+    output_error(pQm, line);
+  };
+}
+
+/***************************************************************************/
+/* Function:  InitLogClock()                                               */
+/*                                                                         */
+/* Description: Read the local time once at startup.  Timestamps on the    */
+/*              output are worked out from it and the elapsed time, rather */
+/*              than calling CEELOCT for every line.                       */
+/*                                                                         */
+/***************************************************************************/
+void InitLogClock(void)
+{
+  pthread_once(&LogClockOnce, SetLogClock);
+}
+
+/***************************************************************************/
+/* Function:  SetLogClock()                                                */
+/***************************************************************************/
+static void SetLogClock(void)
+{
+  char  localdatetime[23];
+
+  PlatLocalTime(localdatetime);
+  LogBaseMicros = PlatMicroseconds();
+  LogBaseSeconds = CivilSeconds(Digits(localdatetime, 4), 
+                                Digits(localdatetime + 4, 2),
+                                Digits(localdatetime + 6, 2),
+                                Digits(localdatetime + 8, 2),
+                                Digits(localdatetime + 10, 2),
+                                Digits(localdatetime + 12, 2));
+}
+
+/***************************************************************************/
+/* Function:  LocalSeconds()                                               */
+/*                                                                         */
+/* Description: The local time now, in seconds as returned by              */
+/*              CivilSeconds()                                             */
+/*                                                                         */
+/***************************************************************************/
+static long long LocalSeconds(void)
+{
+  return LogBaseSeconds + (PlatMicroseconds() - LogBaseMicros) / 1000000;
+}
+
+/***************************************************************************/
+/* Function:  LogTime()                                                    */
+/*                                                                         */
+/* Description: Local time of day as HH:MM:SS                              */
+/*                                                                         */
+/***************************************************************************/
+static void LogTime(char *HHMMSS)
+{
+  long  secs;
+
+  secs = (long)(LocalSeconds() % 86400);
+  if (secs < 0) secs += 86400;                 /* Before 1970            */
+  snprintf(HHMMSS, 9, "%02ld:%02ld:%02ld", 
+           secs / 3600, (secs / 60) % 60, secs % 60);
+}
+
+/***************************************************************************/
+/* Function:  CivilSeconds()                                               */
+/*                                                                         */
+/* Description: Seconds from 1970-01-01 00:00:00 to a date and time, with  */
+/*              no time zone applied - so only the difference between two  */
+/*              local times means anything                                 */
+/*                                                                         */
+/***************************************************************************/
+static long long CivilSeconds(int Year, int Month, int Day, int Hour,
+                              int Minute, int Second)
+{
+  long long days;
+  int   era,
+  yoe,
+  doy;
+
+  /*************************************************************************/
+  /* Days since 1970-01-01, counting years from March so the leap day is   */
+  /* the last day of the year                                              */
+  /*************************************************************************/
+  if (Month <= 2) Year--;
+  era = (Year >= 0 ? Year : Year - 399) / 400;
+  yoe = Year - era * 400;
+  doy = (153 * (Month > 2 ? Month - 3 : Month + 9) + 2) / 5 + Day - 1;
+  days = (long long)era * 146097 + 
+         yoe * 365 + yoe / 4 - yoe / 100 + doy - 719468;
+
+  return days * 86400 + Hour * 3600 + Minute * 60 + Second;
+}
+
+/***************************************************************************/
+/* Function:  Digits()                                                     */
+/*                                                                         */
+/* Description: Value of Length decimal digits (not NULL terminated)       */
+/*                                                                         */
+/***************************************************************************/
+static int Digits(char *Text, int Length)
+{
+  int   value = 0,
+  count;
+
+  for (count = 0; count < Length; count++) {
+    value = value * 10 + (Text[count] - '0');
+  };
+  return value;
+}
+
+/***************************************************************************/
+/* Function:  output_error()                                               */
+/*                                                                         */
+/* Description: Print a line without a timestamp, whatever the OUTPUT()    */
+/*              option - used for errors.  It is also kept as the          */
+/*              context's last error, which is all that is left of it     */
+/*              with LOG_NONE.                                             */
+/*                                                                         */
+/***************************************************************************/
+static void output_error(struct QmgrMaint *pQm, char *print_buffer)
+{
+  int   len;
+
+  if (pQm) {
+    len = strlen(print_buffer);
+    while (len > 0 && print_buffer[len - 1] == '\n') len--;
+    if (len >= sizeof(pQm->LastError)) len = sizeof(pQm->LastError) - 1;
+    memcpy(pQm->LastError, print_buffer, len);
+    pQm->LastError[len] = '\0';
+    if (pQm->pConfig->LogLevel == LOG_NONE) return;
+  };
+
+  HoldOutput(pQm, print_buffer);
+}
+
+/***************************************************************************/
+/* Function:  output_config_error()                                        */
+/*                                                                         */
+/* Description: An error found before there are queue manager contexts -  */
+/*              printed like output_error(), unless the settings are      */
+/*              LOG_NONE                                                   */
+/*                                                                         */
+/***************************************************************************/
+static void output_config_error(struct JrnMaintConfig *pConfig,
+                                char *print_buffer)
+{
+  if (pConfig->LogLevel == LOG_NONE) return;
+  output_error(0, print_buffer);
+}
+
+/***************************************************************************/
+/* Function:  output_config()                                              */
+/*                                                                         */
+/* Description: A line for no particular queue manager - printed like      */
+/*              output(0, ...), unless the settings are LOG_NONE           */
+/*                                                                         */
+/***************************************************************************/
+static void output_config(struct JrnMaintConfig *pConfig, char *print_buffer)
+{
+  if (pConfig->LogLevel == LOG_NONE) return;
+  output(0, print_buffer);
+}
+
+/***************************************************************************/
+/* Function:  HoldOutput()                                                 */
+/*                                                                         */
+/* Description: Print a line, or hold it with the rest of the queue        */
+/*              manager's output if that is being held                     */
+/*                                                                         */
+/***************************************************************************/
+static void HoldOutput(struct QmgrMaint *pQm, char *print_buffer)
+{
+  int   len = strlen(print_buffer),
+  newline = (len == 0 || print_buffer[len - 1] != '\n');
+  char *p;
+
+  if (! pQm || ! pQm->buffered) {
+    printf(newline ? "%s\n" : "%s", print_buffer);
+    return;
+  };
+
+  if (pQm->OutLen + len + 2 > pQm->OutSize) {
+    p = (char*)realloc(pQm->OutBuf, pQm->OutSize + len + 4096);
+    if (! p) {                            /* Can't hold it - print it now */
+      printf(newline ? "%s\n" : "%s", print_buffer);
+      return;
+    };
+    pQm->OutBuf = p;
+    pQm->OutSize += len + 4096;
+  };
+
+  memcpy(pQm->OutBuf + pQm->OutLen, print_buffer, len);
+  pQm->OutLen += len;
+  if (newline) pQm->OutBuf[pQm->OutLen++] = '\n';
+}
+
+/***************************************************************************/
+/* Function:  FlushOutput()                                                */
+/*                                                                         */
+/* Description: Print the output held for a queue manager as one block,    */
+/*              and send any lines collected for its message queue         */
+/*                                                                         */
+/***************************************************************************/
+static void FlushOutput(struct QmgrMaint *pQm)
+{
+  SendMessages(pQm);
+
+  if (pQm->OutBuf) {
+    pthread_mutex_lock(&OutputLock);
+    fwrite(pQm->OutBuf, 1, pQm->OutLen, stdout);
+    fflush(stdout);
+    pthread_mutex_unlock(&OutputLock);
+
+    free(pQm->OutBuf);
+    pQm->OutBuf = 0;
+    pQm->OutLen = pQm->OutSize = 0;
+  };
+}
+
+/***************************************************************************/
+/*                                                                         */
+/* Function:    GetAttachedReceiver                                        */
+/*                                                                         */
+/* Description: Get the name of the receiver attached to AMQAJRN.  No key  */
+/*              information is requested, so this is much cheaper than     */
+/*              retrieving the receiver chain.                             */
+/*                                                                         */
+/***************************************************************************/
+static int GetAttachedReceiver(struct QmgrMaint *pQm, char *AttRcvName)
+{
+  Qjo_RJRN0100_t  RtnJrnInf;
+  _INT4           JrnDataLen = sizeof(RtnJrnInf);
+  char            JrnName[20],
+  print_buffer[200];
+  Qus_EC_t        ErrorData;
+
+  struct KData {
+    _INT4    KeyCount;        /* Count of all keys  (=0)   */
+  } KeyData = {0};
+
+  memcpy(JrnName, JRN_NAME,10);
+  memcpy(&(JrnName[10]), pQm->QmgrLib,10);
+
+  ErrorData.Bytes_Available = 0;
+  ErrorData.Bytes_Provided =  sizeof(Qus_EC_t);
+  PlatRetrieveJournalInfo((char*)&RtnJrnInf, &JrnDataLen, JrnName,
+                          (char*)&KeyData, &ErrorData);
+
+  if ( ErrorData.Bytes_Available ) {
+    sprintf(print_buffer, 
+            "ERROR: %7.7s from QjoRetrieveJournalInformation",
+            ErrorData.Exception_Id );
+    output_error(pQm, print_buffer);
+    return ERR_RETRIEVE_JRN_INF;
+  };
+
+  memcpy(AttRcvName, RtnJrnInf.Att_Jrn_Rcv_Name, 10);
+  return OK;
+}
+
+/***************************************************************************/
+/*                                                                         */
+/* Function:    GetReceiverChain                                           */
+/*                                                                         */
+/* Description: Get the list of receivers in the current  journal          */
+/*              receiver chain.  The receiver variable is sized from the   */
+/*              bytes available reported by the API, so chains of any      */
+/*              length are returned in full.                               */
+/*                                                                         */
+/* Parameters:  pQm            - The queue manager being processed         */
+/*              NumRcvrs       - Number of receivers returned              */
+/*              ppJrnData      - Returned API buffer, freed by the caller  */
+/*              ppRcvDirectory - The journal receiver data within the      */
+/*                               returned buffer (oldest receiver first)   */
+/*                                                                         */
+/***************************************************************************/
+
+static int GetReceiverChain(struct QmgrMaint *pQm, int *NumRcvrs,
+                            char **ppJrnData,
+                            Qjo_JN_Repeating_Key_1_Output_t **ppRcvDirectory)
+{
+  Qjo_RJRN0100_t *pRtnJrnInf; 
+  int             retcode = OK,
+  attempts = 0;
+  _INT4           JrnDataLen = 0;
+  char          *JrnData = 0,
+  JrnName[20],  /* Jrn name (10) followed by lib name (10) */
+  print_buffer[200];
+  Qus_EC_t        ErrorData;
+
+  Qjo_JN_Repeating_Key_Fields_t *pKeyFld1Hdr = 
+  (Qjo_JN_Repeating_Key_Fields_t*)0;
+  Qjo_JN_Key_1_Output_Section_t *pKeyFld1OutputHdr = 
+  (Qjo_JN_Key_1_Output_Section_t*)0;
+  Qjo_JN_Repeating_Key_1_Output_t *pKeyFld1Data = 
+  (Qjo_JN_Repeating_Key_1_Output_t*)0;
+
+  struct KData {
+    _INT4    KeyCount;        /* Count of all keys  (=1)   */
+    _INT4    Len;             /* Length of this key  (=12) */
+    _INT4    KeyID;           /* Key ID              (=1)  */
+    _INT4    DataLen;         /* Length of data      (=0)  */
+  } KeyData = {1,12,1,0};
+
+  *NumRcvrs = 0;
+  *ppJrnData = 0;
+  *ppRcvDirectory = 0;
+  pQm->Metrics.ChainCalls = 0;
+  pQm->Metrics.ChainBytes = 0;
+
+  /*************************************************************************/
+  /* Set up the qualified journal name                                     */
+  /*************************************************************************/
+  memcpy(JrnName, JRN_NAME,10);
+  memcpy(&(JrnName[10]), pQm->QmgrLib,10);
+
+  /*************************************************************************/
+  /* Set up the size of the receiver variable for the first call - all the */
+  /* headers plus room for a typical chain.  Most chains fit first time.   */
+  /*************************************************************************/
+  JrnDataLen =  sizeof(Qjo_RJRN0100_t) + 
+                sizeof(Qjo_JN_Repeating_Key_Fields_t) + 
+                sizeof(Qjo_JN_Key_1_Output_Section_t) + 
+                sizeof(Qjo_JN_Repeating_Key_1_Output_t) * INITIAL_CHAIN ;
+
+  /*************************************************************************/
+  /* Get the journal receiver chain.  If the API tells us more bytes are   */
+  /* available than we provided, reallocate to the size it reported (plus */
+  /* room for receivers attached in the meantime) and call it again.       */
+  /*************************************************************************/
+  while (retcode == OK) {
+
+    JrnData = (char*)malloc(JrnDataLen);
+    if ( ! JrnData ) {
+      output_error(pQm, "ERROR: Memory allocation error (JrnData)");
+      retcode = ERR_MEMORY_ERROR;    
+      break;
+    };
+
+    ErrorData.Bytes_Available = 0;
+    ErrorData.Bytes_Provided =  sizeof(Qus_EC_t);
+    PlatRetrieveJournalInfo(JrnData, &JrnDataLen, JrnName,
+                            (char*)&KeyData, &ErrorData);
+    pQm->Metrics.ChainCalls++;
+
+    /***********************************************************************/
+    /* Print error data if the command failed                              */
+    /***********************************************************************/
+    if ( ErrorData.Bytes_Available ) {
+      sprintf(print_buffer, 
+              "ERROR: %7.7s from QjoRetrieveJournalInformation",
+              ErrorData.Exception_Id );
+      output_error(pQm, print_buffer);
+      retcode = ERR_RETRIEVE_JRN_INF;      
+      break;
+    };
+
+    pRtnJrnInf = (Qjo_RJRN0100_t*)JrnData; 
+    if ( pRtnJrnInf->Bytes_Available <= JrnDataLen )
+      break;                                   /* Whole chain returned */
+
+    /***********************************************************************/
+    /* Buffer was too small - size it from the bytes available and retry   */
+    /***********************************************************************/
+    if ( ++attempts >= MAX_RTV_ATTEMPTS ) {
+      sprintf(print_buffer, 
+              "ERROR: Receiver chain for AMQAJRN in %10.10s is still "
+              "growing after %d attempts", pQm->QmgrLib, attempts);
+      output_error(pQm, print_buffer);
+      retcode = ERR_RETRIEVE_JRN_INF;
+      break;
+    };
+
+    JrnDataLen = pRtnJrnInf->Bytes_Available + 
+                 sizeof(Qjo_JN_Repeating_Key_1_Output_t) * SPARE_CHAIN;
+    free(JrnData);
+    JrnData = 0;
+  };
+
+  /*************************************************************************/
+  /* if the API completed successfully, report the basic journal data      */
+  /*************************************************************************/
+  if (retcode == OK) {
+
+    /***********************************************************************/
+    /* Set up the receiver directory return fields                         */
+    /* The journal receiver list is returned at the end of a list of       */
+    /* chained structures - unscramble the jrnrcvr directory data          */
+    /***********************************************************************/
+    pKeyFld1Hdr = (Qjo_JN_Repeating_Key_Fields_t*)
+                  ((char*)JrnData + sizeof(Qjo_RJRN0100_t));
+    pKeyFld1OutputHdr = (Qjo_JN_Key_1_Output_Section_t*)
+                        ((char*)pKeyFld1Hdr + 
+                         pKeyFld1Hdr->Off_Strt_Key_Info);
+    pKeyFld1Data = (Qjo_JN_Repeating_Key_1_Output_t*)
+                   ((char*)pKeyFld1OutputHdr + 
+                    sizeof(Qjo_JN_Key_1_Output_Section_t));
+
+    *NumRcvrs = pKeyFld1Hdr->Number_Entries;
+    pQm->SizeMult = pKeyFld1OutputHdr->Tot_Size_Mult > 0 ?
+                    pKeyFld1OutputHdr->Tot_Size_Mult : 1;
+    pQm->Metrics.ChainBytes += pRtnJrnInf->Bytes_Returned;
+    sprintf(print_buffer, 
+            "Processing %d receivers for AMQAJRN in %10.10s", 
+            *NumRcvrs, pQm->QmgrLib );
+    output(pQm, print_buffer);
+
+    /***********************************************************************/
+    /* Hand the buffer back to the caller - the receiver entries are used  */
+    /* where the API put them rather than being copied                     */
+    /***********************************************************************/
+    *ppJrnData = JrnData;
+    *ppRcvDirectory = pKeyFld1Data;
+
+    /***********************************************************************/
+    /* Trace some of the returned data                                     */
+    /***********************************************************************/
+    sprintf(print_buffer, "Attached receiver name: %10.10s",
+            pRtnJrnInf->Att_Jrn_Rcv_Name );
+    output(pQm, print_buffer);
+  } /* End if retcode == OK */
+
+  /*************************************************************************/
+  /* Otherwise free the storage used to retrieve the data                  */
+  /*************************************************************************/
+  else if (JrnData) {
+    free(JrnData);
+  };
+
+  return retcode;
+}
+
+/***************************************************************************/
+/* Function:  OpenHistory()                                                */
+/*                                                                         */
+/* Description: Map the queue manager's HISTORY file, QMGRLIB.jrnhist in   */
+/*              the HISTORY directory.  It is created at its full size     */
+/*              (when Create is TRUE) and mapped once, so adding a record  */
+/*              or reading them back is just a memory copy.  A file that   */
+/*              wasn't written by this version is not used.                */
+/*                                                                         */
+/***************************************************************************/
+static int OpenHistory(struct QmgrMaint *pQm, int Create)
+{
+  char  FileName[300],
+  print_buffer[400];
+  int   fd;
+  size_t FileSize = sizeof(struct HistHeader) + 
+                    (size_t)HIST_RECORDS * sizeof(struct HistRecord);
+  struct stat Stat;
+  struct HistHeader *pHist;
+
+  if (pQm->pHist) return OK;
+
+  sprintf(FileName, "%s/%s.jrnhist", pQm->pConfig->HistoryDir, pQm->szQmgrLib);
+  fd = open(FileName, Create ? O_RDWR | O_CREAT : O_RDONLY, 
+            S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  if (fd < 0 || fstat(fd, &Stat) != 0) {
+    sprintf(print_buffer, "ERROR: Can't open history file %s", FileName);
+    output_error(pQm, print_buffer);
+    if (fd >= 0) close(fd);
+    return ERR_HISTORY_FILE;
+  };
+
+  if (Stat.st_size == 0 && Create) {
+    if (ftruncate(fd, FileSize) != 0) {
+      sprintf(print_buffer, "ERROR: Can't extend history file %s", 
+              FileName);
+      output_error(pQm, print_buffer);
+      close(fd);
+      return ERR_HISTORY_FILE;
+    };
+    Stat.st_size = FileSize;
+  };
+
+  pHist = (Stat.st_size != FileSize) ? 0 : 
+    (struct HistHeader*)mmap(NULL, FileSize, 
+                             Create ? PROT_READ | PROT_WRITE : PROT_READ,
+                             MAP_SHARED, fd, 0);
+  if (pHist == (struct HistHeader*)MAP_FAILED) pHist = 0;
+
+  if (pHist && Create && pHist->Magic[0] == '\0') {
+    pHist->RecordLen = sizeof(struct HistRecord);
+    pHist->Capacity = HIST_RECORDS;
+    pHist->Written = 0;
+    memcpy(pHist->QmgrLib, pQm->QmgrLib, 10);
+    memcpy(pHist->Magic, HIST_MAGIC, 8);
+  };
+
+  if (! pHist || memcmp(pHist->Magic, HIST_MAGIC, 8) ||
+      pHist->RecordLen != sizeof(struct HistRecord) ||
+      pHist->Capacity != HIST_RECORDS) {
+    sprintf(print_buffer, "ERROR: %s is not a history file", FileName);
+    output_error(pQm, print_buffer);
+    if (pHist) munmap((void*)pHist, FileSize);
+    close(fd);
+    return ERR_HISTORY_FILE;
+  };
+
+  pQm->pHist = pHist;
+  pQm->HistFd = fd;
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  CloseHistory()                                               */
+/***************************************************************************/
+static void CloseHistory(struct QmgrMaint *pQm)
+{
+  if (! pQm->pHist) return;
+
+  munmap((void*)pQm->pHist, sizeof(struct HistHeader) + 
+         (size_t)HIST_RECORDS * sizeof(struct HistRecord));
+  close(pQm->HistFd);
+  pQm->pHist = 0;
+}
+
+/***************************************************************************/
+/* Function:  WriteHistory()                                               */
+/***************************************************************************/
+static void WriteHistory(struct QmgrMaint *pQmgrs, int NumQmgrs)
+{
+  int   count;
+
+  for (count = 0; count < NumQmgrs; count++) {
+    if (! pQmgrs[count].pConfig->HistoryDir[0]) continue;
+    if (OpenHistory(&pQmgrs[count], TRUE) == OK) {
+      AppendHistory(&pQmgrs[count]);
+    };
+    FlushOutput(&pQmgrs[count]);
+  };
+}
+
+/***************************************************************************/
+/* Function:  AppendHistory()                                              */
+/*                                                                         */
+/* Description: Add a record for the last check.  A check that found the   */
+/*              same cutoff and attached receiver as the last record, and  */
+/*              deleted nothing, is only recorded once an hour, so a       */
+/*              resident job doesn't fill the ring with copies.  The file  */
+/*              is locked while the record is added, in case another job   */
+/*              is recording the same queue manager.                       */
+/*                                                                         */
+/***************************************************************************/
+static void AppendHistory(struct QmgrMaint *pQm)
+{
+  struct HistHeader *pHist = pQm->pHist;
+  struct HistRecord *pRing = (struct HistRecord*)(pHist + 1),
+  Record,
+  *pLast;
+  struct flock Lock;
+  int   phase;
+
+  memset(&Record, 0, sizeof(Record));
+  Record.Time = LocalSeconds() * 1000;
+  Record.Cutoff = pQm->Metrics.Cutoff;
+  memcpy(Record.AttRcv, pQm->Metrics.AttRcv, 10);
+  memcpy(Record.OldestRcv, pQm->Metrics.OldestRcv, 10);
+  Record.ChainLength = pQm->NumRcvrs;
+  Record.Kept = pQm->Metrics.Kept;
+  Record.Deleted = pQm->deletecount - pQm->HistDeleted;
+  Record.Retcode = pQm->retcode;
+  for (phase = 0; phase < NUM_PHASES; phase++) {
+    Record.PhaseMicros[phase] = pQm->Metrics.PhaseMicros[phase];
+  };
+
+  memset(&Lock, 0, sizeof(Lock));
+  Lock.l_type = F_WRLCK;
+  Lock.l_whence = SEEK_SET;
+  fcntl(pQm->HistFd, F_SETLKW, &Lock);
+
+  if (pHist->Written > 0) {
+    pLast = &pRing[(pHist->Written - 1) % pHist->Capacity];
+    if (Record.Deleted == 0 && Record.Cutoff == pLast->Cutoff &&
+        Record.Retcode == pLast->Retcode &&
+        ! memcmp(Record.AttRcv, pLast->AttRcv, 10) &&
+        Record.Time - pLast->Time < HIST_HEARTBEAT * 1000LL) {
+      Lock.l_type = F_UNLCK;
+      fcntl(pQm->HistFd, F_SETLK, &Lock);
+      return;
+    };
+  };
+
+  pRing[pHist->Written % pHist->Capacity] = Record;
+  pHist->Written++;
+  pQm->HistDeleted = pQm->deletecount;
+
+  Lock.l_type = F_UNLCK;
+  fcntl(pQm->HistFd, F_SETLK, &Lock);
+}
+
+/***************************************************************************/
+/* Function:  QueryHistory()                                               */
+/*                                                                         */
+/* Description: MODE(*HISTORY) - summarise the records of the last         */
+/*              WindowHours: how far the oldest entry needed moved         */
+/*              compared with the time that passed, how far behind it      */
+/*              was, the receivers attached and deleted, and the time      */
+/*              the checks took                                            */
+/*                                                                         */
+/***************************************************************************/
+static int QueryHistory(struct QmgrMaint *pQm, int WindowHours)
+{
+  struct HistHeader *pHist;
+  struct HistRecord *pRing,
+  *pRec,
+  *pFirst = 0,
+  *pLast = 0;
+  long long count,
+  start,
+  From = (LocalSeconds() - WindowHours * 3600LL) * 1000,
+  Lag,
+  MaxLag = 0,
+  PhaseTotal[NUM_PHASES];
+  int   retcode,
+  phase,
+  records = 0,
+  failed = 0,
+  deleted = 0,
+  maxChain = 0;
+  char  print_buffer[300],
+  TimeText[24],
+  TimeText2[24],
+  Interval[40],
+  Interval2[40];
+
+  retcode = OpenHistory(pQm, FALSE);
+  if (retcode != OK) {
+    return retcode;
+  };
+  pHist = pQm->pHist;
+  pRing = (struct HistRecord*)(pHist + 1);
+  memset(PhaseTotal, 0, sizeof(PhaseTotal));
+
+  start = pHist->Written > pHist->Capacity ? 
+          pHist->Written - pHist->Capacity : 0;
+  for (count = start; count < pHist->Written; count++) {
+    pRec = &pRing[count % pHist->Capacity];
+    if (pRec->Time < From) continue;
+
+    if (! pFirst) pFirst = pRec;
+    pLast = pRec;
+    records++;
+    deleted += pRec->Deleted;
+    if (pRec->Retcode != OK) {
+      failed++;
+      continue;
+    };
+    if (pRec->ChainLength > maxChain) maxChain = pRec->ChainLength;
+    Lag = pRec->Time - pRec->Cutoff;
+    if (Lag > MaxLag) MaxLag = Lag;
+    for (phase = 0; phase < NUM_PHASES; phase++) {
+      PhaseTotal[phase] += pRec->PhaseMicros[phase];
+    };
+  };
+
+  sprintf(print_buffer, "History - %lld check(s) recorded for %s, %d in "
+          "the last %d hour(s)", pHist->Written, pQm->szQmgrLib, records, 
+          WindowHours);
+  output(pQm, print_buffer);
+  if (! records) {
+    CloseHistory(pQm);
+    return OK;
+  };
+
+  FormatJrnTime(pFirst->Time, FALSE, TimeText);
+  FormatJrnTime(pLast->Time, FALSE, TimeText2);
+  sprintf(print_buffer, "History - from %s to %s, %d check(s) failed", 
+          TimeText, TimeText2, failed);
+  output(pQm, print_buffer);
+
+  FormatJrnTime(pFirst->Cutoff, TRUE, TimeText);
+  FormatJrnTime(pLast->Cutoff, TRUE, TimeText2);
+  sprintf(print_buffer, "History - oldest entry needed moved from %s "
+          "(%10.10s) to %s (%10.10s)", TimeText, pFirst->OldestRcv, 
+          TimeText2, pLast->OldestRcv);
+  output(pQm, print_buffer);
+
+  if (pLast->Time > pFirst->Time) {
+    FormatInterval((pLast->Cutoff - pFirst->Cutoff) / 1000, Interval);
+    FormatInterval((pLast->Time - pFirst->Time) / 1000, Interval2);
+    sprintf(print_buffer, "History - it moved %s in %s (%.0f%%) - less "
+            "than 100%% means it is falling behind", Interval, Interval2,
+            (pLast->Cutoff - pFirst->Cutoff) * 100.0 / 
+            (pLast->Time - pFirst->Time));
+    output(pQm, print_buffer);
+  };
+
+  FormatInterval((pLast->Time - pLast->Cutoff) / 1000, Interval);
+  FormatInterval(MaxLag / 1000, Interval2);
+  sprintf(print_buffer, "History - oldest entry needed is %s old, at most "
+          "%s", Interval, Interval2);
+  output(pQm, print_buffer);
+
+  sprintf(print_buffer, "History - attached receiver %10.10s to %10.10s, "
+          "chain of %d receiver(s) (at most %d), %d receiver(s) deleted",
+          pFirst->AttRcv, pLast->AttRcv, pLast->ChainLength, maxChain, 
+          deleted);
+  output(pQm, print_buffer);
+
+  if (records > failed) {
+    sprintf(print_buffer, "History - average check took %.3f ms to read "
+            "AMQJRNINF, %.3f ms to retrieve the chain, %.3f ms to find the "
+            "cutoff and %.3f ms to delete", 
+            PhaseTotal[PHASE_USRSPC] / 1e3 / (records - failed),
+            PhaseTotal[PHASE_CHAIN] / 1e3 / (records - failed),
+            PhaseTotal[PHASE_SCAN] / 1e3 / (records - failed),
+            PhaseTotal[PHASE_DELETE] / 1e3 / (records - failed));
+    output(pQm, print_buffer);
+  };
+
+  CloseHistory(pQm);
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  WriteMetrics()                                               */
+/*                                                                         */
+/* Description: Write the timings and counters for each queue manager to   */
+/*              the METRICS file, in the Prometheus text format, so they   */
+/*              can be collected (by a node exporter textfile collector,   */
+/*              for instance) and graphed.  The file is written under a    */
+/*              temporary name and renamed, so a collector never reads a   */
+/*              partly written file.                                       */
+/*                                                                         */
+/***************************************************************************/
+static int WriteMetrics(struct JrnMaintConfig *pConfig,
+                        struct QmgrMaint *pQmgrs, int NumQmgrs,
+                        long long StartupMicros, long long RunMicros)
+{
+  static const char *PhaseNames[NUM_PHASES] = 
+    {"chkobj", "usrspc", "chain", "scan", "delete"};
+  char  TempFile[270],
+  print_buffer[400];
+  FILE *fp;
+  int   count,
+  phase;
+  struct QmgrMaint *pQm;
+
+  if (! pConfig->MetricsFile[0]) return OK;
+
+  sprintf(TempFile, "%s.tmp", pConfig->MetricsFile);
+  fp = fopen(TempFile, "w");
+  if (! fp) {
+    sprintf(print_buffer, "ERROR: Can't write metrics file %s", TempFile);
+    output_error(0, print_buffer);
+    return ERR_METRICS_FILE;
+  };
+
+  fprintf(fp, "# HELP jrnmaint_run_seconds Time taken by the run\n"
+              "# TYPE jrnmaint_run_seconds gauge\n"
+              "jrnmaint_run_seconds{phase=\"startup\"} %.6f\n"
+              "jrnmaint_run_seconds{phase=\"total\"} %.6f\n",
+          StartupMicros / 1e6, RunMicros / 1e6);
+  fprintf(fp, "# HELP jrnmaint_last_run_timestamp_seconds "
+              "When the metrics were written\n"
+              "# TYPE jrnmaint_last_run_timestamp_seconds gauge\n"
+              "jrnmaint_last_run_timestamp_seconds %ld\n", (long)time(NULL));
+
+  fprintf(fp, "# HELP jrnmaint_phase_seconds Time taken by each phase\n"
+              "# TYPE jrnmaint_phase_seconds gauge\n");
+  for (count = 0; count < NumQmgrs; count++) {
+    pQm = &pQmgrs[count];
+    for (phase = 0; phase < NUM_PHASES; phase++) {
+      fprintf(fp, "jrnmaint_phase_seconds{qmgrlib=\"%s\",phase=\"%s\"} "
+              "%.6f\n", pQm->szQmgrLib, PhaseNames[phase], 
+              pQm->Metrics.PhaseMicros[phase] / 1e6);
+    };
+  };
+
+  WriteMetric(fp, pQmgrs, NumQmgrs, "jrnmaint_status", 
+              "Return code for the queue manager (0 is OK)",
+              offsetof(struct QmgrMaint, retcode));
+  WriteMetric(fp, pQmgrs, NumQmgrs, "jrnmaint_chain_receivers", 
+              "Receivers in the AMQAJRN receiver chain",
+              offsetof(struct QmgrMaint, NumRcvrs));
+  WriteMetric(fp, pQmgrs, NumQmgrs, "jrnmaint_chain_retrieve_calls", 
+              "QjoRetrieveJournalInformation calls to retrieve the chain",
+              offsetof(struct QmgrMaint, Metrics.ChainCalls));
+  WriteMetric(fp, pQmgrs, NumQmgrs, "jrnmaint_kept_receivers", 
+              "Receivers the queue manager still needs",
+              offsetof(struct QmgrMaint, Metrics.Kept));
+  WriteMetric(fp, pQmgrs, NumQmgrs, "jrnmaint_oldest_needed_distance", 
+              "Receivers attached after the oldest receiver needed",
+              offsetof(struct QmgrMaint, Metrics.Distance));
+  WriteMetric(fp, pQmgrs, NumQmgrs, "jrnmaint_deleted_receivers", 
+              "Receivers deleted",
+              offsetof(struct QmgrMaint, deletecount));
+  WriteMetric(fp, pQmgrs, NumQmgrs, "jrnmaint_saved_receivers", 
+              "Receivers saved",
+              offsetof(struct QmgrMaint, Metrics.Saved));
+  WriteMetric(fp, pQmgrs, NumQmgrs, "jrnmaint_delete_failures", 
+              "Receiver deletes that failed",
+              offsetof(struct QmgrMaint, Metrics.DeleteFailures));
+  WriteMetric(fp, pQmgrs, NumQmgrs, "jrnmaint_deferred_receivers", 
+              "Receivers the delete pacing left for the next check",
+              offsetof(struct QmgrMaint, Pacer.Deferred));
+  WriteMetric(fp, pQmgrs, NumQmgrs, "jrnmaint_delete_pace_divisor", 
+              "Delete budget divisor - 1 unless the system was busy",
+              offsetof(struct QmgrMaint, Pacer.Scale));
+  WriteMetric(fp, pQmgrs, NumQmgrs, "jrnmaint_media_images", 
+              "Media images recorded to release the oldest receivers",
+              offsetof(struct QmgrMaint, Metrics.Images));
+
+  fprintf(fp, "# HELP jrnmaint_chain_bytes Bytes of receiver chain "
+              "information retrieved\n"
+              "# TYPE jrnmaint_chain_bytes gauge\n");
+  for (count = 0; count < NumQmgrs; count++) {
+    fprintf(fp, "jrnmaint_chain_bytes{qmgrlib=\"%s\"} %lld\n", 
+            pQmgrs[count].szQmgrLib, pQmgrs[count].Metrics.ChainBytes);
+  };
+  fprintf(fp, "# HELP jrnmaint_oldest_entry_age_seconds Age of the oldest "
+              "journal entry the queue manager needs\n"
+              "# TYPE jrnmaint_oldest_entry_age_seconds gauge\n");
+  for (count = 0; count < NumQmgrs; count++) {
+    fprintf(fp, "jrnmaint_oldest_entry_age_seconds{qmgrlib=\"%s\"} %lld\n",
+            pQmgrs[count].szQmgrLib, pQmgrs[count].Metrics.OldestAge);
+  };
+
+  if (fclose(fp) != 0) {
+    sprintf(print_buffer, "ERROR: Can't write metrics file %s", TempFile);
+    output_error(0, print_buffer);
+    remove(TempFile);
+    return ERR_METRICS_FILE;
+  };
+
+  remove(pConfig->MetricsFile);
+  if (rename(TempFile, pConfig->MetricsFile) != 0) {
+    sprintf(print_buffer, "ERROR: Can't rename %.180s to %.180s", TempFile, 
+            pConfig->MetricsFile);
+    output_error(0, print_buffer);
+    return ERR_METRICS_FILE;
+  };
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  WriteMetric()                                                */
+/*                                                                         */
+/* Description: Write one int gauge for each queue manager, taken from     */
+/*              Offset bytes into its QmgrMaint                           */
+/*                                                                         */
+/***************************************************************************/
+static void WriteMetric(FILE *fp, struct QmgrMaint *pQmgrs, int NumQmgrs,
+                        char *Name, char *Help, size_t Offset)
+{
+  int   count;
+
+  fprintf(fp, "# HELP %s %s\n# TYPE %s gauge\n", Name, Help, Name);
+  for (count = 0; count < NumQmgrs; count++) {
+    fprintf(fp, "%s{qmgrlib=\"%s\"} %d\n", Name, pQmgrs[count].szQmgrLib,
+            *(int*)((char*)&pQmgrs[count] + Offset));
+  };
+}
+
+/***************************************************************************/
+/* Function:  OpenTrace()                                                  */
+/*                                                                         */
+/* Description: Start writing the TRACE file - in ASCII on IBM i, so the   */
+/*              trace can be replayed anywhere                             */
+/*                                                                         */
+/***************************************************************************/
+int OpenTrace(struct JrnMaintConfig *pConfig, char *FileName)
+{
+  char  print_buffer[300];
+
+#ifdef __OS400__
+  pConfig->TraceFp = fopen(FileName, "w, o_ccsid=819");
+#else
+  pConfig->TraceFp = fopen(FileName, "w");
+#endif
+  if (! pConfig->TraceFp) {
+    sprintf(print_buffer, "ERROR: Can't write trace file %.256s", FileName);
+    output_config_error(pConfig, print_buffer);
+    return ERR_TRACE_FILE;
+  };
+  fprintf(pConfig->TraceFp, "# JRNMAINT trace %d\n", TRACE_VERSION);
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  CloseTrace()                                                 */
+/***************************************************************************/
+void CloseTrace(struct JrnMaintConfig *pConfig)
+{
+  if (! pConfig->TraceFp) return;
+
+  fclose(pConfig->TraceFp);
+  pConfig->TraceFp = 0;
+}
+
+/***************************************************************************/
+/* Function:  TraceLine()                                                  */
+/*                                                                         */
+/* Description: Add a line to the TRACE lines held for a queue manager     */
+/*                                                                         */
+/***************************************************************************/
+static void TraceLine(struct QmgrMaint *pQm, char *Line)
+{
+  int   len = strlen(Line);
+  char *p;
+
+  if (pQm->TraceLen + len + 2 > pQm->TraceSize) {
+    p = (char*)realloc(pQm->TraceBuf, pQm->TraceSize + len + 4096);
+    if (! p) return;
+    pQm->TraceBuf = p;
+    pQm->TraceSize += len + 4096;
+  };
+  memcpy(pQm->TraceBuf + pQm->TraceLen, Line, len);
+  pQm->TraceLen += len;
+  pQm->TraceBuf[pQm->TraceLen++] = '\n';
+}
+
+/***************************************************************************/
+/* Function:  TraceInputs()                                                */
+/*                                                                         */
+/* Description: Trace what the cutoff is worked out from - the AMQJRNINF   */
+/*              contents and each receiver in the chain.  Only the fields  */
+/*              the index is built from are traced, as text, so a trace    */
+/*              taken on IBM i reads the same on any other system.         */
+/*                                                                         */
+/***************************************************************************/
+static void TraceInputs(struct QmgrMaint *pQm, struct JrnInf *pJrnInf,
+                        Qjo_JN_Repeating_Key_1_Output_t *pRcvDirectory,
+                        int NumRcvrs)
+{
+  int   count;
+  char  print_buffer[200];
+
+  sprintf(print_buffer, "J %20.20s %17.17s", pJrnInf->JrnName,
+          pJrnInf->CC);
+  TraceLine(pQm, print_buffer);
+  sprintf(print_buffer, "C %d", NumRcvrs);
+  TraceLine(pQm, print_buffer);
+  for (count = 0; count < NumRcvrs; count++) {
+    sprintf(print_buffer, "R %10.10s %13.13s %c %d", 
+            pRcvDirectory[count].Jrn_Rcv_Name,
+            pRcvDirectory[count].Jrn_Rcv_Att_Date_Time,
+            pRcvDirectory[count].Jrn_Rcv_Status,
+            (int)pRcvDirectory[count].Jrn_Rcv_Size);
+    TraceLine(pQm, print_buffer);
+  };
+}
+
+/***************************************************************************/
+/* Function:  TraceDecision()                                              */
+/*                                                                         */
+/* Description: Trace the oldest receiver found to be needed               */
+/*                                                                         */
+/***************************************************************************/
+static void TraceDecision(struct QmgrMaint *pQm, struct RcvIndex *pIndex,
+                          int oldestReceiverIndex)
+{
+  char  print_buffer[40];
+
+  sprintf(print_buffer, "O %d %-10.10s", oldestReceiverIndex,
+          oldestReceiverIndex >= 0 ? pIndex->Name[oldestReceiverIndex] :
+          "*NONE");
+  TraceLine(pQm, print_buffer);
+}
+
+/***************************************************************************/
+/* Function:  TracePolicy()                                                */
+/*                                                                         */
+/* Description: Trace the retention policy, and the time it was applied    */
+/*              at, so replaying it gives the same plan                    */
+/*                                                                         */
+/***************************************************************************/
+static void TracePolicy(struct QmgrMaint *pQm, JrnTime Now)
+{
+  struct ProtectRange *pRange;
+  int   count,
+  len,
+  first,
+  last;
+  char  print_buffer[100 + MAX_PROTECT * 23];
+  struct RetainPolicy *pPolicy = &pQm->pConfig->Policy;
+
+  len = sprintf(print_buffer, "P %lld %d %d %c", Now, pPolicy->Extra,
+                pPolicy->MinAgeHours, pPolicy->RequireSaved ? 'Y' : 'N');
+  for (count = 0; count < pPolicy->NumProtect; count++) {
+    pRange = &pPolicy->Protect[count];
+    for (first = 10; first > 0 && pRange->First[first - 1] == ' '; first--);
+    for (last = 10; last > 0 && pRange->Last[last - 1] == ' '; last--);
+    if (pRange->Generic)
+      len += sprintf(print_buffer + len, "%c%.*s*", count ? ',' : ' ',
+                     pRange->Generic, pRange->First);
+    else if (memcmp(pRange->First, pRange->Last, 10))
+      len += sprintf(print_buffer + len, "%c%.*s-%.*s", count ? ',' : ' ',
+                     first, pRange->First, last, pRange->Last);
+    else
+      len += sprintf(print_buffer + len, "%c%.*s", count ? ',' : ' ',
+                     first, pRange->First);
+  };
+  TraceLine(pQm, print_buffer);
+}
+
+/***************************************************************************/
+/* Function:  WriteTrace()                                                 */
+/*                                                                         */
+/* Description: Trace the deletes that were attempted and how the queue    */
+/*              manager finished, then write its lines to the TRACE file   */
+/*              as one block, so the queue managers processed at the same  */
+/*              time on the pool of threads are not interleaved            */
+/*                                                                         */
+/***************************************************************************/
+static void WriteTrace(struct QmgrMaint *pQm, int retcode, int deletecount)
+{
+  int   count;
+  char  print_buffer[40];
+
+  if (! pQm->pConfig->TraceFp) return;
+
+  for (count = 0; count < pQm->NumDeletes; count++) {
+    sprintf(print_buffer, "D %10.10s %.7s", pQm->Deletes[count].Name,
+            pQm->Deletes[count].ExceptionId[0] != ' ' ?
+            pQm->Deletes[count].ExceptionId : "*OK");
+    TraceLine(pQm, print_buffer);
+  };
+  sprintf(print_buffer, "E %d %d", retcode, deletecount);
+  TraceLine(pQm, print_buffer);
+
+  if (pQm->TraceBuf) {
+    pthread_mutex_lock(&pQm->pConfig->TraceLock);
+    fwrite(pQm->TraceBuf, 1, pQm->TraceLen, pQm->pConfig->TraceFp);
+    fflush(pQm->pConfig->TraceFp);
+    pthread_mutex_unlock(&pQm->pConfig->TraceLock);
+
+    free(pQm->TraceBuf);
+    pQm->TraceBuf = 0;
+    pQm->TraceLen = pQm->TraceSize = 0;
+  };
+}
+
+/***************************************************************************/
+/* Function:  ReplayTrace()                                                */
+/*                                                                         */
+/* Description: MODE(*REPLAY) - run each queue manager in a TRACE file     */
+/*              through the cutoff calculation again, check the same       */
+/*              oldest receiver is found and that the deletes attempted    */
+/*              were the ones planned, then time how many chains a second  */
+/*              the index build and search can get through.  No queue      */
+/*              manager is touched, so a trace taken on a production       */
+/*              system can be replayed on a test system or a workstation.  */
+/*                                                                         */
+/***************************************************************************/
+int ReplayTrace(struct JrnMaintConfig *pConfig, char *FileName)
+{
+  FILE *fp;
+  struct ReplayCase *pCases = 0;
+  struct RcvIndex Index = {0, 0, 0, 0, 0, 0, 0};
+  char *Plan;
+  int   retcode,
+  NumCases = 0,
+  MaxRcvrs = 0,
+  oldest,
+  count,
+  replayed = 0,
+  mismatches = 0;
+  long long startTime,
+  elapsed,
+  chains = 0,
+  receivers = 0;
+  char  print_buffer[300];
+
+#ifdef __OS400__
+  fp = fopen(FileName, "r, o_ccsid=0");
+#else
+  fp = fopen(FileName, "r");
+#endif
+  if (! fp) {
+    sprintf(print_buffer, "ERROR: Can't read trace file %s", FileName);
+    output_config_error(pConfig, print_buffer);
+    return ERR_TRACE_FILE;
+  };
+  retcode = ReadReplayCases(pConfig, fp, &pCases, &NumCases);
+  fclose(fp);
+  for (count = 0; count < NumCases; count++) {
+    if (pCases[count].NumRcvrs > MaxRcvrs) MaxRcvrs = pCases[count].NumRcvrs;
+  };
+  Plan = (char*)malloc(MaxRcvrs + 1);
+  if (retcode == OK && ! Plan) {
+    output_config_error(pConfig, "ERROR: Memory allocation error (Plan)");
+    retcode = ERR_MEMORY_ERROR;
+  };
+  if (retcode != OK) {
+    if (Plan) free(Plan);
+    FreeReplayCases(pCases, NumCases);
+    return retcode;
+  };
+
+  /*************************************************************************/
+  /* Check each captured decision...                                       */
+  /*************************************************************************/
+  for (count = 0; count < NumCases; count++) {
+    if (! pCases[count].pChain) continue;
+    replayed++;
+    if (CheckReplayCase(pConfig, &pCases[count], &Index, Plan) != OK) {
+      mismatches++;
+    };
+  };
+  sprintf(print_buffer, "Replayed %d of the %d queue manager(s) in %s - "
+          "%d mismatch(es)", replayed, NumCases, FileName, mismatches);
+  output_config(pConfig, print_buffer);
+
+  /*************************************************************************/
+  /* ...then time the index build, search and plan over all of them       */
+  /*************************************************************************/
+  if (replayed) {
+    startTime = PlatMicroseconds();
+    do {
+      for (count = 0; count < NumCases; count++) {
+        if (! pCases[count].pChain) continue;
+        if (BuildReceiverIndex(pCases[count].pChain, 
+                               pCases[count].NumRcvrs, &Index) != OK) {
+          break;
+        };
+        oldest = FindOldestNeeded(&Index, 
+                                  JrnInfTime(&pCases[count].JrnInf));
+        ClassifyReceivers(&pCases[count].Policy, &Index, oldest,
+                          pCases[count].Now, Plan);
+        chains++;
+        receivers += pCases[count].NumRcvrs;
+      };
+      elapsed = PlatMicroseconds() - startTime;
+    } while (elapsed < REPLAY_MICROS);
+
+    sprintf(print_buffer, "Replay throughput - %.0f chains/s, %.0f "
+            "receivers/s (%lld chains in %.3f s)", 
+            chains * 1e6 / elapsed, receivers * 1e6 / elapsed, chains,
+            elapsed / 1e6);
+    output_config(pConfig, print_buffer);
+  };
+
+  FreeReceiverIndex(&Index);
+  FreeReplayCases(pCases, NumCases);
+  free(Plan);
+  return mismatches ? ERR_REPLAY_MISMATCH : OK;
+}
+
+/***************************************************************************/
+/* Function:  ReadReplayCases()                                            */
+/*                                                                         */
+/* Description: Read the queue managers in a TRACE file, rebuilding the    */
+/*              receiver chain entries each one's index was built from     */
+/*                                                                         */
+/***************************************************************************/
+static int ReadReplayCases(struct JrnMaintConfig *pConfig, FILE *fp,
+                           struct ReplayCase **ppCases, int *pNumCases)
+{
+  struct ReplayCase *pCase = 0,
+  *pNew;
+  Qjo_JN_Repeating_Key_1_Output_t *pRcvr;
+  int   NumCases = 0,
+  Size = 0,
+  Line = 0,
+  count,
+  len;
+  char  Text[300],
+  Flag,
+  *pValue,
+  print_buffer[400];
+
+  while (fgets(Text, sizeof(Text), fp)) {
+    Line++;
+    len = strlen(Text);
+    while (len > 0 && (Text[len - 1] == '\n' || Text[len - 1] == '\r')) {
+      Text[--len] = '\0';
+    };
+    if (len == 0 || Text[0] == '#') continue;
+
+    if (Text[0] == 'Q') {
+      if (NumCases == Size) {
+        pNew = (struct ReplayCase*)realloc(*ppCases, 
+                                  sizeof(struct ReplayCase) * (Size + 16));
+        if (! pNew) {
+          output_config_error(pConfig, 
+                              "ERROR: Memory allocation error (ReplayCase)");
+          *pNumCases = NumCases;
+          return ERR_MEMORY_ERROR;
+        };
+        *ppCases = pNew;
+        Size += 16;
+      };
+      pCase = &(*ppCases)[NumCases++];
+      memset(pCase, 0, sizeof(*pCase));
+      memset(pCase->QmgrLib, ' ', 10);
+      memcpy(pCase->QmgrLib, Text + 2, len > 12 ? 10 : len - 2);
+      pCase->Line = Line;
+      pCase->Oldest = -2;                      /* No decision was traced */
+      pCase->Deleting = len > 13 && Text[13] == 'Y';
+      continue;
+    };
+    if (! pCase) {
+      goto BadLine;
+    };
+
+    switch (Text[0]) {
+    case 'J':
+      if (len < 40) goto BadLine;
+      memcpy(pCase->JrnInf.JrnName, Text + 2, 20);
+      memcpy(pCase->JrnInf.CC, Text + 23, 17);
+      break;
+
+    case 'C':
+      pCase->NumRcvrs = 0;
+      count = atoi(Text + 2);
+      if (count < 0) goto BadLine;
+      pCase->pChain = (Qjo_JN_Repeating_Key_1_Output_t*)
+        calloc(count + 1, sizeof(Qjo_JN_Repeating_Key_1_Output_t));
+      pCase->Deleted = (char(*)[10])malloc(10 * (count + 1));
+      if (! pCase->pChain || ! pCase->Deleted) {
+        output_config_error(pConfig, 
+                            "ERROR: Memory allocation error (ReplayCase)");
+        *pNumCases = NumCases;
+        return ERR_MEMORY_ERROR;
+      };
+      pCase->Size = count;
+      break;
+
+    case 'R':
+      if (len < 30 || ! pCase->pChain || pCase->NumRcvrs >= pCase->Size)
+        goto BadLine;
+      pRcvr = &pCase->pChain[pCase->NumRcvrs++];
+      memcpy(pRcvr->Jrn_Rcv_Name, Text + 2, 10);
+      memcpy(pRcvr->Jrn_Rcv_Att_Date_Time, Text + 13, 13);
+      pRcvr->Jrn_Rcv_Status = Text[27];
+      pRcvr->Jrn_Rcv_Size = atoi(Text + 29);
+      break;
+
+    case 'O':
+      pCase->Oldest = atoi(Text + 2);
+      memset(pCase->OldestRcv, ' ', 10);
+      for (count = 0; count < 10 && Text[2 + count] && 
+           Text[2 + count] != ' '; count++);
+      if (len > 3 + count) {
+        memcpy(pCase->OldestRcv, Text + 3 + count, 
+               len - 3 - count > 10 ? 10 : len - 3 - count);
+      };
+      break;
+
+    case 'D':
+      if (len < 14 || ! pCase->Deleted || pCase->NumDeleted >= pCase->Size)
+        goto BadLine;
+      memcpy(pCase->Deleted[pCase->NumDeleted++], Text + 2, 10);
+      break;
+
+    case 'P':
+      if (sscanf(Text + 2, "%lld %d %d %c%n", &pCase->Now, 
+                 &pCase->Policy.Extra, &pCase->Policy.MinAgeHours,
+                 &Flag, &count) < 4) goto BadLine;
+      pCase->Policy.RequireSaved = Flag == 'Y';
+      pCase->Policy.NumProtect = 0;
+      for (pValue = strtok(Text + 2 + count, " ,"); pValue; 
+           pValue = strtok(NULL, " ,")) {
+        if (AddProtect(pValue, &pCase->Policy) != OK) goto BadLine;
+      };
+      break;
+
+    case 'E':
+      pCase->Retcode = atoi(Text + 2);
+      break;
+
+    default:
+      goto BadLine;
+    };
+  };
+
+  *pNumCases = NumCases;
+  return OK;
+
+BadLine:
+  sprintf(print_buffer, "ERROR: Line %d of the trace file is not valid - "
+          "%.200s", Line, Text);
+  output_config_error(pConfig, print_buffer);
+  *pNumCases = NumCases;
+  return ERR_TRACE_FILE;
+}
+
+/***************************************************************************/
+/* Function:  CheckReplayCase()                                            */
+/*                                                                         */
+/* Description: Rebuild the index for one traced queue manager and check   */
+/*              the cutoff falls on the same receiver.  The deletes        */
+/*              attempted must be the receivers the traced retention       */
+/*              policy planned to delete, in order, and all of them unless */
+/*              a save failed.                                             */
+/*                                                                         */
+/***************************************************************************/
+static int CheckReplayCase(struct JrnMaintConfig *pConfig,
+                           struct ReplayCase *pCase, struct RcvIndex *pIndex,
+                           char *Plan)
+{
+  int   retcode = OK,
+  oldest,
+  eligible,
+  entry = 0,
+  count;
+  char  print_buffer[300];
+
+  if (BuildReceiverIndex(pCase->pChain, pCase->NumRcvrs, pIndex) != OK) {
+    output_config_error(pConfig, "ERROR: Memory allocation error (RcvIndex)");
+    return ERR_MEMORY_ERROR;
+  };
+  oldest = FindOldestNeeded(pIndex, JrnInfTime(&pCase->JrnInf));
+
+  if (pCase->Oldest != -2 && 
+      ( oldest != pCase->Oldest ||
+        ( oldest >= 0 && memcmp(pIndex->Name[oldest], pCase->OldestRcv,
+                                10) ) ) ) {
+    sprintf(print_buffer, "MISMATCH: %10.10s (line %d) - oldest receiver "
+            "needed is %10.10s (%d), trace has %10.10s (%d)",
+            pCase->QmgrLib, pCase->Line,
+            oldest >= 0 ? pIndex->Name[oldest] : "*NONE     ", oldest, 
+            pCase->OldestRcv, pCase->Oldest);
+    output_config(pConfig, print_buffer);
+    retcode = ERR_REPLAY_MISMATCH;
+  };
+
+  eligible = ClassifyReceivers(&pCase->Policy, pIndex, oldest, pCase->Now,
+                               Plan);
+  for (count = 0; count < pCase->NumDeleted; count++) {
+    while (entry < oldest && Plan[entry] != PLAN_DELETE) entry++;
+    if (entry >= oldest || 
+        memcmp(pCase->Deleted[count], pIndex->Name[entry], 10)) {
+      sprintf(print_buffer, "MISMATCH: %10.10s (line %d) - delete %d was "
+              "%10.10s, which was not the next receiver eligible", 
+              pCase->QmgrLib, pCase->Line, count + 1, 
+              pCase->Deleted[count]);
+      output_config(pConfig, print_buffer);
+      return ERR_REPLAY_MISMATCH;
+    };
+    entry++;
+  };
+  if (pCase->Deleting && 
+      ( pCase->Retcode == OK || pCase->Retcode == ERR_DELETE_FAILED ) &&
+      pCase->NumDeleted != eligible) {
+    sprintf(print_buffer, "MISMATCH: %10.10s (line %d) - %d receiver(s) "
+            "eligible but %d deleted", pCase->QmgrLib, pCase->Line, eligible,
+            pCase->NumDeleted);
+    output_config(pConfig, print_buffer);
+    retcode = ERR_REPLAY_MISMATCH;
+  };
+
+  if (retcode == OK) {
+    sprintf(print_buffer, "Replayed %10.10s - %d receiver(s), oldest "
+            "needed %10.10s, %d of %d eligible deleted", pCase->QmgrLib,
+            pCase->NumRcvrs, 
+            oldest >= 0 ? pIndex->Name[oldest] : "*NONE     ",
+            pCase->NumDeleted, eligible);
+    output_config(pConfig, print_buffer);
+  };
+  return retcode;
+}
+
+/***************************************************************************/
+/* Function:  FreeReplayCases()                                            */
+/***************************************************************************/
+static void FreeReplayCases(struct ReplayCase *pCases, int NumCases)
+{
+  int   count;
+
+  for (count = 0; count < NumCases; count++) {
+    if (pCases[count].pChain) free(pCases[count].pChain);
+    if (pCases[count].Deleted) free(pCases[count].Deleted);
+  };
+  if (pCases) free(pCases);
+}
+
+/***************************************************************************/
+/* Function:  OpenArchive()                                                */
+/*                                                                         */
+/* Description: Open the ARCHIVE directory for the contexts using a        */
+/*              JrnMaintConfig.  They share it, taking its lock to use it. */
+/*                                                                         */
+/***************************************************************************/
+int OpenArchive(struct JrnMaintConfig *pConfig, char *Dir)
+{
+  struct Archive *pArc;
+  int   retcode;
+
+  pArc = (struct Archive*)calloc(1, sizeof(struct Archive));
+  if (! pArc) {
+    output_config_error(pConfig, "ERROR: Memory allocation error (Archive)");
+    return ERR_MEMORY_ERROR;
+  };
+  strncpy(pArc->Dir, Dir, sizeof(pArc->Dir) - 1);
+  pthread_mutex_init(&pArc->Lock, NULL);
+
+  retcode = LoadArchive(pConfig, pArc);
+  if (retcode != OK) {
+    pthread_mutex_destroy(&pArc->Lock);
+    free(pArc);
+    return retcode;
+  };
+  pConfig->pArchive = pArc;
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  CloseArchive()                                               */
+/***************************************************************************/
+void CloseArchive(struct JrnMaintConfig *pConfig)
+{
+  struct Archive *pArc = pConfig->pArchive;
+
+  if (! pArc) return;
+
+  UnloadArchive(pArc);
+  pthread_mutex_destroy(&pArc->Lock);
+  free(pArc);
+  pConfig->pArchive = 0;
+}
+
+/***************************************************************************/
+/* Function:  LoadArchive()                                                */
+/*                                                                         */
+/* Description: Open the archive's files and read its indexes into memory. */
+/*              archive.lck is locked while it is open, so two             */
+/*              jobs can't add to it at once.  Whatever follows the last   */
+/*              complete addition - chunks whose data isn't all in         */
+/*              chunks.dat, receivers whose recipe isn't all in            */
+/*              recipes.dat - was written by a job that ended part way     */
+/*              through, and is discarded.                                 */
+/*                                                                         */
+/***************************************************************************/
+static int LoadArchive(struct JrnMaintConfig *pConfig, struct Archive *pArc)
+{
+  char  FileName[300],
+  print_buffer[400];
+  int   retcode = OK,
+  count;
+  unsigned long long Seed = 0,
+  x;
+  struct flock Lock;
+  struct stat Stat;
+  struct ArcChunk *pChunk;
+  struct ArcReceiver *pRcv;
+
+  memset(&pArc->Loaded, 0, 
+         sizeof(struct Archive) - offsetof(struct Archive, Loaded));
+  pArc->Loaded = TRUE;
+  pArc->LockFd = pArc->DataFd = pArc->ChunkFd = -1;
+  pArc->RecipeFd = pArc->RcvFd = -1;
+
+  sprintf(FileName, "%s/archive.lck", pArc->Dir);
+  pArc->LockFd = open(FileName, O_RDWR | O_CREAT, 
+                        S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  memset(&Lock, 0, sizeof(Lock));
+  Lock.l_type = F_WRLCK;
+  Lock.l_whence = SEEK_SET;
+  if (pArc->LockFd >= 0 && fcntl(pArc->LockFd, F_SETLK, &Lock) != 0) {
+    sprintf(print_buffer, "ERROR: Archive %s is in use by another job", 
+            pArc->Dir);
+    output_config_error(pConfig, print_buffer);
+    UnloadArchive(pArc);
+    return ERR_ARCHIVE;
+  };
+
+  sprintf(FileName, "%s/chunks.dat", pArc->Dir);
+  pArc->DataFd = open(FileName, O_RDWR | O_CREAT, 
+                        S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  sprintf(FileName, "%s/chunks.idx", pArc->Dir);
+  pArc->ChunkFd = open(FileName, O_RDWR | O_CREAT, 
+                         S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  sprintf(FileName, "%s/recipes.dat", pArc->Dir);
+  pArc->RecipeFd = open(FileName, O_RDWR | O_CREAT, 
+                          S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  sprintf(FileName, "%s/receivers.idx", pArc->Dir);
+  pArc->RcvFd = open(FileName, O_RDWR | O_CREAT, 
+                       S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  if (pArc->LockFd < 0 || pArc->DataFd < 0 || pArc->ChunkFd < 0 ||
+      pArc->RecipeFd < 0 || pArc->RcvFd < 0) {
+    retcode = ERR_ARCHIVE;
+  };
+  if (retcode == OK) {
+    retcode = LoadArchiveIndex(pArc->ChunkFd, sizeof(struct ArcChunk),
+                               (void**)&pArc->Chunks, &pArc->NumChunks,
+                               &pArc->ChunksSize);
+  };
+  if (retcode == OK) {
+    retcode = LoadArchiveIndex(pArc->RcvFd, sizeof(struct ArcReceiver),
+                               (void**)&pArc->Rcvs, &pArc->NumRcvs,
+                               &pArc->RcvsSize);
+  };
+  if (retcode != OK) {
+    sprintf(print_buffer, "ERROR: Can't open archive %s", pArc->Dir);
+    output_config_error(pConfig, print_buffer);
+    UnloadArchive(pArc);
+    return retcode;
+  };
+
+  /*************************************************************************/
+  /* Drop anything an interrupted addition left behind                     */
+  /*************************************************************************/
+  if (fstat(pArc->DataFd, &Stat) != 0) Stat.st_size = 0;
+  while (pArc->NumChunks > 0) {
+    pChunk = &pArc->Chunks[pArc->NumChunks - 1];
+    if (pChunk->Offset + pChunk->StoredLen <= Stat.st_size) break;
+    pArc->NumChunks--;
+  };
+  if (pArc->NumChunks > 0) {
+    pChunk = &pArc->Chunks[pArc->NumChunks - 1];
+    pArc->DataLen = pChunk->Offset + pChunk->StoredLen;
+  };
+
+  if (fstat(pArc->RecipeFd, &Stat) != 0) Stat.st_size = 0;
+  while (pArc->NumRcvs > 0) {
+    pRcv = &pArc->Rcvs[pArc->NumRcvs - 1];
+    if ((pRcv->Recipe + pRcv->NumChunks) * (long long)sizeof(int) <= 
+        Stat.st_size) break;
+    pArc->NumRcvs--;
+  };
+  if (pArc->NumRcvs > 0) {
+    pRcv = &pArc->Rcvs[pArc->NumRcvs - 1];
+    pArc->RecipeLen = pRcv->Recipe + pRcv->NumChunks;
+  };
+
+  if (ftruncate(pArc->DataFd, pArc->DataLen) != 0 ||
+      ftruncate(pArc->ChunkFd, sizeof(struct ArcHeader) + 
+                (long long)pArc->NumChunks * sizeof(struct ArcChunk)) ||
+      ftruncate(pArc->RecipeFd, pArc->RecipeLen * sizeof(int)) != 0 ||
+      ftruncate(pArc->RcvFd, sizeof(struct ArcHeader) + 
+                (long long)pArc->NumRcvs * sizeof(struct ArcReceiver))) {
+    sprintf(print_buffer, "ERROR: Can't recover archive %s", pArc->Dir);
+    output_config_error(pConfig, print_buffer);
+    UnloadArchive(pArc);
+    return ERR_ARCHIVE;
+  };
+
+  /*************************************************************************/
+  /* Chunk boundaries depend on a table of random values, which must be    */
+  /* the same every time - so it is generated from a fixed seed            */
+  /*************************************************************************/
+  for (count = 0; count < 256; count++) {
+    Seed += 0x9E3779B97F4A7C15ULL;                  /* splitmix64         */
+    x = Seed;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    pArc->Gear[count] = x ^ (x >> 31);
+  };
+
+  for (pArc->HashSize = 4096; 
+       pArc->HashSize < pArc->NumChunks * 2;
+       pArc->HashSize *= 2);
+  pArc->Hash = (int*)calloc(pArc->HashSize, sizeof(int));
+  if (! pArc->Hash) {
+    sprintf(print_buffer, "ERROR: Not enough memory to open archive %s", 
+            pArc->Dir);
+    output_config_error(pConfig, print_buffer);
+    UnloadArchive(pArc);
+    return ERR_MEMORY_ERROR;
+  };
+  for (count = 0; count < pArc->NumChunks; count++) {
+    HashChunk(pArc, count);
+  };
+
+  sprintf(print_buffer, "Archive %s holds %d receiver(s) in %d chunk(s), "
+          "%lld K", pArc->Dir, pArc->NumRcvs, pArc->NumChunks, 
+          pArc->DataLen / 1024);
+  output_config(pConfig, print_buffer);
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  UnloadArchive()                                              */
+/***************************************************************************/
+static void UnloadArchive(struct Archive *pArc)
+{
+  if (! pArc->Loaded) return;
+
+  if (pArc->DataFd >= 0) close(pArc->DataFd);
+  if (pArc->ChunkFd >= 0) close(pArc->ChunkFd);
+  if (pArc->RecipeFd >= 0) close(pArc->RecipeFd);
+  if (pArc->RcvFd >= 0) close(pArc->RcvFd);
+  if (pArc->LockFd >= 0) close(pArc->LockFd);  /* Releases the lock   */
+  if (pArc->Chunks) free(pArc->Chunks);
+  if (pArc->Hash) free(pArc->Hash);
+  if (pArc->Rcvs) free(pArc->Rcvs);
+  memset(&pArc->Loaded, 0, 
+         sizeof(struct Archive) - offsetof(struct Archive, Loaded));
+}
+
+/***************************************************************************/
+/* Function:  LoadArchiveIndex()                                           */
+/*                                                                         */
+/* Description: Read the records of chunks.idx or receivers.idx, writing   */
+/*              the header first if the file is new.  A record that was    */
+/*              only partly written is ignored.                            */
+/*                                                                         */
+/***************************************************************************/
+static int LoadArchiveIndex(int fd, int RecordLen, void **ppRecords, int *pNum,
+                            int *pSize)
+{
+  struct ArcHeader Header;
+  struct stat Stat;
+  long long count;
+
+  if (fstat(fd, &Stat) != 0) return ERR_ARCHIVE;
+
+  if (Stat.st_size == 0) {
+    memset(&Header, 0, sizeof(Header));
+    memcpy(Header.Magic, ARC_MAGIC, 8);
+    Header.RecordLen = RecordLen;
+    if (WriteAt(fd, &Header, sizeof(Header), 0) != OK || fsync(fd) != 0) {
+      return ERR_ARCHIVE;
+    };
+    Stat.st_size = sizeof(Header);
+  };
+
+  if (pread(fd, &Header, sizeof(Header), 0) != sizeof(Header) ||
+      memcmp(Header.Magic, ARC_MAGIC, 8) || Header.RecordLen != RecordLen) {
+    return ERR_ARCHIVE;
+  };
+
+  count = (Stat.st_size - (long long)sizeof(Header)) / RecordLen;
+  *pSize = (int)count + 64;
+  *ppRecords = malloc((size_t)*pSize * RecordLen);
+  if (! *ppRecords) return ERR_MEMORY_ERROR;
+  if (count > 0 &&
+      pread(fd, *ppRecords, (size_t)count * RecordLen, sizeof(Header)) != 
+      count * RecordLen) {
+    return ERR_ARCHIVE;
+  };
+  *pNum = (int)count;
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  FindArchived()                                               */
+/*                                                                         */
+/* Description: The latest archived copy of a receiver - the one attached  */
+/*              at AttachTime, or at any time if it is 0.  -1 if there     */
+/*              isn't one.  The caller holds the archive's lock, if there  */
+/*              are other threads.                                         */
+/*                                                                         */
+/***************************************************************************/
+static int FindArchived(struct Archive *pArc, char *QmgrLib, char *RcvName,
+                        JrnTime AttachTime)
+{
+  int   count;
+  struct ArcReceiver *pRcv;
+
+  if (! pArc->Hash) return -1;
+
+  for (count = pArc->NumRcvs - 1; count >= 0; count--) {
+    pRcv = &pArc->Rcvs[count];
+    if (! memcmp(pRcv->RcvName, RcvName, 10) &&
+        ! memcmp(pRcv->QmgrLib, QmgrLib, 10) &&
+        ( AttachTime == 0 || pRcv->AttachTime == AttachTime )) {
+      return count;
+    };
+  };
+  return -1;
+}
+
+/***************************************************************************/
+/* Function:  ArchiveSaveFile()                                            */
+/*                                                                         */
+/* Description: Save thread - add the save file just written for receiver  */
+/*              Entry to the archive, then delete it.  If the save file    */
+/*              can't be deleted the exception ID is returned in the error */
+/*              code structure.  It is kept if what was archived doesn't   */
+/*              read back the same.                                        */
+/*                                                                         */
+/***************************************************************************/
+static int ArchiveSaveFile(struct SavePipe *pPipe, int Entry,
+                           Qus_EC_t *pErrorData)
+{
+  struct QmgrMaint *pQm = pPipe->pQm;
+  struct Archive *pArc = pQm->pConfig->pArchive;
+  struct ArcReceiver Rcv;
+  char  Path[300];
+  int   retcode,
+  mismatch = FALSE;
+
+  memset(&Rcv, 0, sizeof(Rcv));
+  memcpy(Rcv.QmgrLib, pQm->QmgrLib, 10);
+  memcpy(Rcv.RcvName, pPipe->pIndex->Name[Entry], 10);
+  Rcv.AttachTime = pPipe->pIndex->AttachTime[Entry];
+  PlatSaveFilePath(pQm->SavLib, Rcv.RcvName, Path);
+
+  pthread_mutex_lock(&pArc->Lock);
+  retcode = ArchiveReceiver(pQm->pConfig, pArc, Path, &Rcv, &mismatch);
+  pthread_mutex_unlock(&pArc->Lock);
+  if (retcode != OK) {
+    pErrorData->Bytes_Available = 0;
+    pthread_mutex_lock(&pPipe->Lock);
+    pPipe->ArchiveMismatch = mismatch;
+    pthread_mutex_unlock(&pPipe->Lock);
+    return ERR_ARCHIVE;
+  };
+
+  pthread_mutex_lock(&pPipe->Lock);
+  pPipe->NumArchived++;
+  pPipe->ArchivedBytes += Rcv.Length;
+  pPipe->StoredBytes += Rcv.StoredBytes;
+  pPipe->NewChunks += Rcv.NewChunks;
+  pPipe->TotalChunks += Rcv.NumChunks;
+  pthread_mutex_unlock(&pPipe->Lock);
+
+  if (PlatDeleteSaveFile(pQm->SavLib, Rcv.RcvName, pErrorData)) {
+    return ERR_ARCHIVE;
+  };
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  ArchiveReceiver()                                            */
+/*                                                                         */
+/* Description: Add the save file at Path to the archive as receiver       */
+/*              *pRcv.  It is read ARC_BLOCK at a time and cut into        */
+/*              chunks; the chunks that aren't already in the archive are  */
+/*              compressed by several threads and appended.  The receiver  */
+/*              is only recorded once all its chunks are on disk, and if   */
+/*              this fails part way through the chunks it added are        */
+/*              dropped again, so the archive is unchanged.                */
+/*                                                                         */
+/*              A chunk is only known by its hash and length, so before    */
+/*              the receiver is recorded it is read back from the archive  */
+/*              and its length and checksum compared with the save file's; */
+/*              if they differ (two chunks with the same hash) *pMismatch  */
+/*              is set and it isn't recorded.  The caller holds the        */
+/*              archive's lock.                                            */
+/*                                                                         */
+/***************************************************************************/
+static int ArchiveReceiver(struct JrnMaintConfig *pConfig,
+                           struct Archive *pArc, char *Path,
+                           struct ArcReceiver *pRcv, int *pMismatch)
+{
+  char  print_buffer[400];
+  unsigned char *Buf = 0,
+  *Out = 0;
+  unsigned long long Id[2];
+  struct ArcJob *Jobs = 0;
+  struct ArcReceiver *pNewRcvs;
+  unsigned long long Checksum;
+  long long Length,
+  DataLen = pArc->DataLen;
+  int  *Recipe = 0,
+  *pNewRecipe,
+  RecipeSize = 0,
+  NumChunks = pArc->NumChunks,
+  NumJobs,
+  len = 0,
+  pos,
+  chunkLen,
+  chunk,
+  eof = FALSE,
+  fd,
+  retcode = OK;
+  long long got;
+
+  if (! pArc->Hash) return ERR_ARCHIVE;
+
+  fd = open(Path, O_RDONLY);
+  if (fd < 0) return ERR_ARCHIVE;
+
+  Buf = (unsigned char*)malloc(ARC_BLOCK + ARC_MAX_CHUNK);
+  Out = (unsigned char*)malloc(ARC_BLOCK + ARC_MAX_CHUNK);
+  Jobs = (struct ArcJob*)malloc(((ARC_BLOCK + ARC_MAX_CHUNK) / 
+                                 ARC_MIN_CHUNK + 1) * sizeof(struct ArcJob));
+  if (! Buf || ! Out || ! Jobs) retcode = ERR_MEMORY_ERROR;
+
+  pRcv->ArchiveTime = LocalSeconds() * 1000;
+  pRcv->Checksum = FNV_BASIS;
+  pRcv->Recipe = pArc->RecipeLen;
+
+  while (retcode == OK && (! eof || len > 0)) {
+    while (! eof && len < ARC_BLOCK + ARC_MAX_CHUNK) {
+      got = read(fd, Buf + len, ARC_BLOCK + ARC_MAX_CHUNK - len);
+      if (got < 0) {
+        retcode = ERR_ARCHIVE;
+        break;
+      };
+      if (got == 0) 
+        eof = TRUE;
+      else
+        len += (int)got;
+    };
+
+    /***********************************************************************/
+    /* Cut the block into chunks, leaving the last ARC_MAX_CHUNK bytes to  */
+    /* start the next one (unless this is the end of the file), so where   */
+    /* a chunk ends never depends on where a block ended                   */
+    /***********************************************************************/
+    pos = 0;
+    NumJobs = 0;
+    while (retcode == OK && pos < len && (eof || len - pos >= ARC_MAX_CHUNK)) {
+      chunkLen = ChunkLength(pArc, Buf + pos, len - pos);
+      ChunkId(Buf + pos, chunkLen, Id);
+      pRcv->Checksum = Fnv64(pRcv->Checksum, Buf + pos, chunkLen);
+
+      chunk = FindChunk(pArc, Id, chunkLen);
+      if (chunk < 0) {
+        chunk = AddChunk(pArc, Id, chunkLen);
+        if (chunk < 0) {
+          retcode = ERR_MEMORY_ERROR;
+          break;
+        };
+        Jobs[NumJobs].pRaw = Buf + pos;
+        Jobs[NumJobs].RawLen = chunkLen;
+        Jobs[NumJobs].pOut = Out + pos;
+        Jobs[NumJobs].OutLen = 0;
+        Jobs[NumJobs].Chunk = chunk;
+        NumJobs++;
+      };
+
+      if (pRcv->NumChunks >= RecipeSize) {
+        RecipeSize = RecipeSize ? RecipeSize * 2 : 1024;
+        pNewRecipe = (int*)realloc(Recipe, RecipeSize * sizeof(int));
+        if (! pNewRecipe) {
+          retcode = ERR_MEMORY_ERROR;
+          break;
+        };
+        Recipe = pNewRecipe;
+      };
+      Recipe[pRcv->NumChunks++] = chunk;
+      pRcv->Length += chunkLen;
+      pos += chunkLen;
+    };
+
+    if (retcode == OK) {
+      retcode = StoreChunks(pArc, Jobs, NumJobs, pRcv);
+    };
+    memmove(Buf, Buf + pos, len - pos);
+    len -= pos;
+  };
+  close(fd);
+
+  /*************************************************************************/
+  /* Then its recipe, and finally the receiver itself                      */
+  /*************************************************************************/
+  if (retcode == OK &&
+      ( WriteAt(pArc->RecipeFd, Recipe, 
+                (long long)pRcv->NumChunks * sizeof(int),
+                pArc->RecipeLen * sizeof(int)) != OK ||
+        fsync(pArc->RecipeFd) != 0 ) ) {
+    retcode = ERR_ARCHIVE;
+  };
+  if (retcode == OK) {
+    retcode = ReadArchived(pArc, pRcv, -1, &Length, &Checksum);
+    if (retcode == OK &&
+        (Length != pRcv->Length || Checksum != pRcv->Checksum)) {
+      *pMismatch = TRUE;
+      retcode = ERR_ARCHIVE;
+    };
+  };
+  if (retcode == OK && pArc->NumRcvs >= pArc->RcvsSize) {
+    pNewRcvs = (struct ArcReceiver*)realloc(pArc->Rcvs, 
+                 pArc->RcvsSize * 2 * sizeof(struct ArcReceiver));
+    if (pNewRcvs) {
+      pArc->Rcvs = pNewRcvs;
+      pArc->RcvsSize *= 2;
+    }
+    else {
+      retcode = ERR_MEMORY_ERROR;
+    };
+  };
+  if (retcode == OK &&
+      ( WriteAt(pArc->RcvFd, pRcv, sizeof(struct ArcReceiver),
+                sizeof(struct ArcHeader) + (long long)pArc->NumRcvs * 
+                sizeof(struct ArcReceiver)) != OK ||
+        fsync(pArc->RcvFd) != 0 ) ) {
+    retcode = ERR_ARCHIVE;
+  };
+  if (retcode == OK) {
+    pArc->RecipeLen += pRcv->NumChunks;
+    pArc->Rcvs[pArc->NumRcvs++] = *pRcv;
+  };
+
+  if (Buf) free(Buf);
+  if (Out) free(Out);
+  if (Jobs) free(Jobs);
+  if (Recipe) free(Recipe);
+
+  /*************************************************************************/
+  /* Chunks were added to the index in memory that may not have been       */
+  /* stored - drop them, and whatever was written for them, keeping the    */
+  /* archive (and its lock).  If the files can't be put back it is closed  */
+  /*************************************************************************/
+  if (retcode != OK) {
+    pArc->NumChunks = NumChunks;
+    pArc->DataLen = DataLen;
+    memset(pArc->Hash, 0, pArc->HashSize * sizeof(int));
+    for (chunk = 0; chunk < pArc->NumChunks; chunk++) {
+      HashChunk(pArc, chunk);
+    };
+    if (ftruncate(pArc->DataFd, pArc->DataLen) != 0 ||
+        ftruncate(pArc->ChunkFd, sizeof(struct ArcHeader) + 
+                  (long long)pArc->NumChunks * sizeof(struct ArcChunk))) {
+      sprintf(print_buffer, "ERROR: Can't recover archive %s", pArc->Dir);
+      output_config_error(pConfig, print_buffer);
+      UnloadArchive(pArc);
+    };
+  };
+  return retcode;
+}
+
+/***************************************************************************/
+/* Function:  StoreChunks()                                                */
+/*                                                                         */
+/* Description: Compress the new chunks of one block, on up to             */
+/*              ARC_THREADS threads (this one included), and append them   */
+/*              to chunks.dat in chunk number order, then their records    */
+/*              to chunks.idx.  A chunk that doesn't get smaller is        */
+/*              stored as it is.                                           */
+/*                                                                         */
+/***************************************************************************/
+static int StoreChunks(struct Archive *pArc, struct ArcJob *Jobs, int NumJobs,
+                       struct ArcReceiver *pRcv)
+{
+  struct ArcPool Pool;
+  struct ArcChunk *pChunk;
+  pthread_t Threads[ARC_THREADS];
+  unsigned char *pData;
+  int   NumStarted,
+  count,
+  first,
+  len;
+  long long Offset = pArc->DataLen;
+
+  if (NumJobs == 0) return OK;
+
+  Pool.Jobs = Jobs;
+  Pool.NumJobs = NumJobs;
+  Pool.Next = 0;
+  pthread_mutex_init(&Pool.Lock, NULL);
+  for (NumStarted = 0; 
+       NumStarted < ARC_THREADS - 1 && NumStarted < NumJobs - 1;
+       NumStarted++) {
+    if (pthread_create(&Threads[NumStarted], NULL, ArcWorker, &Pool)) {
+      break;
+    };
+  };
+  ArcWorker(&Pool);
+  for (count = 0; count < NumStarted; count++) {
+    pthread_join(Threads[count], NULL);
+  };
+  pthread_mutex_destroy(&Pool.Lock);
+
+  for (count = 0; count < NumJobs; count++) {
+    pData = Jobs[count].OutLen ? Jobs[count].pOut : Jobs[count].pRaw;
+    len = Jobs[count].OutLen ? Jobs[count].OutLen : Jobs[count].RawLen;
+    if (WriteAt(pArc->DataFd, pData, len, Offset) != OK) {
+      return ERR_ARCHIVE;
+    };
+    pChunk = &pArc->Chunks[Jobs[count].Chunk];
+    pChunk->Offset = Offset;
+    pChunk->StoredLen = len;
+    Offset += len;
+    pRcv->StoredBytes += len;
+    pRcv->NewChunks++;
+  };
+  if (fsync(pArc->DataFd) != 0) return ERR_ARCHIVE;
+  pArc->DataLen = Offset;
+
+  /*************************************************************************/
+  /* New chunks are numbered consecutively, so their records are too       */
+  /*************************************************************************/
+  first = Jobs[0].Chunk;
+  if (WriteAt(pArc->ChunkFd, &pArc->Chunks[first],
+              (long long)NumJobs * sizeof(struct ArcChunk),
+              sizeof(struct ArcHeader) + 
+              (long long)first * sizeof(struct ArcChunk)) != OK ||
+      fsync(pArc->ChunkFd) != 0) {
+    return ERR_ARCHIVE;
+  };
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  ArcWorker()                                                  */
+/*                                                                         */
+/* Description: Thread body - compress chunks from the pool until there    */
+/*              are none left                                              */
+/*                                                                         */
+/***************************************************************************/
+static void *ArcWorker(void *pArg)
+{
+  struct ArcPool *pPool = (struct ArcPool*)pArg;
+  struct ArcJob *pJob;
+
+  for (;;) {
+    pthread_mutex_lock(&pPool->Lock);
+    pJob = (pPool->Next < pPool->NumJobs) ? &pPool->Jobs[pPool->Next++] : 0;
+    pthread_mutex_unlock(&pPool->Lock);
+
+    if (! pJob) break;
+
+    pJob->OutLen = LzCompress(pJob->pRaw, pJob->RawLen, pJob->pOut);
+  };
+  return NULL;
+}
+
+/***************************************************************************/
+/* Function:  RestoreReceiver()                                            */
+/*                                                                         */
+/* Description: MODE(*RESTORE) - write the latest archived save file of    */
+/*              receiver RcvName to QMGRLIB.RCVNAME.savf in the archive    */
+/*              directory, checking it against the length and hash         */
+/*              recorded when it was archived.  Only that receiver's       */
+/*              chunks are read.                                           */
+/*                                                                         */
+/***************************************************************************/
+static int RestoreReceiver(struct QmgrMaint *pQm, char *RcvName)
+{
+  struct Archive *pArc = pQm->pConfig->pArchive;
+  struct ArcReceiver *pRcv;
+  unsigned long long Checksum;
+  int   retcode = OK,
+  entry,
+  rcvLen,
+  fd;
+  long long Length,
+  startTime;
+  char  Path[300],
+  AttachText[24],
+  ArchiveText[24],
+  print_buffer[700];
+
+  entry = FindArchived(pArc, pQm->QmgrLib, RcvName, 0);
+  if (entry < 0) {
+    sprintf(print_buffer, "ERROR: Receiver %10.10s of %s is not in archive "
+            "%s", RcvName, pQm->szQmgrLib, pArc->Dir);
+    output_error(pQm, print_buffer);
+    return ERR_ARCHIVE;
+  };
+  pRcv = &pArc->Rcvs[entry];
+
+  for (rcvLen = 10; rcvLen > 0 && RcvName[rcvLen - 1] == ' '; rcvLen--);
+  sprintf(Path, "%s/%s.%.*s.savf", pArc->Dir, pQm->szQmgrLib, rcvLen, 
+          RcvName);
+  fd = open(Path, O_WRONLY | O_CREAT | O_TRUNC, 
+            S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  if (fd < 0) retcode = ERR_ARCHIVE;
+
+  startTime = PlatMicroseconds();
+  if (retcode == OK) {
+    retcode = ReadArchived(pArc, pRcv, fd, &Length, &Checksum);
+  };
+  if (fd >= 0 && close(fd) != 0) retcode = ERR_ARCHIVE;
+
+  if (retcode != OK) {
+    sprintf(print_buffer, "ERROR: Can't restore receiver %10.10s of %s from "
+            "archive %s to %s", RcvName, pQm->szQmgrLib, pArc->Dir, Path);
+    output_error(pQm, print_buffer);
+    unlink(Path);
+    return retcode;
+  };
+  if (Length != pRcv->Length || Checksum != pRcv->Checksum) {
+    sprintf(print_buffer, "ERROR: Receiver %10.10s of %s restored from "
+            "archive %s does not match the save file archived", RcvName,
+            pQm->szQmgrLib, pArc->Dir);
+    output_error(pQm, print_buffer);
+    unlink(Path);
+    return ERR_ARCHIVE;
+  };
+
+  FormatJrnTime(pRcv->AttachTime, FALSE, AttachText);
+  FormatJrnTime(pRcv->ArchiveTime, FALSE, ArchiveText);
+  sprintf(print_buffer, "Restored receiver %10.10s (attached %s, archived "
+          "%s) to %s - %lld K in %lld ms", RcvName, AttachText, ArchiveText,
+          Path, Length / 1024, (PlatMicroseconds() - startTime) / 1000);
+  output(pQm, print_buffer);
+  return OK;
+}
+
+/***************************************************************************/
+/* Function:  ReadArchived()                                               */
+/*                                                                         */
+/* Description: Read archived receiver *pRcv back from its recipe and      */
+/*              chunks, writing it to fd (unless it is -1), and return the */
+/*              length and checksum of what was read.  The caller holds    */
+/*              the archive's lock, if there are other threads.            */
+/*                                                                         */
+/***************************************************************************/
+static int ReadArchived(struct Archive *pArc, struct ArcReceiver *pRcv, int fd,
+                        long long *pLength, unsigned long long *pChecksum)
+{
+  struct ArcChunk *pChunk;
+  unsigned char *Stored,
+  *Raw,
+  *pData;
+  unsigned long long Checksum = FNV_BASIS;
+  int   Recipe[ARC_RECIPE_BLOCK],
+  retcode = OK,
+  block,
+  count;
+  long long done,
+  Length = 0;
+
+  Stored = (unsigned char*)malloc(ARC_MAX_CHUNK);
+  Raw = (unsigned char*)malloc(ARC_MAX_CHUNK);
+  if (! Stored || ! Raw) retcode = ERR_MEMORY_ERROR;
+
+  for (done = 0; retcode == OK && done < pRcv->NumChunks; done += block) {
+    block = pRcv->NumChunks - done;
+    if (block > ARC_RECIPE_BLOCK) block = ARC_RECIPE_BLOCK;
+    if (pread(pArc->RecipeFd, Recipe, block * sizeof(int),
+              (pRcv->Recipe + done) * sizeof(int)) != block * sizeof(int)) {
+      retcode = ERR_ARCHIVE;
+      break;
+    };
+
+    for (count = 0; retcode == OK && count < block; count++) {
+      if (Recipe[count] < 0 || Recipe[count] >= pArc->NumChunks) {
+        retcode = ERR_ARCHIVE;
+        break;
+      };
+      pChunk = &pArc->Chunks[Recipe[count]];
+      if (pChunk->RawLen > ARC_MAX_CHUNK || 
+          pChunk->StoredLen > pChunk->RawLen ||
+          pread(pArc->DataFd, Stored, pChunk->StoredLen, pChunk->Offset) !=
+          pChunk->StoredLen) {
+        retcode = ERR_ARCHIVE;
+        break;
+      };
+      pData = Stored;
+      if (pChunk->StoredLen < pChunk->RawLen) {
+        if (LzExpand(Stored, pChunk->StoredLen, Raw, pChunk->RawLen) != OK) {
+          retcode = ERR_ARCHIVE;
+          break;
+        };
+        pData = Raw;
+      };
+      Checksum = Fnv64(Checksum, pData, pChunk->RawLen);
+      Length += pChunk->RawLen;
+      if (fd >= 0 && write(fd, pData, pChunk->RawLen) != pChunk->RawLen) {
+        retcode = ERR_ARCHIVE;
+      };
+    };
+  };
+  if (Stored) free(Stored);
+  if (Raw) free(Raw);
+
+  *pLength = Length;
+  *pChecksum = Checksum;
+  return retcode;
+}
+
+/***************************************************************************/
+/* Function:  ChunkLength()                                                */
+/*                                                                         */
+/* Description: Length of the chunk starting at pData.  It ends after the  */
+/*              first byte where the top ARC_CHUNK_BITS of a rolling hash  */
+/*              of the 64 bytes before it are all zero, so the same data   */
+/*              is cut the same way wherever it is in a save file.  The    */
+/*              first ARC_MIN_CHUNK - 64 bytes can't affect where that is  */
+/*              and aren't looked at.                                      */
+/*                                                                         */
+/***************************************************************************/
+static int ChunkLength(struct Archive *pArc, unsigned char *pData, int Length)
+{
+  unsigned long long Hash = 0;
+  int   pos;
+
+  if (Length <= ARC_MIN_CHUNK) return Length;
+  if (Length > ARC_MAX_CHUNK) Length = ARC_MAX_CHUNK;
+
+  for (pos = ARC_MIN_CHUNK - 64; pos < Length; pos++) {
+    Hash = (Hash << 1) + pArc->Gear[pData[pos]];
+    if (pos >= ARC_MIN_CHUNK && ! (Hash >> (64 - ARC_CHUNK_BITS))) {
+      return pos + 1;
+    };
+  };
+  return Length;
+}
+
+/***************************************************************************/
+/* Function:  ChunkId()                                                    */
+/*                                                                         */
+/* Description: 128 bit identifier of a chunk - two independent 64 bit     */
+/*              hashes of its contents.  Chunks are only compared by these */
+/*              and their length.                                          */
+/*                                                                         */
+/***************************************************************************/
+static void ChunkId(unsigned char *pData, int Length, unsigned long long *Id)
+{
+  unsigned long long Hash = 0x9E3779B97F4A7C15ULL ^ (unsigned)Length;
+  int   pos;
+
+  Id[0] = Fnv64(FNV_BASIS, pData, Length);
+
+  for (pos = 0; pos < Length; pos++) {
+    Hash = (Hash ^ pData[pos]) * 0xC6A4A7935BD1E995ULL;
+    Hash ^= Hash >> 47;
+  };
+  Hash ^= Hash >> 33;
+  Hash *= 0xFF51AFD7ED558CCDULL;
+  Id[1] = Hash ^ (Hash >> 33);
+}
+
+/***************************************************************************/
+/* Function:  Fnv64()                                                      */
+/***************************************************************************/
+static unsigned long long Fnv64(unsigned long long Hash, unsigned char *pData,
+                                int Length)
+{
+  int   pos;
+
+  for (pos = 0; pos < Length; pos++) {
+    Hash = (Hash ^ pData[pos]) * FNV_PRIME;
+  };
+  return Hash;
+}
+
+/***************************************************************************/
+/* Function:  FindChunk()                                                  */
+/*                                                                         */
+/* Description: Number of the chunk with this Id and length, or -1         */
+/*                                                                         */
+/***************************************************************************/
+static int FindChunk(struct Archive *pArc, unsigned long long *Id, int RawLen)
+{
+  unsigned int slot = (unsigned int)Id[0] & (pArc->HashSize - 1);
+  struct ArcChunk *pChunk;
+
+  while (pArc->Hash[slot]) {
+    pChunk = &pArc->Chunks[pArc->Hash[slot] - 1];
+    if (pChunk->Id[0] == Id[0] && pChunk->Id[1] == Id[1] &&
+        pChunk->RawLen == RawLen) {
+      return pArc->Hash[slot] - 1;
+    };
+    slot = (slot + 1) & (pArc->HashSize - 1);
+  };
+  return -1;
+}
+
+/***************************************************************************/
+/* Function:  AddChunk()                                                   */
+/*                                                                         */
+/* Description: Add a chunk to the index in memory, not yet stored         */
+/*              (Offset -1), and return its number - or -1 if there isn't  */
+/*              the memory.  The hash table is kept at most half full.     */
+/*                                                                         */
+/***************************************************************************/
+static int AddChunk(struct Archive *pArc, unsigned long long *Id, int RawLen)
+{
+  struct ArcChunk *pChunks;
+  struct ArcChunk *pChunk;
+  int  *pHash,
+  count;
+
+  if (pArc->NumChunks >= pArc->ChunksSize) {
+    pChunks = (struct ArcChunk*)realloc(pArc->Chunks, 
+                pArc->ChunksSize * 2 * sizeof(struct ArcChunk));
+    if (! pChunks) return -1;
+    pArc->Chunks = pChunks;
+    pArc->ChunksSize *= 2;
+  };
+
+  if ((pArc->NumChunks + 1) * 2 > pArc->HashSize) {
+    pHash = (int*)calloc(pArc->HashSize * 2, sizeof(int));
+    if (! pHash) return -1;
+    free(pArc->Hash);
+    pArc->Hash = pHash;
+    pArc->HashSize *= 2;
+    for (count = 0; count < pArc->NumChunks; count++) {
+      HashChunk(pArc, count);
+    };
+  };
+
+  pChunk = &pArc->Chunks[pArc->NumChunks];
+  pChunk->Id[0] = Id[0];
+  pChunk->Id[1] = Id[1];
+  pChunk->Offset = -1;
+  pChunk->RawLen = RawLen;
+  pChunk->StoredLen = 0;
+  HashChunk(pArc, pArc->NumChunks);
+  return pArc->NumChunks++;
+}
+
+/***************************************************************************/
+/* Function:  HashChunk()                                                  */
+/***************************************************************************/
+static void HashChunk(struct Archive *pArc, int Chunk)
+{
+  unsigned int slot = (unsigned int)pArc->Chunks[Chunk].Id[0] & 
+                      (pArc->HashSize - 1);
+
+  while (pArc->Hash[slot]) {
+    slot = (slot + 1) & (pArc->HashSize - 1);
+  };
+  pArc->Hash[slot] = Chunk + 1;
+}
+
+/***************************************************************************/
+/* Function:  LzCompress()                                                 */
+/*                                                                         */
+/* Description: Compress InLen bytes to Out, returning the compressed      */
+/*              length - or 0 if it would be no shorter than InLen, the    */
+/*              most Out needs room for.  The data is a series of          */
+/*              sequences, each a token byte (the number of literal bytes  */
+/*              in the high 4 bits, the match length - 4 in the low 4,     */
+/*              either followed by more bytes when it is 15), the          */
+/*              literals, and a 2 byte little endian offset back to the    */
+/*              match.  The last sequence is only literals.                */
+/*                                                                         */
+/***************************************************************************/
+static int LzCompress(unsigned char *In, int InLen, unsigned char *Out)
+{
+  int   Table[1 << LZ_HASH_BITS],
+  pos = 0,
+  anchor = 0,
+  out = 0,
+  match,
+  matchLen,
+  litLen,
+  n;
+  unsigned int seq;
+  unsigned char *pToken;
+
+  if (InLen < 16) return 0;
+  memset(Table, 0xFF, sizeof(Table));                /* All -1            */
+
+  /*************************************************************************/
+  /* Matches end at least 5 bytes before the end                           */
+  /*************************************************************************/
+  while (pos + 4 <= InLen - 5) {
+    seq = In[pos] | In[pos + 1] << 8 | In[pos + 2] << 16 | 
+          (unsigned int)In[pos + 3] << 24;
+    seq = (seq * 2654435761u) >> (32 - LZ_HASH_BITS);
+    match = Table[seq];
+    Table[seq] = pos;
+    if (match < 0 || pos - match > 65535 || memcmp(In + match, In + pos, 4)) {
+      pos++;
+      continue;
+    };
+
+    for (matchLen = 4; 
+         pos + matchLen < InLen - 5 && 
+         In[match + matchLen] == In[pos + matchLen];
+         matchLen++);
+    litLen = pos - anchor;
+    if (out + litLen + litLen / 255 + matchLen / 255 + 5 >= InLen) return 0;
+
+    pToken = &Out[out++];
+    *pToken = (litLen >= 15 ? 15 : litLen) << 4;
+    if (litLen >= 15) {
+      for (n = litLen - 15; n >= 255; n -= 255) Out[out++] = 255;
+      Out[out++] = n;
+    };
+    memcpy(Out + out, In + anchor, litLen);
+    out += litLen;
+    Out[out++] = (pos - match) & 0xFF;
+    Out[out++] = (pos - match) >> 8;
+    n = matchLen - 4;
+    *pToken |= n >= 15 ? 15 : n;
+    if (n >= 15) {
+      for (n -= 15; n >= 255; n -= 255) Out[out++] = 255;
+      Out[out++] = n;
+    };
+
+    pos += matchLen;
+    anchor = pos;
+  };
+
+  litLen = InLen - anchor;
+  if (out + litLen + litLen / 255 + 2 >= InLen) return 0;
+  Out[out++] = (litLen >= 15 ? 15 : litLen) << 4;
+  if (litLen >= 15) {
+    for (n = litLen - 15; n >= 255; n -= 255) Out[out++] = 255;
+    Out[out++] = n;
+  };
+  memcpy(Out + out, In + anchor, litLen);
+  return out + litLen;
+}
+
+/***************************************************************************/
+/* Function:  LzExpand()                                                   */
+/*                                                                         */
+/* Description: Expand data compressed by LzCompress() to exactly OutLen   */
+/*              bytes.  ERR_ARCHIVE if it is damaged.                      */
+/*                                                                         */
+/***************************************************************************/
+static int LzExpand(unsigned char *In, int InLen, unsigned char *Out,
+                    int OutLen)
+{
+  int   in = 0,
+  out = 0,
+  litLen,
+  matchLen,
+  offset,
+  n;
+  unsigned char token;
+
+  while (in < InLen) {
+    token = In[in++];
+    litLen = token >> 4;
+    if (litLen == 15) {
+      do {
+        if (in >= InLen) return ERR_ARCHIVE;
+        n = In[in++];
+        litLen += n;
+      } while (n == 255);
+    };
+    if (litLen > InLen - in || litLen > OutLen - out) return ERR_ARCHIVE;
+    memcpy(Out + out, In + in, litLen);
+    in += litLen;
+    out += litLen;
+    if (in == InLen) break;               /* The last sequence          */
+
+    if (in + 2 > InLen) return ERR_ARCHIVE;
+    offset = In[in] | In[in + 1] << 8;
+    in += 2;
+    matchLen = (token & 15) + 4;
+    if ((token & 15) == 15) {
+      do {
+        if (in >= InLen) return ERR_ARCHIVE;
+        n = In[in++];
+        matchLen += n;
+      } while (n == 255);
+    };
+    if (offset == 0 || offset > out || matchLen > OutLen - out) {
+      return ERR_ARCHIVE;
+    };
+    for (n = 0; n < matchLen; n++, out++) {     /* May overlap itself     */
+      Out[out] = Out[out - offset];
+    };
+  };
+  return out == OutLen ? OK : ERR_ARCHIVE;
+}
+
+/***************************************************************************/
+/* Function:  WriteAt()                                                    */
+/***************************************************************************/
+static int WriteAt(int fd, void *pData, long long Length, long long Offset)
+{
+  long long done = 0,
+  written;
+
+  while (done < Length) {
+    written = pwrite(fd, (char*)pData + done, Length - done, Offset + done);
+    if (written <= 0) return ERR_ARCHIVE;
+    done += written;
+  };
+  return OK;
+}
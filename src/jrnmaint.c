@@ -4,9 +4,20 @@
 /*  Author:         Mark Phillips                                          */
 /*  Function:       Automate jrn maintenance in IBM MQ for IBM i           */
 /*                                                                         */
-/*  Parameters:    argv[1] - char [10] - Queue manager name                */
+/*  Parameters:    argv[1] - list      - Queue manager libraries (or *ALL) */
 /*                 argv[2] - char [6]  - Output type     (*PRINT / *MSGQ)  */
 /*                 argv[3] - char [4]  - Delete receivers (*YES / *NO)     */
+/*                 argv[4] - int2      - Max queue managers in parallel    */
+/*                 argv[5] - char [9]  - Run mode      (*ONCE / *RESIDENT) */
+/*                 argv[6] - int2      - Resident check interval (seconds) */
+/*                 argv[7] to argv[29] - the rest of the MQJRNMNT          */
+/*                 parameters, in the order of the command definition     */
+/*                                                                         */
+/*  Called with two parameters it is the Delete Journal Receiver exit      */
+/*  program instead.                                                       */
+/*                                                                         */
+/*  The maintenance itself is done by the functions in jrnlib.c; this      */
+/*  program only turns the command's parameters into a JrnMaintConfig.     */
 /*                                                                         */
 /* Copyright (c) 2003,2024 IBM Corp.                                       */
 /*                                                                         */
@@ -23,66 +34,30 @@
 /* limitations under the License.                                          */
 /*                                                                         */
 /***************************************************************************/
+#define _MULTI_THREADED
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <ctype.h>
-#include <stddef.h>
-#include <qjournal.h>
-#include <qusec.h>
-#include <qusrtvus.h>
-#include <qmhsndm.h> 
-#include <ledate.h>
+#include <signal.h>
+#include "jrnplat.h"
+#include "jrnmaint.h"
 
 /***************************************************************************/
 /*  Constants used by this program                                         */
 /***************************************************************************/
-#undef TRUE
-#define TRUE 1
-#undef FALSE
-#define FALSE 0
-#undef OK
-#define OK 0        
-
-#define ERR_ARGUMENTS_ERROR      1         /* List of error codes */
-#define ERR_QMGR_LIB_NOT_FOUND   2         /* returned from main  */
-#define ERR_USER_SPACE_MISSING   3
-#define ERR_MEMORY_ERROR         4
-#define ERR_RETRIEVE_JRN_INF     5
-
-#define MAX_CHAIN 256         /* (Arbitrary) max. no of receivers in chain */
-#define JRN_NAME "AMQAJRN   " /* Journal name                              */
-#define SPC_NAME "AMQJRNINF " /* User Space Name                           */
+#define STDOUT_BUFFER 65536   /* stdout is written in blocks of this size  */
 
 /***************************************************************************/
 /*  Function prototypes                                                    */
 /***************************************************************************/
-int GetReceiverChain(char* LibName, int *NumRcvrs,
-                     Qjo_JN_Repeating_Key_1_Output_t *pRcvDirectory) ;
-void output(char *print_buffer); /* Print data with a timestamp */
-
-/***************************************************************************/
-/*  Structure defining format of AMQJRNINF user space                      */
-/***************************************************************************/
-struct {
-  char    JrnName[20];        /* Journal + library name */
-  char    CC[2];              /* Year (century)         */
-  char    YY[2];              /* Year                   */
-  char    MM[2];              /* Month                  */
-  char    DD[2];              /* Day                    */
-  char    HH[2];              /* Hours                  */
-  char    mm[2];              /* Minutes                */
-  char    SS[2];              /* Seconds                */
-  char    mmm[3];             /* Milliseconds           */
-} OldestJrnEntry;
+void GetPathParm(char *Parm, char *Path);
+void EndResident(int Signal);
 
 /***************************************************************************/
 /*  Global variables                                                       */
 /***************************************************************************/
-int       print_output = TRUE;
-char      message_queue[20];
-int       delete_receivers = FALSE;
-Qus_EC_t  ErrorData = { sizeof(Qus_EC_t), 0};
+volatile sig_atomic_t ending = FALSE;   /* MODE(*RESIDENT) job is ending   */
 
 
 /***************************************************************************/
@@ -91,439 +66,304 @@ Qus_EC_t  ErrorData = { sizeof(Qus_EC_t), 0};
 int main(int argc, char **argv)
 {
   int             retcode = OK,
-  NumRcvrs = 0, 
-  count = 0, 
-  deletecount = 0,
-  foundOldest = FALSE,
-  deleteReceivers = FALSE,                  
-  oldestReceiverIndex = 0,
-  outputMessages = FALSE;
-  char            cmdbuffer[200],
-  print_buffer[200],
-  QmgrLib[10],         /* Blank padded Qmgr library name */
-  szQmgrLib[11],       /* NULL terminated Qmgr lib. name */
-  *p,
-  TimeStamp[13],
-  AmqJrnIinfUsrSpc[20];
-  Qjo_JN_Repeating_Key_1_Output_t   *pRcvDirectory = 0,
-  *pTempRcvr = 0;  
+  count = 0,
+  NumQmgrs = 0,
+  NumThreads = 1,
+  Interval = 0,
+  resident = FALSE,
+  query = FALSE,
+  replay = FALSE,
+  restore = FALSE,
+  WindowHours = 0;
+  char            RestoreRcv[10],
+  TraceFile[257],
+  ArchiveDir[257];
+  struct JrnMaintConfig Config;
+  struct QmgrMaint *pQmgrs = 0;
+  struct sigaction Action;
+  long long       StartMicros,
+  StartupMicros;
+
+  /*************************************************************************/
+  /* Called as a Delete Journal Receiver exit program - just answer        */
+  /*************************************************************************/
+  if (argc == 3) {
+    JournalExit(argv[1], argv[2]);
+    return OK;
+  };
+
+  setvbuf(stdout, NULL, _IOFBF, STDOUT_BUFFER);
+  StartMicros = PlatMicroseconds();
+  JrnMaintInitConfig(&Config);
 
   printf("\n\n");
-  output("*****************************************************");
-  output("*   Starting JrnMaint journal maintenance program   *");
-  output("*****************************************************");
+  output(0, "*****************************************************");
+  output(0, "*   Starting JrnMaint journal maintenance program   *");
+  output(0, "*****************************************************");
 
   /*************************************************************************/
-  /* Check parameters & queue manager library are valid  & exit if not     */
+  /* Check parameters are valid & exit if not                              */
   /*************************************************************************/
-  if (argc != 4 ) {
-    printf("ERROR: Invalid Arguments - pass a 10 character "
-           "Queue manager library name, \n");
+  if (argc != 30 ) {
+    printf("ERROR: Invalid Arguments - pass a list of 10 character "
+           "Queue manager library names, \n");
     retcode = ERR_ARGUMENTS_ERROR;
     return retcode;
   }
 
-  /*************************************************************************/
-  /* Set up blank padded & null terminated qmgr names and convert to       */
-  /* upper case                                                            */
-  /*************************************************************************/
-  memcpy(QmgrLib, argv[1], 10);    
-  for (p = QmgrLib; count<10 ; p++, count++) {          /* Upper case name */
-    *p = toupper(*p);
-  };
-
-  memcpy(szQmgrLib, QmgrLib, 10);    
-  p = strchr(szQmgrLib, ' ');                      /* Find trailing spaces */
-  if (p) *p = '\0';                                /* and strip them off   */
-
-  memcpy(AmqJrnIinfUsrSpc, SPC_NAME, 10);         /* Setup user space name */
-  memcpy( &(AmqJrnIinfUsrSpc[10]), QmgrLib, 10);
-
   /*************************************************************************/
   /* Set ouput and deletion flags according to arguments 2 and 3           */
   /*************************************************************************/
   if ( ! memcmp(argv[2], "*PRINT", 6)) {
-    print_output = TRUE;
+    Config.PrintOutput = TRUE;
   }
   else {
-    print_output = FALSE;  
-    memcpy( message_queue, "QMQMMSG   ", 10);
-    memcpy( &(message_queue[10]), QmgrLib, 10);
+    Config.PrintOutput = FALSE;
   }
 
   if ( ! memcmp(argv[3], "*YES", 4))                 /*  Delete receivers? */
-    delete_receivers = TRUE;
+    Config.DeleteReceivers = TRUE;
   else
-    delete_receivers = FALSE;  
+    Config.DeleteReceivers = FALSE;
+
+  NumThreads = PlatGetInt2Parm(argv[4]);
+  if (NumThreads < 1) NumThreads = 1;
+  if (NumThreads > MAX_THREADS) NumThreads = MAX_THREADS;
+
+  resident = ! memcmp(argv[5], "*RESIDENT", 9);
+  query = ! memcmp(argv[5], "*HISTORY", 8);
+  replay = ! memcmp(argv[5], "*REPLAY", 7);
+  restore = ! memcmp(argv[5], "*RESTORE", 8);
+  Interval = PlatGetInt2Parm(argv[6]);
+  if (Interval < 1) Interval = 1;
+
+  Config.SaveReceivers = ! memcmp(argv[7], "*YES", 4); /* Save receivers? */
+  memset(Config.SaveLibrary, ' ', 10);
+  for (count = 0; count < 10 && argv[8][count]; count++) {
+    Config.SaveLibrary[count] = toupper(argv[8][count]);
+  };
 
   /*************************************************************************/
-  /* Check queue manager library exists                                    */
+  /* A line per receiver is useful on a listing, but not as a message per  */
+  /* receiver on QMQMMSG - *MSGQ only gets the summary unless asked        */
   /*************************************************************************/
-  sprintf(cmdbuffer, "CHKOBJ %s *LIB", szQmgrLib );  
-  if (system(cmdbuffer)) { /* Check library exists */
-    printf("ERROR: Queue manager library %1.10s not found\n", szQmgrLib );
-    retcode = ERR_QMGR_LIB_NOT_FOUND;
+  if ( ! memcmp(argv[9], "*RECEIVER", 9))
+    Config.LogLevel = LOG_RECEIVER;
+  else if ( ! memcmp(argv[9], "*SUMMARY", 8))
+    Config.LogLevel = LOG_SUMMARY;
+  else
+    Config.LogLevel = Config.PrintOutput ? LOG_RECEIVER : LOG_SUMMARY;
+
+  GetPathParm(argv[10], Config.MetricsFile);
+
+  Config.AnalyseJournal = ! memcmp(argv[11], "*YES", 4);
+  Config.AspThreshold = PlatGetInt2Parm(argv[12]);
+  Config.ChangeJournal = ! memcmp(argv[13], "*YES", 4);
+  Config.FindPinning = ! memcmp(argv[14], "*YES", 4);
+
+  GetPathParm(argv[15], Config.HistoryDir);
+  WindowHours = PlatGetInt2Parm(argv[16]);
+  if (WindowHours < 1) WindowHours = 1;
+
+  if (query && ! Config.HistoryDir[0]) {
+    printf("ERROR: MODE(*HISTORY) needs the HISTORY directory\n");
+    return ERR_ARGUMENTS_ERROR;
+  };
+
+  GetPathParm(argv[17], TraceFile);
+
+  Config.Policy.Extra = PlatGetInt2Parm(argv[18]);
+  if (Config.Policy.Extra < 0) Config.Policy.Extra = 0;
+  Config.Policy.MinAgeHours = PlatGetInt2Parm(argv[19]);
+  if (Config.Policy.MinAgeHours < 0) Config.Policy.MinAgeHours = 0;
+  Config.Policy.RequireSaved = ! memcmp(argv[20], "*YES", 4) &&
+                               ! Config.SaveReceivers;
+  retcode = ParseProtect(&Config, argv[21]);
+  if (retcode != OK) {
     return retcode;
-  }
+  };
+
+  GetPathParm(argv[22], ArchiveDir);
+  memset(RestoreRcv, ' ', 10);
+  for (count = 0; count < 10 && argv[23][count]; count++) {
+    RestoreRcv[count] = toupper(argv[23][count]);
+  };
 
   /*************************************************************************/
-  /* Get the timestamp of the oldest jrn entry from the AMQJRNINF *USRSPC  */
+  /* Pacing of the deletes - it stops waiting once the job is ending       */
   /*************************************************************************/
-  ErrorData.Bytes_Available = 0;
-  ErrorData.Bytes_Provided =  sizeof(Qus_EC_t);
-  QUSRTVUS( AmqJrnIinfUsrSpc, 1, sizeof(OldestJrnEntry), 
-            (char*)&OldestJrnEntry, &ErrorData);
+  Config.DeleteRateK = PlatGetInt4Parm(argv[24]);
+  if (Config.DeleteRateK < 0) Config.DeleteRateK = 0;
+  Config.DeletesPerMin = PlatGetInt2Parm(argv[25]);
+  if (Config.DeletesPerMin < 0) Config.DeletesPerMin = 0;
+  GetPathParm(argv[26], Config.LoadProbe);
+  Config.pStop = &ending;
 
   /*************************************************************************/
-  /* If we didn't find the user space we can't go any further.             */
+  /* MEDIAIMG(*YES) records the images holding the oldest receiver after   */
+  /* CHGJRN, so the receiver that was attached can be released too.  It   */
+  /* is a single run - in resident mode the queue manager's own media      */
+  /* images and checkpoints move the cutoff on between checks.             */
   /*************************************************************************/
-  if ( ErrorData.Bytes_Available != OK) {
-    printf("ERROR: Journal user space (%s) not found in library %s.  "
-           "Error code: %7.7s\n", SPC_NAME, szQmgrLib, 
-           ErrorData.Exception_Id);
-    retcode = ERR_USER_SPACE_MISSING;
-    return retcode;
+  Config.MediaImages = ! memcmp(argv[27], "*YES", 4);
+  Config.MaxImages = PlatGetInt2Parm(argv[28]);
+  if (Config.MaxImages < 1) Config.MaxImages = 1;
+  Config.ImageWait = PlatGetInt2Parm(argv[29]);
+  if (Config.ImageWait < 0) Config.ImageWait = 0;
+  if (Config.MediaImages) {
+    Config.ChangeJournal = TRUE;
+  };
+  if (Config.MediaImages && (resident || query || restore || replay)) {
+    printf("ERROR: MEDIAIMG(*YES) can only be used with MODE(*ONCE)\n");
+    return ERR_ARGUMENTS_ERROR;
   };
 
   /*************************************************************************/
-  /* Turn the timestamp into CYYMMDDHHMMSS so can compare it wih the rcvrs */
+  /* Receivers are added to the ARCHIVE from their save files, so it needs */
+  /* SAVRCV(*YES) - other than to restore one with MODE(*RESTORE)          */
   /*************************************************************************/
-  if (OldestJrnEntry.CC[0] == '1')
-    TimeStamp[0] = '0'; /* 20th century */
-  else
-    TimeStamp[0] = '1'; /* 21st century */
+  if (restore && (! ArchiveDir[0] || ! memcmp(RestoreRcv, "*NONE", 5))) {
+    printf("ERROR: MODE(*RESTORE) needs the ARCHIVE directory and "
+           "RSTRCV\n");
+    return ERR_ARGUMENTS_ERROR;
+  };
+  if (ArchiveDir[0] && ! restore && ! Config.SaveReceivers) {
+    printf("ERROR: ARCHIVE can only be used with SAVRCV(*YES)\n");
+    return ERR_ARGUMENTS_ERROR;
+  };
 
-  sprintf( &(TimeStamp[1]), "%2.2s%2.2s%2.2s%2.2s%2.2s%2.2s",
-           OldestJrnEntry.YY, OldestJrnEntry.MM, OldestJrnEntry.DD, 
-           OldestJrnEntry.HH, OldestJrnEntry.mm, OldestJrnEntry.SS);
+  /*************************************************************************/
+  /* MODE(*REPLAY) runs the captured traces through the cutoff and delete  */
+  /* planning logic, without touching any queue manager                    */
+  /*************************************************************************/
+  if (replay) {
+    if (! TraceFile[0]) {
+      printf("ERROR: MODE(*REPLAY) needs the TRACE file\n");
+      return ERR_ARGUMENTS_ERROR;
+    };
+    return ReplayTrace(&Config, TraceFile);
+  };
 
   /*************************************************************************/
-  /* Allocate the memory for rcvr data                                     */
+  /* Otherwise TRACE is written.  Only a single run is traced.             */
   /*************************************************************************/
-  pRcvDirectory = (Qjo_JN_Repeating_Key_1_Output_t*) 
-                  calloc(sizeof(Qjo_JN_Repeating_Key_1_Output_t), MAX_CHAIN);
-  if (! pRcvDirectory ) {
-    printf("ERROR: Out of memory when allocating pRcvDirectory\n");
-    retcode = ERR_MEMORY_ERROR;
-    return retcode;
+  if (TraceFile[0] && (resident || query || restore)) {
+    printf("ERROR: TRACE can only be written with MODE(*ONCE)\n");
+    return ERR_ARGUMENTS_ERROR;
+  };
+  if (TraceFile[0] && Config.MediaImages) {
+    printf("ERROR: TRACE can't be written with MEDIAIMG(*YES) - the "
+           "cutoff it captures moves during the run\n");
+    return ERR_ARGUMENTS_ERROR;
+  };
+  if (TraceFile[0]) {
+    retcode = OpenTrace(&Config, TraceFile);
+    if (retcode != OK) {
+      return retcode;
+    };
   };
 
   /*************************************************************************/
-  /* Issue call to get the receiver chain                                  */
+  /* Work out which queue manager libraries to process - those listed, or  */
+  /* every queue manager in mqs.ini for *ALL                               */
   /*************************************************************************/
-  retcode = GetReceiverChain(QmgrLib, &NumRcvrs, pRcvDirectory);
+  retcode = GetQmgrLibraries(&Config, argv[1], &pQmgrs, &NumQmgrs);
+  if (retcode != OK) {
+    CloseTrace(&Config);
+    return retcode;
+  };
 
   /*************************************************************************/
-  /* If we got the data OK...                                              */
+  /* Each receiver is saved to a save file of the same name, and every     */
+  /* queue manager names its receivers the same way, so one save library   */
+  /* can only be shared by queue managers if it is their own library       */
   /*************************************************************************/
-  if (retcode == OK) {
-
-    sprintf(print_buffer, "Timestamp of oldest journal entry: (%13.13s)", 
-            TimeStamp);
-    output(print_buffer);
-
-    /***********************************************************************/
-    /* Loop through the receivers in the receiver chain starting from the  */
-    /* newest, looking for receivers that we can delete                    */
-    /***********************************************************************/
-    for (count=NumRcvrs-1; count >= 0 ;count--) {
-
-      pTempRcvr = &(pRcvDirectory[count]);
-      /*********************************************************************/
-      /*  If this receiver was attached BEFORE the oldest journal entry... */
-      /*********************************************************************/
-      if ( memcmp(pTempRcvr->Jrn_Rcv_Att_Date_Time, TimeStamp,
-                  sizeof(TimeStamp) ) < 0 ) {
-
-        /*******************************************************************/
-        /* If we haven't yet found the oldest receiver, yet then this must */
-        /* be the oldest receiver we need to keep on the system            */
-        /*******************************************************************/
-        if ( foundOldest == FALSE ) {
-
-          foundOldest = TRUE;
-          oldestReceiverIndex = count;
-          sprintf(print_buffer, 
-                  "Keeping receiver: %10.10s attached at: %13.13s",
-                  pTempRcvr->Jrn_Rcv_Name,
-                  pTempRcvr->Jrn_Rcv_Att_Date_Time);
-          output(print_buffer);
-          sprintf(print_buffer, 
-                  "** %10.10s is the oldest *JRNRCV that we need to keep **",
-                  pTempRcvr->Jrn_Rcv_Name);
-          output(print_buffer);
-
-          /*****************************************************************/
-          /*  If we're really deleting receivers we need to jump out of    */
-          /*  this loop and drop into the next one to do the deletes       */
-          /*****************************************************************/
-          if ( delete_receivers == TRUE ) {
-            break;         
-          };
-
-        }
-        /*******************************************************************/
-        /*  ...else, we've already seen the oldest journal receiver in the */
-        /*  chain, but we're still in this loop... we're therefore not     */
-        /*  actually deleting receivers - just report this one as eligible */
-        /*  for deletion                                                   */
-        /*******************************************************************/
-        else {
-          sprintf(print_buffer, 
-                  "Receiver %10.10s attached at: %13.13s can be deleted",
-                  pTempRcvr->Jrn_Rcv_Name, 
-                  pTempRcvr->Jrn_Rcv_Att_Date_Time);
-          output(print_buffer);
-        };
-      }
-
-      /*********************************************************************/
-      /*  Else this receiver was attached AFTER the oldest journal entry.  */
-      /*********************************************************************/
-      else {
-        sprintf(print_buffer, 
-                "Keeping receiver: %10.10s attached at: %13.13s",
-                pTempRcvr->Jrn_Rcv_Name,
-                pTempRcvr->Jrn_Rcv_Att_Date_Time);
-        output(print_buffer);
-      };
-
-    }; /* End first for loop */
-
-
-    /***********************************************************************/
-    /*  If we're actually deleting receivers, then they must be deleted    */
-    /*  oldest first.  So now we loop through starting from the oldest,    */
-    /*  deleting all the receivers older than the one we need to keep      */
-    /***********************************************************************/
-    if ( delete_receivers == TRUE && foundOldest == TRUE ) {
-
-      for (count=0; count < oldestReceiverIndex ;count++) {
-
-        pTempRcvr = &(pRcvDirectory[count]);
-        sprintf(print_buffer, 
-                "Deleting Receiver %10.10s attached at: %13.13s",
-                pTempRcvr->Jrn_Rcv_Name, 
-                pTempRcvr->Jrn_Rcv_Att_Date_Time);
-        output(print_buffer);
-
-        /*******************************************************************/
-        /*  Set up delete command and delete receiver                      */
-        /*******************************************************************/
-        memset( cmdbuffer, 0, sizeof(cmdbuffer) );
-        sprintf( cmdbuffer, "DLTJRNRCV %s/%10.10s DLTOPT(*IGNINQMSG)",
-                 szQmgrLib, pTempRcvr->Jrn_Rcv_Name);
-        retcode = system(cmdbuffer);
-
-        if ( retcode ) {
-          printf("ERROR: %d from DLTJRNRCV.  See job log for details\n", 
-                 retcode );
-          break;
-        };
-
-        deletecount++;
-
-      };
+  if (Config.SaveReceivers && NumQmgrs > 1 &&
+      memcmp(Config.SaveLibrary, "*QMGRLIB  ", 10)) {
+    printf("ERROR: SAVLIB(%10.10s) can only be used with a single queue "
+           "manager library - use SAVLIB(*QMGRLIB)\n", Config.SaveLibrary);
+    FreeQmgrs(pQmgrs, NumQmgrs);
+    CloseTrace(&Config);
+    return ERR_ARGUMENTS_ERROR;
+  };
 
+  if (ArchiveDir[0] && ! query) {
+    retcode = OpenArchive(&Config, ArchiveDir);
+    if (retcode != OK) {
+      FreeQmgrs(pQmgrs, NumQmgrs);
+      CloseTrace(&Config);
+      return retcode;
     };
   };
+  StartupMicros = PlatMicroseconds() - StartMicros;
 
   /*************************************************************************/
-  /*  Finished - Free the receiver directory if it was allocated           */
+  /* MODE(*RESTORE) writes a receiver's save file back out of the          */
+  /* archive, MODE(*HISTORY) only reports on the history files...          */
   /*************************************************************************/
-  sprintf(print_buffer, 
-          "JrnMaint finished - %d receiver(s) have been deleted.", 
-          deletecount);
-  output(print_buffer);
+  if (restore) {
+    retcode = RunRestore(pQmgrs, NumQmgrs, RestoreRcv);
+  }
+  else if (query) {
+    retcode = RunQuery(pQmgrs, NumQmgrs, WindowHours);
+  }
+  /*************************************************************************/
+  /* ...in resident mode stay active until the job is ended (ENDJOB        */
+  /* OPTION(*CNTRLD) sends SIGTERM)...                                     */
+  /*************************************************************************/
+  else if (resident) {
+    memset(&Action, 0, sizeof(Action));
+    Action.sa_handler = EndResident;
+    sigemptyset(&Action.sa_mask);
+    sigaction(SIGTERM, &Action, NULL);
+    sigaction(SIGINT, &Action, NULL);
 
-  if (pRcvDirectory) {
-    free(pRcvDirectory);
+    retcode = RunResident(&Config, pQmgrs, NumQmgrs, Interval,
+                          StartupMicros, &ending);
   }
+  /*************************************************************************/
+  /* ...otherwise process each queue manager once                          */
+  /*************************************************************************/
+  else {
+    retcode = RunOnce(&Config, pQmgrs, NumQmgrs, NumThreads, StartMicros,
+                      StartupMicros);
+  };
+
+  FreeQmgrs(pQmgrs, NumQmgrs);
+  CloseArchive(&Config);
+  CloseTrace(&Config);
   return retcode;
 }
 
-
 /***************************************************************************/
-/* Function:  output()                                                     */
+/* Function:  GetPathParm()                                                */
 /*                                                                         */
-/* Description: Print messages preceded by a timestamp or send to          */
-/*              the queue manager message queue depending on the           */
-/*              OUTPUT() options specified                                 */
+/* Description: A path name parameter with its trailing blanks stripped,   */
+/*              or "" for *NONE                                            */
 /*                                                                         */
 /***************************************************************************/
-void output(char *print_buffer) 
+void GetPathParm(char *Parm, char *Path)
 {
-  char      localdatetime[23];
-  _INT4     days;
-  _FLOAT8   secs;
-  _FEEDBACK fb;
-  CEELOCT(&days, &secs, localdatetime, &fb);
-
-  if (print_output) {
-    printf("%2.2s:%2.2s:%2.2s-%s \n",
-           &localdatetime[8],     /* Hours        */
-           &localdatetime[10],    /* Minutes      */
-           &localdatetime[12],    /* Seconds      */
-           print_buffer);
-  }
-  else {
+  int   count = 0;
 
-    ErrorData.Bytes_Available = 0;
-    ErrorData.Bytes_Provided =  sizeof(Qus_EC_t);
-    QMHSNDM( "       ",
-             "                    ",
-             print_buffer,          
-             strlen(print_buffer),
-             "*INFO     ",
-             message_queue,
-             1,
-             "                    ",
-             "    ",
-             &ErrorData);
-    
-    /***********************************************************************/
-    /* Report errors from send message                                     */
-    /***********************************************************************/
-    if ( ErrorData.Bytes_Available ) {
-      printf("ERROR: %7.7s from QMHSNDM\n",
-             &(ErrorData.Exception_Id) );
-    };
+  memset(Path, 0, 257);
+  if (! memcmp(Parm, "*NONE", 5)) return;
+
+  for (count = 0; count < 256 && Parm[count]; count++) {
+    Path[count] = Parm[count];
+  };
+  while (count > 0 && Path[count - 1] == ' ') {            /* Strip blanks */
+    Path[--count] = '\0';
   };
 }
 
 /***************************************************************************/
+/* Function:  EndResident()                                                */
 /*                                                                         */
-/* Function:    GetReceiverChain                                           */
-/*                                                                         */
-/* Description: Get the list of receivers in the current  journal          */
-/*              receiver chain                                             */
-/*                                                                         */
-/* Parameters:  JName         - 10 byte journal library name               */
-/*              NumRcvrs      - Number of receivers returned               */
-/*              pRcvDirectory - The buffer of journal receiver data        */
+/* Description: Signal handler - ENDJOB OPTION(*CNTRLD) sends SIGTERM      */
 /*                                                                         */
 /***************************************************************************/
-
-int GetReceiverChain(char* LibName, int *NumRcvrs,
-                     Qjo_JN_Repeating_Key_1_Output_t *pRcvDirectory) 
+void EndResident(int Signal)
 {
-  Qjo_RJRN0100_t *pRtnJrnInf; 
-  int             retcode = OK;
-  long            JrnDataLen = 0;
-  char          *JrnData,
-  JrnName[20],  /* Jrn name (10) followed by lib name (10) */
-  print_buffer[200];
-
-  Qjo_JN_Repeating_Key_Fields_t *pKeyFld1Hdr = 
-  (Qjo_JN_Repeating_Key_Fields_t*)0;
-  Qjo_JN_Key_1_Output_Section_t *pKeyFld1OutputHdr = 
-  (Qjo_JN_Key_1_Output_Section_t*)0;
-  Qjo_JN_Repeating_Key_1_Output_t *pKeyFld1Data = 
-  (Qjo_JN_Repeating_Key_1_Output_t*)0;
-
-  struct KData {
-    _INT4    KeyCount;        /* Count of all keys  (=1)   */
-    _INT4    Len;             /* Length of this key  (=12) */
-    _INT4    KeyID;           /* Key ID              (=1)  */
-    _INT4    DataLen;         /* Length of data      (=0)  */
-  } KeyData = {1,12,1,0};
-
-  /*************************************************************************/
-  /* Set up the qualified journal name                                     */
-  /*************************************************************************/
-  memcpy(JrnName, JRN_NAME,10);
-  memcpy(&(JrnName[10]), LibName,10);
-
-  /*************************************************************************/
-  /* Set up the size of the receiver variable - all the headers            */
-  /* plus the buffer for rcvrs                                             */
-  /*************************************************************************/
-  JrnDataLen =  sizeof(Qjo_RJRN0100_t) + 
-                sizeof(Qjo_JN_Repeating_Key_Fields_t) + 
-                sizeof(Qjo_JN_Key_1_Output_Section_t) + 
-                sizeof(Qjo_RRCV0100_t) * MAX_CHAIN ;
-  JrnData = (char*)malloc(JrnDataLen);
-  if ( ! JrnData ) {
-    printf("ERROR: Memory allocation error (JrnData)\n");
-    retcode = ERR_MEMORY_ERROR;    
-  };
-
-  /*************************************************************************/
-  /* Get the journal receiver chain                                        */
-  /*************************************************************************/
-
-  if (retcode == OK) {
-    ErrorData.Bytes_Available = 0;
-    ErrorData.Bytes_Provided =  sizeof(Qus_EC_t);
-    QjoRetrieveJournalInformation(JrnData, &JrnDataLen,
-                                  JrnName, QJO_RTV_JRN_INFO_0100,
-                                  (char*)&KeyData, &ErrorData);
-
-    /***********************************************************************/
-    /* Print error data if the command failed                              */
-    /***********************************************************************/
-    if ( ErrorData.Bytes_Available ) {
-      printf("ERROR: %7.7s from QjoRetrieveJournalInformation\n",
-             &(ErrorData.Exception_Id) );
-      if ((ErrorData.Bytes_Available - sizeof(ErrorData)) > 0)
-        printf("- Error data:", (char*)&ErrorData + sizeof(ErrorData),
-               ErrorData.Bytes_Available - sizeof(ErrorData));
-      retcode = ERR_RETRIEVE_JRN_INF;      
-    };
-  };
-
-  /*************************************************************************/
-  /* if the API completed successfully, report the basic journal data      */
-  /*************************************************************************/
-  if (retcode == OK) {
-    pRtnJrnInf = (Qjo_RJRN0100_t*)JrnData; 
-
-    /***********************************************************************/
-    /* Set up the receiver directory return fields                         */
-    /* The journal receiver list is returned at the end of a list of       */
-    /* chained structures - unscramble the jrnrcvr directory data          */
-    /***********************************************************************/
-    pKeyFld1Hdr = (Qjo_JN_Repeating_Key_Fields_t*)
-                  ((char*)JrnData + sizeof(Qjo_RJRN0100_t));
-    pKeyFld1OutputHdr = (Qjo_JN_Key_1_Output_Section_t*)
-                        ((char*)pKeyFld1Hdr + 
-                         pKeyFld1Hdr->Off_Strt_Key_Info);
-    pKeyFld1Data = (Qjo_JN_Repeating_Key_1_Output_t*)
-                   ((char*)pKeyFld1OutputHdr + 
-                    sizeof(Qjo_JN_Key_1_Output_Section_t));
-
-    *NumRcvrs = pKeyFld1Hdr->Number_Entries;
-    sprintf(print_buffer, 
-            "Processing %d receivers for AMQAJRN in %10.10s", 
-            *NumRcvrs, LibName );
-    output(print_buffer);
-    
-    if (*NumRcvrs > MAX_CHAIN) {
-      sprintf(print_buffer, 
-              "WARNING - More than %d receivers found"
-              " - not all will be processed", MAX_CHAIN );
-      output(print_buffer);
-      *NumRcvrs= MAX_CHAIN;
-    };
-    
-    memcpy(pRcvDirectory,  (void*)pKeyFld1Data, 
-           *NumRcvrs * sizeof(Qjo_JN_Repeating_Key_1_Output_t));
-
-    /***********************************************************************/
-    /* Trace some of the returned data                                     */
-    /***********************************************************************/
-    sprintf(print_buffer, "Attached receiver name: %10.10s",
-            pRtnJrnInf->Att_Jrn_Rcv_Name );
-    output(print_buffer);
-  }; /* End if retcode == OK */
-
-  /*************************************************************************/
-  /* Free the storage used to retrieve the data                            */
-  /*************************************************************************/
-  if (JrnData) {
-    free(JrnData);
-  };
-
-  return retcode;
+  ending = TRUE;
 }
-
@@ -0,0 +1,283 @@
+/***************************************************************************/
+/*                                                                         */
+/*  Header name:    JRNMAINT                                               */
+/*  Function:       Journal maintenance library interface                  */
+/*                                                                         */
+/*  jrnlib.c implements the journal maintenance for IBM MQ for IBM i that  */
+/*  the MQJRNMNT command runs.  The command's program (jrnmaint.c) only    */
+/*  turns its parameters into a JrnMaintConfig and calls the functions     */
+/*  declared here; other programs can call them in the same way, or keep   */
+/*  a context per queue manager and use the JrnMaintLoad(), Cutoff(),      */
+/*  Plan() and Execute() calls to get the answers directly.                */
+/*                                                                         */
+/*  The settings are held in the JrnMaintConfig each context was created   */
+/*  with, rather than in global variables, so any number of contexts -     */
+/*  with the same or different settings - can be used at once.  A context  */
+/*  must only be used by one thread at a time.                             */
+/*                                                                         */
+/* Copyright (c) 2003,2024 IBM Corp.                                       */
+/*                                                                         */
+/* Licensed under the Apache License, Version 2.0 (the "License");         */
+/* you may not use this file except in compliance with the License.        */
+/* You may obtain a copy of the License at                                 */
+/*                                                                         */
+/*    http://www.apache.org/licenses/LICENSE-2.0                           */
+/*                                                                         */
+/* Unless required by applicable law or agreed to in writing, software     */
+/* distributed under the License is distributed on an "AS IS" BASIS,       */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.*/
+/* See the License for the specific language governing permissions and     */
+/* limitations under the License.                                          */
+/*                                                                         */
+/***************************************************************************/
+#ifndef JRNMAINT_H
+#define JRNMAINT_H
+
+#include <stdio.h>
+#include <signal.h>
+#include <pthread.h>
+
+#undef TRUE
+#define TRUE 1
+#undef FALSE
+#define FALSE 0
+#undef OK
+#define OK 0
+
+#define ERR_ARGUMENTS_ERROR      1         /* List of error codes */
+#define ERR_QMGR_LIB_NOT_FOUND   2         /* returned by the     */
+#define ERR_USER_SPACE_MISSING   3         /* library, and from   */
+#define ERR_MEMORY_ERROR         4         /* the program         */
+#define ERR_RETRIEVE_JRN_INF     5
+#define ERR_MQS_INI              6
+#define ERR_DELETE_FAILED        7
+#define ERR_SAVE_FAILED          8
+#define ERR_METRICS_FILE         9
+#define ERR_CHGJRN_FAILED       10
+#define ERR_USER_SPACE_INVALID  11
+#define ERR_HISTORY_FILE        12
+#define ERR_TRACE_FILE          13
+#define ERR_REPLAY_MISMATCH     14
+#define ERR_ARCHIVE             15
+#define ERR_RCDMQMIMG           16
+
+#define MAX_THREADS 32        /* Max. queue managers processed in parallel */
+#define MAX_PROTECT 20        /* Max. receivers or ranges on PROTECT       */
+
+#define LOG_NONE     0        /* No output - results are only returned     */
+#define LOG_SUMMARY  1        /* DETAIL(*SUMMARY) - totals and the cutoff  */
+#define LOG_RECEIVER 2        /* DETAIL(*RECEIVER) - a line per receiver   */
+
+#define PLAN_NEEDED  'N'     /* Needed by the queue manager               */
+#define PLAN_DELETE  'D'     /* Not needed - to be deleted                */
+#define PLAN_RETAIN  'R'     /* Not needed, but kept by RETAIN            */
+#define PLAN_PROTECT 'P'     /* - kept by PROTECT                         */
+#define PLAN_RECENT  'A'     /* - kept by MINAGE                          */
+#define PLAN_UNSAVED 'U'     /* - kept by REQSAVED(*YES)                  */
+
+/***************************************************************************/
+/*  Times are held as milliseconds from 1970-01-01 00:00:00 local time.    */
+/*  They are built once from the AMQJRNINF user space and from each        */
+/*  receiver's attach time, and then only compared as integers.            */
+/***************************************************************************/
+typedef long long JrnTime;
+
+/***************************************************************************/
+/*  Retention policy - which of the receivers the queue manager no longer  */
+/*  needs are deleted.  A PROTECT value is a receiver name, a generic name */
+/*  or a range of receivers, held as the first and last names.            */
+/***************************************************************************/
+struct ProtectRange {
+  char    First[10];          /* First receiver, or generic name prefix  */
+  char    Last[10];           /* Last receiver                           */
+  int     Generic;            /* Length of a generic name's prefix       */
+};
+
+struct RetainPolicy {
+  int     Extra;              /* RETAIN - receivers kept before the      */
+                              /* oldest one needed                       */
+  int     MinAgeHours;        /* MINAGE - hours since it was detached    */
+  int     RequireSaved;       /* REQSAVED(*YES), unless SAVRCV(*YES)     */
+  int     NumProtect;         /* PROTECT                                 */
+  struct ProtectRange Protect[MAX_PROTECT];
+};
+
+/***************************************************************************/
+/*  Settings - the MQJRNMNT parameters.  Set up by JrnMaintInitConfig()    */
+/*  with the command defaults, changed by the caller, and then only read  */
+/*  while contexts created with it are in use.                            */
+/***************************************************************************/
+struct JrnMaintConfig {
+  int     PrintOutput;        /* OUTPUT(*PRINT), otherwise *MSGQ         */
+  int     LogLevel;           /* DETAIL - LOG_                           */
+  int     DeleteReceivers;    /* DLTRCV(*YES)                            */
+  int     SaveReceivers;      /* SAVRCV(*YES)                            */
+  char    SaveLibrary[10];    /* SAVLIB, or *QMGRLIB                     */
+  char    MetricsFile[257];   /* METRICS path, or "" for *NONE           */
+  int     AnalyseJournal;     /* ANALYZE(*YES)                           */
+  int     AspThreshold;       /* ASP % to forecast reaching, 0 for none  */
+  int     ChangeJournal;      /* CHGJRN(*YES)                            */
+  int     FindPinning;        /* FINDPIN(*YES)                           */
+  char    HistoryDir[257];    /* HISTORY directory, or "" for *NONE      */
+  FILE   *TraceFp;            /* TRACE file, set by OpenTrace()          */
+  struct RetainPolicy Policy; /* RETAIN, MINAGE, REQSAVED and PROTECT    */
+  struct Archive *pArchive;   /* ARCHIVE, set by OpenArchive()           */
+  pthread_mutex_t TraceLock;  /* Serialises writing the TRACE file       */
+  int     DeleteRateK;        /* DLTRATE - K a second, 0 for *NOMAX      */
+  int     DeletesPerMin;      /* DLTPERMIN - receivers a minute, or 0    */
+  char    LoadProbe[257];     /* LOADPROBE command, or "" for *NONE      */
+  volatile sig_atomic_t *pStop;  /* Paced deletes stop waiting, and     */
+                              /* leave the rest, once this is set (0 -   */
+                              /* never)                                  */
+  int     MediaImages;        /* MEDIAIMG(*YES) - record the images that */
+                              /* hold the oldest receiver, and delete    */
+  int     MaxImages;          /* IMGMAX - images recorded at most        */
+  int     ImageWait;          /* IMGWAIT - seconds between images        */
+};
+
+/***************************************************************************/
+/*  Outcome of deleting one receiver                                       */
+/***************************************************************************/
+struct DeleteResult {
+  char      Name[10];         /* Receiver name                           */
+  char      ExceptionId[7];   /* Exception ID if the delete failed       */
+  long long Micros;           /* Time the delete took                    */
+};
+
+/***************************************************************************/
+/*  Results returned for a queue manager context                           */
+/***************************************************************************/
+struct JrnMaintState {        /* JrnMaintLoad()                          */
+  int       Changed;          /* AMQJRNINF or the attached receiver has  */
+                              /* changed since the last load             */
+  JrnTime   Cutoff;           /* Oldest journal entry needed             */
+  char      AttRcv[10];       /* Attached receiver                       */
+  int       NumRcvrs;         /* Receivers in the chain                  */
+};
+
+struct JrnMaintCutoff {       /* JrnMaintCutoff()                        */
+  JrnTime   Cutoff;           /* Oldest journal entry needed ...         */
+  int       Oldest;           /* ... the receiver holding it, as an      */
+  char      OldestRcv[10];    /* index into the chain (-1 if none does)  */
+  int       Kept;             /* Receivers still needed                  */
+  int       Distance;         /* Receivers attached after the oldest one */
+  long long OldestAge;        /* Seconds since the oldest entry needed   */
+};
+
+struct JrnMaintReceiver {     /* A receiver in a JrnMaintPlan            */
+  char      Name[10];
+  JrnTime   AttachTime;
+  int       SizeK;            /* Size in K (0 if not reported)           */
+  char      Status;           /* Receiver status ('3' = saved)           */
+  char      Plan;             /* PLAN_                                   */
+};
+
+struct JrnMaintPlan {         /* JrnMaintPlan()                          */
+  int       NumRcvrs;         /* The chain, oldest receiver first -      */
+  struct JrnMaintReceiver *Rcvrs;  /* held by the context until the next */
+                              /* call                                    */
+  int       Eligible;         /* Receivers planned to be deleted         */
+  int       AgeHeld;          /* Receivers only kept by MINAGE           */
+};
+
+struct JrnMaintResult {       /* JrnMaintExecute()                       */
+  int       Retcode;          /* OK, or the first error                  */
+  int       Saved;            /* Receivers saved                         */
+  int       Deleted;          /* Receivers deleted                       */
+  int       Deferred;         /* Receivers the pacing left for the next  */
+                              /* call                                    */
+  int       NumDeletes;       /* Each delete attempted, with its outcome */
+  struct DeleteResult *Deletes;  /* - held by the context until the next */
+                              /* call                                    */
+};
+
+struct QmgrMaint;             /* A queue manager context                 */
+
+/***************************************************************************/
+/*  Settings                                                               */
+/***************************************************************************/
+
+/* Set up a JrnMaintConfig with the MQJRNMNT defaults                      */
+void JrnMaintInitConfig(struct JrnMaintConfig *pConfig);
+
+/* Add the PROTECT list parameter to the retention policy of pConfig       */
+int  ParseProtect(struct JrnMaintConfig *pConfig, char *Parm);
+
+/* Open (and lock) the ARCHIVE directory for pConfig, or close it          */
+int  OpenArchive(struct JrnMaintConfig *pConfig, char *Dir);
+void CloseArchive(struct JrnMaintConfig *pConfig);
+
+/* Start writing a TRACE file for pConfig, or close it                     */
+int  OpenTrace(struct JrnMaintConfig *pConfig, char *FileName);
+void CloseTrace(struct JrnMaintConfig *pConfig);
+
+/***************************************************************************/
+/*  A queue manager context - a receiver chain kept up to date in memory   */
+/***************************************************************************/
+
+/* Create a context for queue manager library QmgrLib, 0 if there isn't    */
+/* the memory                                                              */
+struct QmgrMaint *JrnMaintCreate(struct JrnMaintConfig *pConfig,
+                                 char *QmgrLib);
+void JrnMaintDestroy(struct QmgrMaint *pQm);
+
+/* Read AMQJRNINF and the attached receiver, retrieving the receivers      */
+/* attached since the last load                                            */
+int  JrnMaintLoad(struct QmgrMaint *pQm, struct JrnMaintState *pState);
+
+/* Find the oldest receiver needed in the chain as last loaded             */
+int  JrnMaintCutoff(struct QmgrMaint *pQm, struct JrnMaintCutoff *pCutoff);
+
+/* Apply the retention policy to the receivers older than that             */
+int  JrnMaintPlan(struct QmgrMaint *pQm, struct JrnMaintPlan *pPlan);
+
+/* Save and/or delete the receivers planned to be deleted, as the          */
+/* settings say, and drop the deleted ones from the chain                  */
+int  JrnMaintExecute(struct QmgrMaint *pQm, struct JrnMaintResult *pResult);
+
+/* Text of the last error reported for the context, "" if none             */
+char *JrnMaintLastError(struct QmgrMaint *pQm);
+
+/***************************************************************************/
+/*  MQJRNMNT processing of a list of queue managers                        */
+/***************************************************************************/
+
+/* Read the local time once, for the timestamps on the output              */
+void InitLogClock(void);
+
+/* Print a line with a timestamp, or send it to the queue manager's        */
+/* message queue as pQm's settings say (pQm 0 - always print it)           */
+void output(struct QmgrMaint *pQm, char *print_buffer);
+
+/* The queue managers named on QMGRLIB (or *ALL of them), as an array of  */
+/* contexts to be freed with FreeQmgrs()                                   */
+int  GetQmgrLibraries(struct JrnMaintConfig *pConfig, char *Parm,
+                      struct QmgrMaint **ppQmgrs, int *pNumQmgrs);
+void FreeQmgrs(struct QmgrMaint *pQmgrs, int NumQmgrs);
+
+/* MODE(*ONCE) - process the queue managers, up to NumThreads at a time.  */
+/* StartMicros is when the program started and StartupMicros the time    */
+/* it took to get this far, for the METRICS file                           */
+int  RunOnce(struct JrnMaintConfig *pConfig, struct QmgrMaint *pQmgrs,
+             int NumQmgrs, int NumThreads, long long StartMicros,
+             long long StartupMicros);
+
+/* MODE(*RESIDENT) - check the queue managers every Interval seconds      */
+/* until *pEnding is set                                                   */
+int  RunResident(struct JrnMaintConfig *pConfig, struct QmgrMaint *pQmgrs,
+                 int NumQmgrs, int Interval, long long StartupMicros,
+                 volatile sig_atomic_t *pEnding);
+
+/* MODE(*HISTORY) - summarise the last WindowHours of their HISTORY files  */
+int  RunQuery(struct QmgrMaint *pQmgrs, int NumQmgrs, int WindowHours);
+
+/* MODE(*RESTORE) - write receiver RcvName back out of the ARCHIVE         */
+int  RunRestore(struct QmgrMaint *pQmgrs, int NumQmgrs, char *RcvName);
+
+/* MODE(*REPLAY) - replay a TRACE file, reporting as pConfig says          */
+int  ReplayTrace(struct JrnMaintConfig *pConfig, char *FileName);
+
+/* Delete Journal Receiver exit program (format DRCV0100)                  */
+void JournalExit(char *ExitInfo, char *pReturnCode);
+
+#endif /* JRNMAINT_H */
@@ -0,0 +1,677 @@
+/***************************************************************************/
+/*                                                                         */
+/*  Module name:    JRNOS400                                               */
+/*  Function:       IBM i implementation of the JRNMAINT platform          */
+/*                  interface (see jrnplat.h)                              */
+/*                                                                         */
+/* Copyright (c) 2003,2024 IBM Corp.                                       */
+/*                                                                         */
+/* Licensed under the Apache License, Version 2.0 (the "License");         */
+/* you may not use this file except in compliance with the License.        */
+/* You may obtain a copy of the License at                                 */
+/*                                                                         */
+/*    http://www.apache.org/licenses/LICENSE-2.0                           */
+/*                                                                         */
+/* Unless required by applicable law or agreed to in writing, software     */
+/* distributed under the License is distributed on an "AS IS" BASIS,       */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.*/
+/* See the License for the specific language governing permissions and     */
+/* limitations under the License.                                          */
+/*                                                                         */
+/***************************************************************************/
+#define _MULTI_THREADED
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <sys/time.h>
+#include <qjournal.h>
+#include <qusec.h>
+#include <qusrobjd.h>
+#include <qusptrus.h>
+#include <qmhsndm.h>
+#include <ledate.h>
+#include <qcapcmd.h>
+#include <qwcrssts.h>
+#include "jrnplat.h"
+
+/***************************************************************************/
+/*  Options for running commands through QCAPCMD - set up once and used    */
+/*  for every command the program runs                                     */
+/***************************************************************************/
+static Qca_PCMD_CPOP0100_t CmdOptions;
+static pthread_once_t CmdOptionsOnce = PTHREAD_ONCE_INIT;
+
+static void InitCmdOptions(void);
+static int  RunCommand(char *Command, Qus_EC_t *pErrorData);
+
+/***************************************************************************/
+/*  QjoRetrieveJournalEntries - selection keys used, the size of the       */
+/*  receiver variable (so memory is bounded however big the receivers     */
+/*  are) and the RJNE0100 layouts, which are all character fields         */
+/***************************************************************************/
+#define RTVE_KEY_RCVRNG    1
+#define RTVE_KEY_FROMENT   2
+#define RTVE_KEY_FROMTIME  3
+#define RTVE_KEY_TOTIME    5
+#define RTVE_KEY_NBRENT    6
+#define RTVE_KEY_JRNCDE    8
+#define RTVE_KEY_ENTTYP    9
+#define RTVE_BLOCK    1048576                   /* Receiver variable size  */
+#define RTVE_MAX_TYPES     8
+
+typedef struct RtvEntHdr {
+  _INT4   Bytes_Returned;
+  _INT4   Offset_First_Entry;
+  _INT4   Number_Entries;
+  char    Continuation_Handle;
+} RtvEntHdr_t;
+
+typedef struct RtvEntEntry {
+  _INT4   Dsp_To_Next_Entry;
+  _INT4   Dsp_To_Null_Ind;
+  _INT4   Dsp_To_Entry_Data;
+  _INT4   Pointer_Handle;
+  char    Sequence[20];
+  char    Journal_Code;
+  char    Entry_Type[2];
+  char    Time_Stamp[26];     /* YYYY-MM-DD-HH.MM.SS.mmmmmm              */
+  char    Job_Name[10];
+  char    User_Name[10];
+  char    Job_Number[6];
+  char    Program_Name[10];
+  char    Object[30];
+  char    Count_RRN[20];
+  char    Indicator_Flag;
+  char    Commit_Cycle_Id[20];
+} RtvEntEntry_t;
+
+static void AddSelKey(char *Sel, int *pLen, int Key, void *Data,
+                      int DataLen);
+
+/***************************************************************************/
+/*  The queue manager's object files - a directory for each type of        */
+/*  object under its directory in MQ_QMGRS_PATH, with the RCDMQMIMG        */
+/*  OBJTYPE that records them                                              */
+/***************************************************************************/
+#define MQ_QMGRS_PATH  "/QIBM/UserData/mqm/qmgrs"
+
+static struct {
+  char   *Dir;
+  char   *Type;
+} MQObjectDirs[] = {
+  { "queues",    "*Q"        },
+  { "namelist",  "*NMLIST"   },
+  { "procdef",   "*PRCDFN"   },
+  { "authinfo",  "*AUTHINFO" },
+  { "topic",     "*TOPIC"    },
+  { "qmanager",  "*MQM"      }
+};
+
+static void MQFileName(char *Name, char *File);
+static void FormatSelTime(char *Time, char *SelTime);
+
+/***************************************************************************/
+/* Function:  PlatGetListParm()                                            */
+/*                                                                         */
+/* Description: A list parameter is passed by the command as a 2 byte      */
+/*              count followed by the elements                             */
+/*                                                                         */
+/***************************************************************************/
+int PlatGetListParm(char *Parm, int MaxElements, int ElementLen,
+                    char *Elements)
+{
+  short count;
+
+  memcpy(&count, Parm, sizeof(count));
+  if (count > MaxElements) count = MaxElements;
+  if (count < 0) count = 0;
+  memcpy(Elements, Parm + sizeof(count), count * ElementLen);
+  return count;
+}
+
+/***************************************************************************/
+/* Function:  PlatGetInt2Parm()                                            */
+/***************************************************************************/
+int PlatGetInt2Parm(char *Parm)
+{
+  short value;
+
+  memcpy(&value, Parm, sizeof(value));
+  return value;
+}
+
+/***************************************************************************/
+/* Function:  PlatGetInt4Parm()                                            */
+/***************************************************************************/
+int PlatGetInt4Parm(char *Parm)
+{
+  _INT4 value;
+
+  memcpy(&value, Parm, sizeof(value));
+  return value;
+}
+
+/***************************************************************************/
+/* Function:  PlatCheckLibrary()                                           */
+/*                                                                         */
+/* Description: Retrieve the library's object description, rather than    */
+/*              starting a command processor to run CHKOBJ.  Compile with  */
+/*              DEFINE(JRN_CHKOBJ_SYSTEM) to run CHKOBJ as earlier         */
+/*              versions did, to compare the startup time.                 */
+/*                                                                         */
+/***************************************************************************/
+int PlatCheckLibrary(char *LibName)
+{
+#ifdef JRN_CHKOBJ_SYSTEM
+  char cmdbuffer[40];
+
+  sprintf(cmdbuffer, "CHKOBJ %10.10s *LIB", LibName );
+  return system(cmdbuffer);
+#else
+  Qus_OBJD0100_t Desc;
+  char     QualLibName[20];
+  Qus_EC_t ErrorData;
+
+  memcpy(QualLibName, LibName, 10);
+  memcpy(&(QualLibName[10]), "QSYS      ", 10);
+  ErrorData.Bytes_Provided = sizeof(ErrorData);
+  ErrorData.Bytes_Available = 0;
+  QUSROBJD(&Desc, sizeof(Desc), "OBJD0100", QualLibName, "*LIB      ",
+           &ErrorData);
+  return ErrorData.Bytes_Available ? 1 : 0;
+#endif
+}
+
+/***************************************************************************/
+/* Function:  PlatPointToUserSpace()                                       */
+/***************************************************************************/
+void PlatPointToUserSpace(char *QualSpcName, char **ppSpace,
+                          Qus_EC_t *pErrorData)
+{
+  QUSPTRUS( QualSpcName, ppSpace, pErrorData);
+}
+
+/***************************************************************************/
+/* Function:  PlatRetrieveJournalInfo()                                    */
+/***************************************************************************/
+void PlatRetrieveJournalInfo(char *Data, _INT4 *pDataLen, char *QualJrnName,
+                             char *KeyData, Qus_EC_t *pErrorData)
+{
+  QjoRetrieveJournalInformation(Data, pDataLen,
+                                QualJrnName, QJO_RTV_JRN_INFO_0100,
+                                KeyData, pErrorData);
+}
+
+/***************************************************************************/
+/* Function:  PlatSendMessage()                                            */
+/***************************************************************************/
+void PlatSendMessage(char *Text, int Length, char *QualMsgQ,
+                     Qus_EC_t *pErrorData)
+{
+  QMHSNDM( "       ",
+           "                    ",
+           Text,
+           Length,
+           "*INFO     ",
+           QualMsgQ,
+           1,
+           "                    ",
+           "    ",
+           pErrorData);
+}
+
+/***************************************************************************/
+/* Function:  PlatLocalTime()                                              */
+/***************************************************************************/
+void PlatLocalTime(char *LocalDateTime)
+{
+  _INT4     days;
+  _FLOAT8   secs;
+  _FEEDBACK fb;
+
+  CEELOCT(&days, &secs, LocalDateTime, &fb);
+}
+
+/***************************************************************************/
+/* Function:  PlatDeleteReceiver()                                         */
+/*                                                                         */
+/* Description: Run DLTJRNRCV in this job (see RunCommand)                 */
+/*                                                                         */
+/***************************************************************************/
+int PlatDeleteReceiver(char *szLibName, char *RcvName, Qus_EC_t *pErrorData)
+{
+  char cmdbuffer[200];
+
+  memset( cmdbuffer, 0, sizeof(cmdbuffer) );
+  sprintf( cmdbuffer, "DLTJRNRCV %s/%10.10s DLTOPT(*IGNINQMSG)",
+           szLibName, RcvName);
+
+  return RunCommand(cmdbuffer, pErrorData);
+}
+
+/***************************************************************************/
+/* Function:  PlatSaveReceiver()                                           */
+/*                                                                         */
+/* Description: Create the save file (it may be left from an earlier run,  */
+/*              so a failure is ignored) and save the receiver to it,      */
+/*              clearing anything already there                            */
+/*                                                                         */
+/***************************************************************************/
+int PlatSaveReceiver(char *szLibName, char *RcvName, char *SavLib,
+                     Qus_EC_t *pErrorData)
+{
+  char cmdbuffer[300];
+  Qus_EC_t  CrtErrorData;
+
+  memset( cmdbuffer, 0, sizeof(cmdbuffer) );
+  sprintf( cmdbuffer, "CRTSAVF FILE(%10.10s/%10.10s) "
+           "TEXT('Journal receiver saved by MQJRNMNT')", SavLib, RcvName);
+  CrtErrorData.Bytes_Provided = sizeof(CrtErrorData);
+  CrtErrorData.Bytes_Available = 0;
+  RunCommand(cmdbuffer, &CrtErrorData);
+
+  memset( cmdbuffer, 0, sizeof(cmdbuffer) );
+  sprintf( cmdbuffer, "SAVOBJ OBJ(%10.10s) LIB(%s) DEV(*SAVF) "
+           "OBJTYPE(*JRNRCV) SAVF(%10.10s/%10.10s) CLEAR(*ALL)",
+           RcvName, szLibName, SavLib, RcvName);
+
+  return RunCommand(cmdbuffer, pErrorData);
+}
+
+/***************************************************************************/
+/* Function:  PlatSaveFilePath()                                           */
+/*                                                                         */
+/* Description: A save file can be read through the QSYS.LIB file system   */
+/*              as a stream of bytes, without copying it to the IFS first  */
+/*                                                                         */
+/***************************************************************************/
+void PlatSaveFilePath(char *SavLib, char *RcvName, char *Path)
+{
+  int   libLen,
+  rcvLen;
+
+  for (libLen = 10; libLen > 0 && SavLib[libLen - 1] == ' '; libLen--);
+  for (rcvLen = 10; rcvLen > 0 && RcvName[rcvLen - 1] == ' '; rcvLen--);
+  sprintf(Path, "/QSYS.LIB/%.*s.LIB/%.*s.FILE", libLen, SavLib, rcvLen,
+          RcvName);
+}
+
+/***************************************************************************/
+/* Function:  PlatDeleteSaveFile()                                         */
+/***************************************************************************/
+int PlatDeleteSaveFile(char *SavLib, char *RcvName, Qus_EC_t *pErrorData)
+{
+  char cmdbuffer[100];
+
+  memset( cmdbuffer, 0, sizeof(cmdbuffer) );
+  sprintf( cmdbuffer, "DLTF FILE(%10.10s/%10.10s)", SavLib, RcvName);
+
+  return RunCommand(cmdbuffer, pErrorData);
+}
+
+/***************************************************************************/
+/* Function:  PlatChangeJournal()                                          */
+/***************************************************************************/
+int PlatChangeJournal(char *szLibName, Qus_EC_t *pErrorData)
+{
+  char cmdbuffer[100];
+
+  memset( cmdbuffer, 0, sizeof(cmdbuffer) );
+  sprintf( cmdbuffer, "CHGJRN JRN(%s/AMQAJRN) JRNRCV(*GEN)", szLibName);
+
+  return RunCommand(cmdbuffer, pErrorData);
+}
+
+/***************************************************************************/
+/* Function:  PlatFindMQObject()                                           */
+/*                                                                         */
+/* Description: Look for the journaled object's file in each type's        */
+/*              directory of the queue manager.  MQ names the files after  */
+/*              the objects, with '.' as '!' and '/' as '&', so the MQ     */
+/*              name is the file name turned back.  The IFS doesn't        */
+/*              match case, so the directory is read for the name as it    */
+/*              is stored.  An object whose file MQ had to give a made up  */
+/*              name, and any entry not for a file, isn't found.           */
+/*                                                                         */
+/***************************************************************************/
+int PlatFindMQObject(char *szLibName, char *QmgrName, char *Object,
+                     char *MQName, char *MQType)
+{
+  DIR  *dir;
+  struct dirent *pEnt;
+  char  QmgrDir[49],
+  Path[200];
+  int   type,
+  len,
+  count;
+
+  for (len = 10; len > 0 && Object[len - 1] == ' '; len--);
+  if (len == 0) return 1;
+
+  MQFileName(QmgrName, QmgrDir);
+  for (type = 0; type < sizeof(MQObjectDirs) / sizeof(MQObjectDirs[0]);
+       type++) {
+    sprintf(Path, "%s/%s/%s", MQ_QMGRS_PATH, QmgrDir,
+            MQObjectDirs[type].Dir);
+    dir = opendir(Path);
+    if (! dir) continue;
+    while ((pEnt = readdir(dir)) != 0) {
+      if (strlen(pEnt->d_name) != len) continue;
+      for (count = 0; count < len &&
+           toupper(pEnt->d_name[count]) == Object[count]; count++);
+      if (count < len) continue;
+
+      for (count = 0; count <= len; count++) {
+        MQName[count] = pEnt->d_name[count] == '!' ? '.' :
+                        pEnt->d_name[count] == '&' ? '/' :
+                        pEnt->d_name[count];
+      };
+      strcpy(MQType, MQObjectDirs[type].Type);
+      closedir(dir);
+      return 0;
+    };
+    closedir(dir);
+  };
+  return 1;
+}
+
+/***************************************************************************/
+/* Function:  MQFileName()                                                 */
+/*                                                                         */
+/* Description: The file name MQ gives an object (or queue manager)       */
+/*              called Name                                                */
+/*                                                                         */
+/***************************************************************************/
+static void MQFileName(char *Name, char *File)
+{
+  for ( ; *Name; Name++, File++) {
+    *File = *Name == '.' ? '!' : *Name == '/' ? '&' : *Name;
+  };
+  *File = '\0';
+}
+
+/***************************************************************************/
+/* Function:  PlatRecordImage()                                            */
+/*                                                                         */
+/* Description: Run RCDMQMIMG in this job (see RunCommand) for the one     */
+/*              object, or for them all.  The names are quoted, as MQ      */
+/*              names are case sensitive.                                  */
+/*                                                                         */
+/***************************************************************************/
+int PlatRecordImage(char *szLibName, char *QmgrName, char *ObjName,
+                    char *ObjType, Qus_EC_t *pErrorData)
+{
+  char cmdbuffer[200];
+
+  memset( cmdbuffer, 0, sizeof(cmdbuffer) );
+  if (! strcmp(ObjName, "*ALL")) {
+    sprintf( cmdbuffer, "RCDMQMIMG OBJ(*ALL) OBJTYPE(*ALL) MQMNAME('%s') "
+             "DSPJRNDTA(*NO)", QmgrName);
+  }
+  else {
+    sprintf( cmdbuffer, "RCDMQMIMG OBJ('%s') OBJTYPE(%s) MQMNAME('%s') "
+             "DSPJRNDTA(*NO)", ObjName, ObjType, QmgrName);
+  };
+
+  return RunCommand(cmdbuffer, pErrorData);
+}
+
+/***************************************************************************/
+/* Function:  PlatRunProbe()                                               */
+/*                                                                         */
+/* Description: Run the LOADPROBE command in this job (see RunCommand) -   */
+/*              it ends with an escape message when the system is busy     */
+/*                                                                         */
+/***************************************************************************/
+int PlatRunProbe(char *Command, Qus_EC_t *pErrorData)
+{
+  return RunCommand(Command, pErrorData);
+}
+
+/***************************************************************************/
+/* Function:  PlatGetAspUsage()                                            */
+/*                                                                         */
+/* Description: Retrieve System Status without resetting the statistics    */
+/*                                                                         */
+/***************************************************************************/
+int PlatGetAspUsage(long long *pCapacityMB, int *pPercentUsed,
+                    Qus_EC_t *pErrorData)
+{
+  Qwc_SSTS0200_t Status;
+
+  QWCRSSTS(&Status, sizeof(Status), "SSTS0200", "*NO       ", pErrorData);
+  if (pErrorData->Bytes_Available) return 1;
+
+  *pCapacityMB = Status.System_ASP;
+  *pPercentUsed = Status.Percent_System_ASP_used;
+  return 0;
+}
+
+/***************************************************************************/
+/* Function:  PlatRetrieveEntries()                                        */
+/*                                                                         */
+/* Description: One call to QjoRetrieveJournalEntries.  The selection is   */
+/*              done by the API, so only the entries asked for are moved   */
+/*              into the (fixed size) receiver variable.                   */
+/*                                                                         */
+/***************************************************************************/
+int PlatRetrieveEntries(char *szLibName, char *RcvName, char *FromTime,
+                        char *ToTime, char Code, char *Types, int NumTypes,
+                        long long *pSequence, struct PlatJrnEntry *pEntries,
+                        int MaxEntries, int *pNumEntries, int *pMore,
+                        Qus_EC_t *pErrorData)
+{
+  char  QualJrnName[20],
+  Lib[10],
+  Sel[400],
+  Data[20 + 10 * RTVE_MAX_TYPES],
+  Number[21],
+  *pBlock;
+  int   SelLen = sizeof(_INT4),
+  NumKeys = 0,
+  count;
+  _INT4 BlockLen = RTVE_BLOCK,
+  Value;
+  RtvEntHdr_t   *pHdr;
+  RtvEntEntry_t *pEnt;
+
+  *pNumEntries = 0;
+  *pMore = 0;
+  memset(Lib, ' ', 10);
+  memcpy(Lib, szLibName, strlen(szLibName) < 10 ? strlen(szLibName) : 10);
+  memcpy(QualJrnName, "AMQAJRN   ", 10);
+  memcpy(&(QualJrnName[10]), Lib, 10);
+
+  memcpy(Data, RcvName, 10);                        /* Just this receiver  */
+  memcpy(Data + 10, Lib, 10);
+  memcpy(Data + 20, RcvName, 10);
+  memcpy(Data + 30, Lib, 10);
+  AddSelKey(Sel, &SelLen, RTVE_KEY_RCVRNG, Data, 40);
+  NumKeys++;
+
+  if (*pSequence == 0 && FromTime[0] != ' ') {
+    FormatSelTime(FromTime, Data);
+    AddSelKey(Sel, &SelLen, RTVE_KEY_FROMTIME, Data, 26);
+  }
+  else {
+    sprintf(Number, "%-20lld", *pSequence + 1);
+    AddSelKey(Sel, &SelLen, RTVE_KEY_FROMENT, Number, 20);
+  };
+  NumKeys++;
+
+  if (ToTime[0] != ' ') {
+    FormatSelTime(ToTime, Data);
+    AddSelKey(Sel, &SelLen, RTVE_KEY_TOTIME, Data, 26);
+    NumKeys++;
+  };
+
+  Value = MaxEntries;
+  AddSelKey(Sel, &SelLen, RTVE_KEY_NBRENT, &Value, sizeof(Value));
+  NumKeys++;
+
+  if (Code != ' ') {
+    Value = 1;
+    memcpy(Data, &Value, sizeof(Value));
+    memset(Data + 4, ' ', 20);
+    Data[4] = Code;
+    memcpy(Data + 14, "*ALLSLT", 7);
+    AddSelKey(Sel, &SelLen, RTVE_KEY_JRNCDE, Data, 24);
+    NumKeys++;
+
+    if (NumTypes > RTVE_MAX_TYPES) NumTypes = RTVE_MAX_TYPES;
+    if (NumTypes > 0) {
+      Value = NumTypes;
+      memcpy(Data, &Value, sizeof(Value));
+      memset(Data + 4, ' ', 10 * NumTypes);
+      for (count = 0; count < NumTypes; count++) {
+        memcpy(Data + 4 + 10 * count, Types + 2 * count, 2);
+      };
+      AddSelKey(Sel, &SelLen, RTVE_KEY_ENTTYP, Data, 4 + 10 * NumTypes);
+      NumKeys++;
+    };
+  };
+  memcpy(Sel, &NumKeys, sizeof(_INT4));
+
+  pBlock = (char*)malloc(RTVE_BLOCK);
+  if (! pBlock) {
+    memcpy(pErrorData->Exception_Id, "CPF1001", 7);     /* Sort of         */
+    pErrorData->Bytes_Available = sizeof(Qus_EC_t);
+    return 1;
+  };
+
+  QjoRetrieveJournalEntries(pBlock, &BlockLen, QualJrnName, "RJNE0100",
+                            Sel, pErrorData);
+  if (pErrorData->Bytes_Available) {
+    free(pBlock);
+    /* No entries selected is the end, not an error                        */
+    return memcmp(pErrorData->Exception_Id, "CPF7062", 7) ? 1 : 0;
+  };
+
+  pHdr = (RtvEntHdr_t*)pBlock;
+  pEnt = (RtvEntEntry_t*)(pBlock + pHdr->Offset_First_Entry);
+  for (count = 0; count < pHdr->Number_Entries && count < MaxEntries;
+       count++) {
+    memcpy(Number, pEnt->Sequence, 20);
+    Number[20] = '\0';
+    pEntries[count].Sequence = atoll(Number);
+    memcpy(Number, pEnt->Commit_Cycle_Id, 20);
+    pEntries[count].CommitCycle = atoll(Number);
+    pEntries[count].Code = pEnt->Journal_Code;
+    memcpy(pEntries[count].Type, pEnt->Entry_Type, 2);
+    memcpy(pEntries[count].Time, pEnt->Time_Stamp, 4);          /* YYYY    */
+    memcpy(pEntries[count].Time + 4, pEnt->Time_Stamp + 5, 2);  /* MM      */
+    memcpy(pEntries[count].Time + 6, pEnt->Time_Stamp + 8, 2);  /* DD      */
+    memcpy(pEntries[count].Time + 8, pEnt->Time_Stamp + 11, 2); /* HH      */
+    memcpy(pEntries[count].Time + 10, pEnt->Time_Stamp + 14, 2);/* MI      */
+    memcpy(pEntries[count].Time + 12, pEnt->Time_Stamp + 17, 2);/* SS      */
+    memcpy(pEntries[count].Time + 14, pEnt->Time_Stamp + 20, 3);/* 999     */
+    memcpy(pEntries[count].Job, pEnt->Job_Name, 26);
+    memcpy(pEntries[count].Program, pEnt->Program_Name, 10);
+    memcpy(pEntries[count].Object, pEnt->Object, 30);
+    *pSequence = pEntries[count].Sequence;
+    pEnt = (RtvEntEntry_t*)((char*)pEnt + pEnt->Dsp_To_Next_Entry);
+  };
+  *pNumEntries = count;
+  *pMore = pHdr->Continuation_Handle == '1';
+
+  free(pBlock);
+  return 0;
+}
+
+/***************************************************************************/
+/* Function:  AddSelKey()                                                  */
+/*                                                                         */
+/* Description: Add a variable length key record to the journal entry     */
+/*              selection - its length, the key, the length of the data    */
+/*              and the data, padded to a multiple of 4 bytes              */
+/*                                                                         */
+/***************************************************************************/
+static void AddSelKey(char *Sel, int *pLen, int Key, void *Data,
+                      int DataLen)
+{
+  _INT4 Record[3];
+
+  Record[0] = (sizeof(Record) + DataLen + 3) & ~3;
+  Record[1] = Key;
+  Record[2] = DataLen;
+  memset(Sel + *pLen, 0, Record[0]);
+  memcpy(Sel + *pLen, Record, sizeof(Record));
+  memcpy(Sel + *pLen + sizeof(Record), Data, DataLen);
+  *pLen += Record[0];
+}
+
+/***************************************************************************/
+/* Function:  FormatSelTime()                                              */
+/*                                                                         */
+/* Description: YYYYMMDDHHMISS999 as the API's YYYY-MM-DD-HH.MM.SS.mmmmmm */
+/*                                                                         */
+/***************************************************************************/
+static void FormatSelTime(char *Time, char *SelTime)
+{
+  sprintf(SelTime, "%4.4s-%2.2s-%2.2s-%2.2s.%2.2s.%2.2s.%3.3s000",
+          Time, Time + 4, Time + 6, Time + 8, Time + 10, Time + 12,
+          Time + 14);
+}
+
+/***************************************************************************/
+/* Function:  RunCommand()                                                 */
+/*                                                                         */
+/* Description: Run a command in this job through QCAPCMD, so the command  */
+/*              processor isn't started for each one and the exception ID  */
+/*              comes back in the error code structure.  Compile with      */
+/*              DEFINE(JRN_DLT_SYSTEM) to use system() as earlier versions */
+/*              did, for comparison.                                       */
+/*                                                                         */
+/***************************************************************************/
+static int RunCommand(char *Command, Qus_EC_t *pErrorData)
+{
+  char ChangedCmd[1];
+  int  ChangedLen = 0,
+  retcode;
+
+#ifdef JRN_DLT_SYSTEM
+  retcode = system(Command);
+  if (retcode && pErrorData->Bytes_Provided >= sizeof(Qus_EC_t)) {
+    pErrorData->Bytes_Available = sizeof(Qus_EC_t);
+    memcpy(pErrorData->Exception_Id, _EXCP_MSGID, 7);
+  };
+#else
+  pthread_once(&CmdOptionsOnce, InitCmdOptions);
+  QCAPCMD(Command, strlen(Command), &CmdOptions, sizeof(CmdOptions),
+          "CPOP0100", ChangedCmd, 0, &ChangedLen, pErrorData);
+  retcode = pErrorData->Bytes_Available ? 1 : 0;
+#endif
+
+  return retcode;
+}
+
+/***************************************************************************/
+/* Function:  InitCmdOptions()                                             */
+/*                                                                         */
+/* Description: Options control block - run the command, system syntax,   */
+/*              no prompting                                               */
+/*                                                                         */
+/***************************************************************************/
+static void InitCmdOptions(void)
+{
+  memset(&CmdOptions, 0, sizeof(CmdOptions));
+  CmdOptions.Command_Process_Type = 0;
+  CmdOptions.DBCS_Data_Handling = '0';
+  CmdOptions.Prompter_Action = '0';
+  CmdOptions.Command_String_Syntax = '0';
+  memset(CmdOptions.Message_Key, ' ', sizeof(CmdOptions.Message_Key));
+}
+
+/***************************************************************************/
+/* Function:  PlatMicroseconds()                                           */
+/***************************************************************************/
+long long PlatMicroseconds(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return (long long)tv.tv_sec * 1000000 + tv.tv_usec;
+}
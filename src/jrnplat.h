@@ -0,0 +1,207 @@
+/***************************************************************************/
+/*                                                                         */
+/*  Header name:    JRNPLAT                                                */
+/*  Function:       Platform interface used by the JRNMAINT program        */
+/*                                                                         */
+/*  Every IBM i system API and command used by jrnlib.c is called         */
+/*  through the functions declared here.  jrnos400.c implements them with  */
+/*  the real APIs; jrnsim.c implements them with an in-memory simulation   */
+/*  so the maintenance logic can be built and run on other platforms.      */
+/*                                                                         */
+/* Copyright (c) 2003,2024 IBM Corp.                                       */
+/*                                                                         */
+/* Licensed under the Apache License, Version 2.0 (the "License");         */
+/* you may not use this file except in compliance with the License.        */
+/* You may obtain a copy of the License at                                 */
+/*                                                                         */
+/*    http://www.apache.org/licenses/LICENSE-2.0                           */
+/*                                                                         */
+/* Unless required by applicable law or agreed to in writing, software     */
+/* distributed under the License is distributed on an "AS IS" BASIS,       */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.*/
+/* See the License for the specific language governing permissions and     */
+/* limitations under the License.                                          */
+/*                                                                         */
+/***************************************************************************/
+#ifndef JRNPLAT_H
+#define JRNPLAT_H
+
+#ifdef __OS400__
+#include <qjournal.h>
+#include <qusec.h>
+#else
+
+/***************************************************************************/
+/*  Host definitions of the IBM i types used by jrnlib.c.  Only the       */
+/*  fields the program uses are named; the receiver directory entry keeps  */
+/*  the 128 byte layout documented for QjoRetrieveJournalInformation.      */
+/***************************************************************************/
+typedef int _INT4;
+
+typedef struct Qus_EC {
+  _INT4   Bytes_Provided;
+  _INT4   Bytes_Available;
+  char    Exception_Id[7];
+  char    Reserved;
+} Qus_EC_t;
+
+typedef struct Qjo_RJRN0100 {
+  _INT4   Bytes_Returned;
+  _INT4   Bytes_Available;
+  _INT4   Offset_Key_Info;
+  char    Jrn_Name[10];
+  char    Jrn_Lib_Name[10];
+  char    Reserved1[40];
+  char    Att_Jrn_Rcv_Name[10];
+  char    Att_Jrn_Rcv_Lib_Name[10];
+  char    Reserved2[80];
+} Qjo_RJRN0100_t;
+
+typedef struct Qjo_JN_Repeating_Key_Fields {
+  _INT4   Key;
+  _INT4   Off_Strt_Key_Info;
+  _INT4   Len_Key_Info_Sect;
+  _INT4   Number_Entries;
+  _INT4   Len_Entry;
+} Qjo_JN_Repeating_Key_Fields_t;
+
+typedef struct Qjo_JN_Key_1_Output_Section {
+  _INT4   Tot_Num_Jrn_Rcv;
+  _INT4   Tot_Size_Jrn_Rcv;
+  _INT4   Tot_Size_Mult;
+  char    Reserved[8];
+} Qjo_JN_Key_1_Output_Section_t;
+
+typedef struct Qjo_JN_Repeating_Key_1_Output {
+  char    Jrn_Rcv_Name[10];
+  char    Jrn_Rcv_Lib_Name[10];
+  char    Jrn_Rcv_Num[5];
+  char    Jrn_Rcv_Att_Date_Time[13];
+  char    Jrn_Rcv_Status;
+  char    Jrn_Rcv_Save_Date_Time[13];
+  char    Local_Jrn_Sys[8];
+  char    Source_Jrn_Sys[8];
+  _INT4   Jrn_Rcv_Size;
+  char    Reserved[56];
+} Qjo_JN_Repeating_Key_1_Output_t;
+
+#define QJO_RTV_JRN_INFO_0100 "RJRN0100"
+
+#endif /* __OS400__ */
+
+/***************************************************************************/
+/*  Platform interface                                                     */
+/***************************************************************************/
+
+/* Copy the elements of a command list parameter into Elements, blank     */
+/* padded to ElementLen each, returning how many there were                */
+int  PlatGetListParm(char *Parm, int MaxElements, int ElementLen,
+                     char *Elements);
+
+/* Value of a command *INT2 parameter                                      */
+int  PlatGetInt2Parm(char *Parm);
+
+/* Value of a command *INT4 parameter                                      */
+int  PlatGetInt4Parm(char *Parm);
+
+/* Return 0 if the (blank padded) library exists (QUSROBJD)               */
+int  PlatCheckLibrary(char *LibName);
+
+/* Set *ppSpace to point to the contents of a user space (QUSPTRUS)        */
+void PlatPointToUserSpace(char *QualSpcName, char **ppSpace,
+                          Qus_EC_t *pErrorData);
+
+/* Retrieve journal information, format RJRN0100                           */
+/* (QjoRetrieveJournalInformation)                                         */
+void PlatRetrieveJournalInfo(char *Data, _INT4 *pDataLen, char *QualJrnName,
+                             char *KeyData, Qus_EC_t *pErrorData);
+
+/* Send an informational message to a message queue (QMHSNDM)              */
+void PlatSendMessage(char *Text, int Length, char *QualMsgQ,
+                     Qus_EC_t *pErrorData);
+
+/* Local date & time as YYYYMMDDHHMISS999 (CEELOCT)                        */
+void PlatLocalTime(char *LocalDateTime);
+
+/* Delete a journal receiver (DLTJRNRCV); 0 if it was deleted, otherwise  */
+/* the exception ID is returned in the error code structure                */
+int  PlatDeleteReceiver(char *szLibName, char *RcvName,
+                        Qus_EC_t *pErrorData);
+
+/* Save a journal receiver to save file SavLib/RcvName, creating the     */
+/* save file if need be (CRTSAVF, SAVOBJ); 0 if it was saved, otherwise   */
+/* the exception ID is returned in the error code structure                */
+int  PlatSaveReceiver(char *szLibName, char *RcvName, char *SavLib,
+                      Qus_EC_t *pErrorData);
+
+/* Path by which the save file SavLib/RcvName can be read as a stream     */
+/* file (/QSYS.LIB/SAVLIB.LIB/RCVNAME.FILE)                                */
+void PlatSaveFilePath(char *SavLib, char *RcvName, char *Path);
+
+/* Delete save file SavLib/RcvName (DLTF); 0 if it was deleted, otherwise */
+/* the exception ID is returned in the error code structure                */
+int  PlatDeleteSaveFile(char *SavLib, char *RcvName, Qus_EC_t *pErrorData);
+
+/* Attach a new receiver to AMQAJRN (CHGJRN JRNRCV(*GEN)); 0 if it was   */
+/* changed, otherwise the exception ID is returned in the error code      */
+/* structure                                                               */
+int  PlatChangeJournal(char *szLibName, Qus_EC_t *pErrorData);
+
+/* The MQ object of queue manager QmgrName (in library szLibName) that    */
+/* the journaled object Object - RJNE0100 name, library and member - is    */
+/* the file of: its name (up to 48 characters) in MQName and its          */
+/* RCDMQMIMG OBJTYPE in MQType; 0 if it was found                          */
+int  PlatFindMQObject(char *szLibName, char *QmgrName, char *Object,
+                      char *MQName, char *MQType);
+
+/* Record a media image of object ObjName, of type ObjType, of queue       */
+/* manager QmgrName in library szLibName (RCDMQMIMG) - ObjName *ALL        */
+/* records every object; 0 if it was recorded, otherwise the exception ID  */
+/* is returned in the error code structure                                 */
+int  PlatRecordImage(char *szLibName, char *QmgrName, char *ObjName,
+                     char *ObjType, Qus_EC_t *pErrorData);
+
+/* Run the LOADPROBE command; 0 if it completed (the system is not busy),  */
+/* otherwise the exception ID it ended with is returned in the error code  */
+/* structure                                                               */
+int  PlatRunProbe(char *Command, Qus_EC_t *pErrorData);
+
+/* Size of the system ASP in MB, and the percentage of it used in          */
+/* ten-thousandths of a percent (QWCRSSTS, format SSTS0200); 0 if they    */
+/* were retrieved                                                          */
+int  PlatGetAspUsage(long long *pCapacityMB, int *pPercentUsed,
+                     Qus_EC_t *pErrorData);
+
+/* A journal entry, as returned by PlatRetrieveEntries                     */
+struct PlatJrnEntry {
+  long long Sequence;         /* Sequence number                         */
+  long long CommitCycle;      /* Commit cycle ID (0 - not under commit)  */
+  char      Code;             /* Journal code                            */
+  char      Type[2];          /* Entry type                              */
+  char      Time[17];         /* Local time, YYYYMMDDHHMISS999           */
+  char      Job[26];          /* Job name, user and number               */
+  char      Program[10];      /* Program that wrote the entry            */
+  char      Object[30];       /* Object name, library and member         */
+};
+
+/* Retrieve up to MaxEntries entries of AMQAJRN from receiver RcvName, in  */
+/* sequence order (QjoRetrieveJournalEntries, format RJNE0100).  Entries   */
+/* after *pSequence are returned - from FromTime when *pSequence is 0 and  */
+/* FromTime isn't blank - up to ToTime (blank for the end of the           */
+/* receiver).  Code selects one journal code (' ' for all) and Types the  */
+/* NumTypes 2 character entry types within it.  *pSequence is set to the  */
+/* last entry returned, *pNumEntries to the number returned, and *pMore   */
+/* to 0 once there are no more to retrieve (the continuation handle), so  */
+/* a further call isn't made from past the end of the receiver.           */
+/* 0 if the entries were retrieved, otherwise the exception ID is          */
+/* returned in the error code structure                                    */
+int  PlatRetrieveEntries(char *szLibName, char *RcvName, char *FromTime,
+                         char *ToTime, char Code, char *Types, int NumTypes,
+                         long long *pSequence, struct PlatJrnEntry *pEntries,
+                         int MaxEntries, int *pNumEntries, int *pMore,
+                         Qus_EC_t *pErrorData);
+
+/* Current time in microseconds, for timing                                */
+long long PlatMicroseconds(void);
+
+#endif /* JRNPLAT_H */
@@ -0,0 +1,1173 @@
+/***************************************************************************/
+/*                                                                         */
+/*  Module name:    JRNSIM                                                 */
+/*  Function:       Simulated implementation of the JRNMAINT platform      */
+/*                  interface (see jrnplat.h) for building and running     */
+/*                  the journal maintenance logic on other platforms       */
+/*                                                                         */
+/*  Each queue manager library gets an in-memory AMQAJRN receiver chain    */
+/*  and AMQJRNINF user space when it is first referenced.  The simulation  */
+/*  is controlled by environment variables:                                */
+/*                                                                         */
+/*    JRNSIM_RECEIVERS  - receivers in each chain              (dft 20)    */
+/*                        - named AMQA000001 to AMQA999999, then       */
+/*                        AMQ1000000 on                                    */
+/*    JRNSIM_KEEP       - receivers the queue manager still needs,         */
+/*                        including the attached one            (dft 3)    */
+/*    JRNSIM_INTERVAL   - seconds between receiver attaches    (dft 600)   */
+/*    JRNSIM_DELETE_MS  - time taken by each DLTJRNRCV         (dft 0)     */
+/*    JRNSIM_SAVE_MS    - time taken by each receiver save     (dft 0)     */
+/*    JRNSIM_ENTRY_MS   - milliseconds of the AMQJRNINF timestamp (dft 0)  */
+/*    JRNSIM_START      - seconds since the epoch (UTC) the first receiver */
+/*                        was attached              (dft 2024-01-01)       */
+/*    JRNSIM_RECENT     - if set, the attached receiver was attached a     */
+/*                        third of an interval ago, rather than the chain  */
+/*                        starting at JRNSIM_START                         */
+/*    JRNSIM_RCV_KB     - size of each detached receiver in K; the         */
+/*                        attached one is half that   (dft 0, not known)   */
+/*    JRNSIM_ASP_MB     - size of the system ASP in MB  (dft 1000000)      */
+/*    JRNSIM_ASP_USED   - percentage of the system ASP used (dft 50)       */
+/*    JRNSIM_SAVE_FAIL  - number of a receiver whose save fails (dft 0,    */
+/*                        none)                                            */
+/*    JRNSIM_DELETE_FAIL- number of a receiver whose delete fails (dft 0,  */
+/*                        none)                                            */
+/*    JRNSIM_SAVED      - number of the newest receiver already saved -    */
+/*                        it and every receiver before it are reported as  */
+/*                        saved                                (dft 0)     */
+/*    JRNSIM_ATTACH_SECS- real seconds between new receivers being         */
+/*                        attached while the program runs (dft 0, never)   */
+/*    JRNSIM_LIBS       - comma separated list of the libraries that       */
+/*                        exist (dft every library exists)                 */
+/*    JRNSIM_SPACE_JRN  - journal (LIB/NAME) AMQJRNINF says it describes,  */
+/*                        to test the check (dft the library's AMQAJRN)    */
+/*    JRNSIM_PIN_END    - number of the receiver in which the commit cycle */
+/*                        that started at the oldest entry needed ends     */
+/*                        (dft 0, it is still open)                        */
+/*    JRNSIM_RTVENT_MS  - time taken by each call to retrieve journal      */
+/*                        entries                              (dft 0)     */
+/*    JRNSIM_SAVF_DIR   - directory the save files are written to, as      */
+/*                        LIB.RCVNAME.savf                     (dft /tmp)  */
+/*    JRNSIM_BUSY       - seconds after the program started during which  */
+/*                        the system is busy, as FROM-TO: the LOADPROBE    */
+/*                        command fails with CPF9898 (dft never busy)      */
+/*    JRNSIM_BUSY_DELETE_MS - time taken by each DLTJRNRCV while the       */
+/*                        system is busy        (dft JRNSIM_DELETE_MS)     */
+/*    JRNSIM_MEDIA      - number of objects (SIMMEDIAnn, the files of     */
+/*                        queues JRNSIM.MEDIA.QUEUE.nn) whose last media   */
+/*                        images are spread across the older receivers,    */
+/*                        holding the oldest entry needed back until       */
+/*                        RCDMQMIMG records them again  (dft 0, max 32)    */
+/*    JRNSIM_MEDIA_NOMAP- number of the JRNSIM_MEDIA object whose queue    */
+/*                        isn't found from its file     (dft 0, none)      */
+/*    JRNSIM_IMAGE_MS   - time taken by each RCDMQMIMG          (dft 0)     */
+/*                                                                         */
+/*  A save file holds text standing in for the journal entries: each       */
+/*  receiver's repeats the second half of the one before, after a header   */
+/*  whose length varies, so the archive has something to deduplicate.     */
+/*                                                                         */
+/*  Each receiver holds a journal entry for every second it was attached.  */
+/*  A short commit cycle is started every ten seconds and committed two    */
+/*  seconds later, except at the oldest entry needed, where a channel      */
+/*  starts the commit cycle that is holding on to the journal.  An entry's */
+/*  object is given as RJNE0100 gives it - name, library and member, 10    */
+/*  characters each - in the queue manager library.                        */
+/*                                                                         */
+/*  Command parameters are passed as ordinary strings, with list elements  */
+/*  separated by commas.  The simulated objects are serialised by one      */
+/*  lock, except for the delete and save delays, so queue managers (and    */
+/*  the saves and deletes for one queue manager) can be processed          */
+/*  in parallel.  The simulated system's local time is UTC.                */
+/*                                                                         */
+/* Copyright (c) 2003,2024 IBM Corp.                                       */
+/*                                                                         */
+/* Licensed under the Apache License, Version 2.0 (the "License");         */
+/* you may not use this file except in compliance with the License.        */
+/* You may obtain a copy of the License at                                 */
+/*                                                                         */
+/*    http://www.apache.org/licenses/LICENSE-2.0                           */
+/*                                                                         */
+/* Unless required by applicable law or agreed to in writing, software     */
+/* distributed under the License is distributed on an "AS IS" BASIS,       */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.*/
+/* See the License for the specific language governing permissions and     */
+/* limitations under the License.                                          */
+/*                                                                         */
+/***************************************************************************/
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include "jrnplat.h"
+
+/***************************************************************************/
+/*  Constants used by this module                                          */
+/***************************************************************************/
+#define SIM_MAX_LIBS   256                  /* Queue manager libraries     */
+#define SIM_BASE_TIME  1704067200L          /* 2024-01-01 00:00:00 UTC     */
+#define SIM_PIN_CYCLE  42                   /* Commit cycle at the cutoff  */
+#define SIM_SAVF_KB    256                  /* Save file K, by default     */
+#define SIM_MAX_MEDIA  32                   /* JRNSIM_MEDIA objects        */
+#define SIM_MEDIA_OBJ  "SIMMEDIA%02d"       /* ... their object names      */
+#define SIM_MEDIA_Q    "JRNSIM.MEDIA.QUEUE.%02d"
+#define SIM_OBJ        "SIMQUEUE  "         /* Object of the other entries */
+#define SIM_PIN_OBJ    "SIMXMITQ  "         /* ... and of the channel's    */
+#define SIM_PIN_JOB    "AMQRMPPA  QMQM      123456"
+#define SIM_JOB        "AMQZLAA0  QMQM      000%03d"
+
+/***************************************************************************/
+/*  Simulated journal for one queue manager library                        */
+/***************************************************************************/
+struct SimJournal {
+  char    Lib[10];            /* Blank padded library name           */
+  int     Total;              /* Receivers ever attached (1..Total)  */
+  char   *State;              /* Per receiver SIM_ flags             */
+  char    Space[38];          /* AMQJRNINF contents                  */
+  time_t  Media[SIM_MAX_MEDIA + 1];  /* Each JRNSIM_MEDIA object's last  */
+                              /* media image - 0 once it is recorded    */
+};
+
+#define SIM_DELETED    1                    /* Receiver has been deleted   */
+#define SIM_SAVED      2                    /* Receiver has been saved     */
+
+static struct SimJournal SimJrn[SIM_MAX_LIBS];
+static int  SimNumJrn = 0;
+static int  SimConfigured = 0;
+static int  SimReceivers = 20;
+static int  SimKeep = 3;
+static int  SimInterval = 600;
+static int  SimDeleteMs = 0;
+static int  SimSaveMs = 0;
+static int  SimSaveFail = 0;
+static int  SimDeleteFail = 0;
+static int  SimSaved = 0;
+static int  SimEntryMs = 0;
+static int  SimRcvKB = 0;
+static int  SimAspMB = 1000000;
+static int  SimAspUsed = 50;
+static time_t SimBaseTime = SIM_BASE_TIME;
+static int  SimAttachSecs = 0;
+static time_t SimStart = 0;
+static char *SimLibs = 0;
+static char *SimSpaceJrn = 0;
+static int  SimPinEnd = 0;
+static int  SimRtvEntMs = 0;
+static char *SimSavfDir = "/tmp";
+static int  SimBusyFrom = -1;
+static int  SimBusyTo = -1;
+static int  SimBusyDeleteMs = -1;
+static int  SimMedia = 0;
+static int  SimMediaNoMap = 0;
+static int  SimImageMs = 0;
+static pthread_mutex_t SimLock = PTHREAD_MUTEX_INITIALIZER;
+
+/***************************************************************************/
+/* Function:  SimConfigure()                                               */
+/***************************************************************************/
+static void SimConfigure(void)
+{
+  char *p;
+
+  if (SimConfigured) return;
+  SimConfigured = 1;
+
+  if ((p = getenv("JRNSIM_RECEIVERS")) != 0) SimReceivers = atoi(p);
+  if ((p = getenv("JRNSIM_KEEP")) != 0)      SimKeep = atoi(p);
+  if ((p = getenv("JRNSIM_INTERVAL")) != 0)  SimInterval = atoi(p);
+  if ((p = getenv("JRNSIM_DELETE_MS")) != 0) SimDeleteMs = atoi(p);
+  if ((p = getenv("JRNSIM_SAVE_MS")) != 0) SimSaveMs = atoi(p);
+  if ((p = getenv("JRNSIM_SAVE_FAIL")) != 0) SimSaveFail = atoi(p);
+  if ((p = getenv("JRNSIM_DELETE_FAIL")) != 0) SimDeleteFail = atoi(p);
+  if ((p = getenv("JRNSIM_SAVED")) != 0) SimSaved = atoi(p);
+  if ((p = getenv("JRNSIM_ENTRY_MS")) != 0) SimEntryMs = atoi(p) % 1000;
+  if ((p = getenv("JRNSIM_RCV_KB")) != 0) SimRcvKB = atoi(p);
+  if ((p = getenv("JRNSIM_ASP_MB")) != 0) SimAspMB = atoi(p);
+  if ((p = getenv("JRNSIM_ASP_USED")) != 0) SimAspUsed = atoi(p);
+  if ((p = getenv("JRNSIM_ATTACH_SECS")) != 0) SimAttachSecs = atoi(p);
+  if ((p = getenv("JRNSIM_START")) != 0) SimBaseTime = atol(p);
+  SimStart = time(0);
+  if (getenv("JRNSIM_RECENT")) {
+    SimBaseTime = SimStart - (time_t)(SimReceivers - 1) * SimInterval -
+                  SimInterval / 3;
+  };
+  SimLibs = getenv("JRNSIM_LIBS");
+  SimSpaceJrn = getenv("JRNSIM_SPACE_JRN");
+  if ((p = getenv("JRNSIM_PIN_END")) != 0) SimPinEnd = atoi(p);
+  if ((p = getenv("JRNSIM_RTVENT_MS")) != 0) SimRtvEntMs = atoi(p);
+  if ((p = getenv("JRNSIM_SAVF_DIR")) != 0) SimSavfDir = p;
+  if ((p = getenv("JRNSIM_BUSY")) != 0) {
+    SimBusyFrom = atoi(p);
+    SimBusyTo = strchr(p, '-') ? atoi(strchr(p, '-') + 1) : SimBusyFrom;
+  };
+  if ((p = getenv("JRNSIM_BUSY_DELETE_MS")) != 0) SimBusyDeleteMs = atoi(p);
+  if (SimBusyDeleteMs < 0) SimBusyDeleteMs = SimDeleteMs;
+  if ((p = getenv("JRNSIM_MEDIA")) != 0) SimMedia = atoi(p);
+  if ((p = getenv("JRNSIM_MEDIA_NOMAP")) != 0) SimMediaNoMap = atoi(p);
+  if ((p = getenv("JRNSIM_IMAGE_MS")) != 0) SimImageMs = atoi(p);
+
+  if (SimReceivers < 1) SimReceivers = 1;
+  if (SimKeep < 1) SimKeep = 1;
+  if (SimKeep > SimReceivers) SimKeep = SimReceivers;
+  if (SimInterval < 1) SimInterval = 1;
+  if (SimMedia < 0) SimMedia = 0;
+  if (SimMedia > SIM_MAX_MEDIA) SimMedia = SIM_MAX_MEDIA;
+}
+
+/***************************************************************************/
+/* Function:  SimSetError()                                                */
+/***************************************************************************/
+static void SimSetError(Qus_EC_t *pErrorData, char *ExceptionId)
+{
+  if (pErrorData->Bytes_Provided >= (int)sizeof(Qus_EC_t)) {
+    pErrorData->Bytes_Available = sizeof(Qus_EC_t);
+    memcpy(pErrorData->Exception_Id, ExceptionId, 7);
+  };
+}
+
+/***************************************************************************/
+/* Function:  SimIsBusy()                                                  */
+/*                                                                         */
+/* Description: Is it within the JRNSIM_BUSY seconds of the run?           */
+/*                                                                         */
+/***************************************************************************/
+static int SimIsBusy(void)
+{
+  int   Elapsed = (int)(time(0) - SimStart);
+
+  return Elapsed >= SimBusyFrom && Elapsed <= SimBusyTo;
+}
+
+/***************************************************************************/
+/* Function:  SimFindJournal()                                             */
+/*                                                                         */
+/* Description: Find (or create) the simulated journal for a library.      */
+/*              Returns 0 if the library does not exist.                   */
+/*                                                                         */
+/***************************************************************************/
+static struct SimJournal *SimAdvance(struct SimJournal *pJrn);
+static time_t SimOldestNeeded(struct SimJournal *pJrn, int *pMedia);
+static time_t SimAttachTime(int Number);
+static void SimReceiverName(int Number, char *Name);
+static struct SimJournal *SimFindReceiver(char *szLibName, char *RcvName,
+                                          int *pNumber);
+static int SimWriteSaveFile(char *SavLib, char *RcvName, int Number);
+
+static struct SimJournal *SimFindJournal(char *LibName)
+{
+  int   count,
+  len;
+  char  szLib[11],
+  *p;
+
+  SimConfigure();
+
+  for (count = 0; count < SimNumJrn; count++) {
+    if (! memcmp(SimJrn[count].Lib, LibName, 10))
+      return SimAdvance(&SimJrn[count]);
+  };
+
+  memcpy(szLib, LibName, 10);
+  szLib[10] = '\0';
+  if ((p = strchr(szLib, ' ')) != 0) *p = '\0';
+  len = strlen(szLib);
+
+  /*************************************************************************/
+  /* Only the libraries listed in JRNSIM_LIBS exist, if it is set          */
+  /*************************************************************************/
+  if (SimLibs) {
+    for (p = strstr(SimLibs, szLib); p; p = strstr(p + 1, szLib)) {
+      if ((p == SimLibs || p[-1] == ',') && (p[len] == ',' || !p[len]))
+        break;
+    };
+    if (!p || !len) return 0;
+  };
+
+  if (SimNumJrn == SIM_MAX_LIBS) return 0;
+
+  memcpy(SimJrn[SimNumJrn].Lib, LibName, 10);
+  SimJrn[SimNumJrn].Total = SimReceivers;
+  SimJrn[SimNumJrn].State = (char*)calloc(SimReceivers + 1, 1);
+  if (! SimJrn[SimNumJrn].State) return 0;
+  for (count = 1; count <= SimSaved && count < SimReceivers; count++) {
+    SimJrn[SimNumJrn].State[count] |= SIM_SAVED;
+  };
+  for (count = 1; count <= SimMedia; count++) {
+    SimJrn[SimNumJrn].Media[count] = SimInterval / 3 + 
+      SimAttachTime(1 + (count - 1) * (SimReceivers - SimKeep) / SimMedia);
+  };
+
+  return &SimJrn[SimNumJrn++];
+}
+
+/***************************************************************************/
+/* Function:  SimAdvance()                                                 */
+/*                                                                         */
+/* Description: Attach the receivers due since the program started, if     */
+/*              JRNSIM_ATTACH_SECS is set.  The oldest entry needed moves  */
+/*              on with the attached receiver.                             */
+/*                                                                         */
+/***************************************************************************/
+static struct SimJournal *SimAdvance(struct SimJournal *pJrn)
+{
+  int   Total;
+  char *pState;
+
+  if (SimAttachSecs <= 0) return pJrn;
+
+  Total = SimReceivers + (int)((time(0) - SimStart) / SimAttachSecs);
+  if (Total > pJrn->Total) {
+    pState = (char*)realloc(pJrn->State, Total + 1);
+    if (! pState) return pJrn;
+    memset(pState + pJrn->Total + 1, 0, Total - pJrn->Total);
+    pJrn->State = pState;
+    pJrn->Total = Total;
+  };
+  return pJrn;
+}
+
+/***************************************************************************/
+/* Function:  SimOldestNeeded()                                            */
+/*                                                                         */
+/* Description: The oldest entry the queue manager needs - half way        */
+/*              through the JRNSIM_KEEP'th newest receiver, or the last    */
+/*              media image of a JRNSIM_MEDIA object if that is older, in  */
+/*              which case *pMedia is set to the object's number           */
+/*                                                                         */
+/***************************************************************************/
+static time_t SimOldestNeeded(struct SimJournal *pJrn, int *pMedia)
+{
+  time_t Oldest;
+  int    count;
+
+  Oldest = SimAttachTime(pJrn->Total - SimKeep + 1) + SimInterval / 2;
+  *pMedia = 0;
+  for (count = 1; count <= SimMedia; count++) {
+    if (pJrn->Media[count] && pJrn->Media[count] < Oldest) {
+      Oldest = pJrn->Media[count];
+      *pMedia = count;
+    };
+  };
+  return Oldest;
+}
+
+/***************************************************************************/
+/* Function:  SimAttachTime()                                              */
+/*                                                                         */
+/* Description: Time (seconds since the epoch) receiver Number attached    */
+/*                                                                         */
+/***************************************************************************/
+static time_t SimAttachTime(int Number)
+{
+  return SimBaseTime + (time_t)(Number - 1) * SimInterval;
+}
+
+/***************************************************************************/
+/* Function:  SimReceiverName()                                            */
+/*                                                                         */
+/* Description: Name of receiver Number - AMQAnnnnnn, and AMQnnnnnnn once  */
+/*              the number needs seven digits, so every receiver of a      */
+/*              chain of up to 9,999,999 has its own name                  */
+/*                                                                         */
+/***************************************************************************/
+static void SimReceiverName(int Number, char *Name)
+{
+  char  work[24];
+
+  sprintf(work, Number > 999999 ? "AMQ%07d" : "AMQA%06d", Number);
+  memcpy(Name, work, 10);
+}
+
+/***************************************************************************/
+/* Function:  PlatGetListParm()                                            */
+/***************************************************************************/
+int PlatGetListParm(char *Parm, int MaxElements, int ElementLen,
+                    char *Elements)
+{
+  int   count = 0,
+  len;
+  char *p = Parm,
+  *pEnd;
+
+  while (*p && count < MaxElements) {
+    pEnd = strchr(p, ',');
+    len = pEnd ? pEnd - p : (int)strlen(p);
+    memset(Elements + count * ElementLen, ' ', ElementLen);
+    memcpy(Elements + count * ElementLen, p, len < ElementLen ? len : ElementLen);
+    count++;
+    if (! pEnd) break;
+    p = pEnd + 1;
+  };
+  return count;
+}
+
+/***************************************************************************/
+/* Function:  PlatGetInt2Parm()                                            */
+/***************************************************************************/
+int PlatGetInt2Parm(char *Parm)
+{
+  return atoi(Parm);
+}
+
+/***************************************************************************/
+/* Function:  PlatGetInt4Parm()                                            */
+/***************************************************************************/
+int PlatGetInt4Parm(char *Parm)
+{
+  return atoi(Parm);
+}
+
+/***************************************************************************/
+/* Function:  PlatCheckLibrary()                                           */
+/***************************************************************************/
+int PlatCheckLibrary(char *LibName)
+{
+  struct SimJournal *pJrn;
+
+  pthread_mutex_lock(&SimLock);
+  pJrn = SimFindJournal(LibName);
+  pthread_mutex_unlock(&SimLock);
+  return pJrn ? 0 : 1;
+}
+
+/***************************************************************************/
+/* Function:  SimPointToUserSpace()                                        */
+/*                                                                         */
+/* Description: Bring the journal's AMQJRNINF user space up to date and    */
+/*              point to it (see SimOldestNeeded)                          */
+/*                                                                         */
+/***************************************************************************/
+static void SimPointToUserSpace(char *QualSpcName, char **ppSpace,
+                                Qus_EC_t *pErrorData)
+{
+  struct SimJournal *pJrn;
+  time_t     Oldest;
+  struct tm  tm;
+  char      *p,
+  work[64];
+  int        Media;
+
+  pJrn = SimFindJournal(&(QualSpcName[10]));
+  if (! pJrn || memcmp(QualSpcName, "AMQJRNINF ", 10)) {
+    SimSetError(pErrorData, "CPF9801");
+    return;
+  };
+
+  Oldest = SimOldestNeeded(pJrn, &Media);
+  gmtime_r(&Oldest, &tm);
+
+  memcpy(pJrn->Space, "AMQAJRN   ", 10);
+  memcpy(&(pJrn->Space[10]), pJrn->Lib, 10);
+  if (SimSpaceJrn && (p = strchr(SimSpaceJrn, '/')) != 0) {
+    memset(pJrn->Space, ' ', 20);
+    memcpy(pJrn->Space, p + 1, strlen(p + 1) > 10 ? 10 : strlen(p + 1));
+    memcpy(&(pJrn->Space[10]), SimSpaceJrn, 
+           p - SimSpaceJrn > 10 ? 10 : p - SimSpaceJrn);
+  };
+  sprintf(work, "%04d%02d%02d%02d%02d%02d%03d",
+          tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+          tm.tm_hour, tm.tm_min, tm.tm_sec, SimEntryMs);
+  memcpy(&(pJrn->Space[20]), work, 17);
+
+  *ppSpace = pJrn->Space;
+}
+
+/***************************************************************************/
+/* Function:  SimRetrieveJournalInfo()                                     */
+/*                                                                         */
+/* Description: Return RJRN0100 with the key 1 receiver directory.  As     */
+/*              with the real API, only as much as fits in the receiver    */
+/*              variable is returned, and Bytes_Available reports the      */
+/*              size needed for all of it.                                 */
+/*                                                                         */
+/***************************************************************************/
+static void SimRetrieveJournalInfo(char *Data, _INT4 *pDataLen,
+                                   char *QualJrnName, char *KeyData,
+                                   Qus_EC_t *pErrorData)
+{
+  struct SimJournal *pJrn;
+  Qjo_RJRN0100_t    *pRtnJrnInf;
+  Qjo_JN_Repeating_Key_Fields_t   KeyFld1Hdr;
+  Qjo_JN_Key_1_Output_Section_t   KeyFld1OutputHdr;
+  Qjo_JN_Repeating_Key_1_Output_t Entry;
+  int        count,
+  numEntries = 0,
+  bytesAvail,
+  offset;
+  time_t     Attached;
+  struct tm  tm;
+  char       work[64];
+
+  pJrn = SimFindJournal(&(QualJrnName[10]));
+  if (! pJrn || memcmp(QualJrnName, "AMQAJRN   ", 10)) {
+    SimSetError(pErrorData, "CPF9801");
+    return;
+  };
+  if (*pDataLen < (int)sizeof(Qjo_RJRN0100_t)) {
+    SimSetError(pErrorData, "CPF3C24");
+    return;
+  };
+
+  for (count = 1; count <= pJrn->Total; count++) {
+    if (! (pJrn->State[count] & SIM_DELETED)) numEntries++;
+  };
+
+  bytesAvail = sizeof(Qjo_RJRN0100_t) +
+               sizeof(Qjo_JN_Repeating_Key_Fields_t) +
+               sizeof(Qjo_JN_Key_1_Output_Section_t) +
+               sizeof(Qjo_JN_Repeating_Key_1_Output_t) * numEntries;
+
+  /*************************************************************************/
+  /* Fixed header                                                          */
+  /*************************************************************************/
+  memset(Data, 0, sizeof(Qjo_RJRN0100_t));
+  pRtnJrnInf = (Qjo_RJRN0100_t*)Data;
+  pRtnJrnInf->Bytes_Available = bytesAvail;
+  pRtnJrnInf->Offset_Key_Info = sizeof(Qjo_RJRN0100_t);
+  memcpy(pRtnJrnInf->Jrn_Name, QualJrnName, 10);
+  memcpy(pRtnJrnInf->Jrn_Lib_Name, pJrn->Lib, 10);
+  SimReceiverName(pJrn->Total, pRtnJrnInf->Att_Jrn_Rcv_Name);
+  memcpy(pRtnJrnInf->Att_Jrn_Rcv_Lib_Name, pJrn->Lib, 10);
+  offset = sizeof(Qjo_RJRN0100_t);
+
+  /*************************************************************************/
+  /* With no keys requested only the fixed header is returned              */
+  /*************************************************************************/
+  memcpy(&count, KeyData, sizeof(count));
+  if (count == 0) {
+    pRtnJrnInf->Bytes_Available = offset;
+    pRtnJrnInf->Bytes_Returned = offset;
+    return;
+  };
+
+  /*************************************************************************/
+  /* Key 1 header and output section                                       */
+  /*************************************************************************/
+  memset(&KeyFld1Hdr, 0, sizeof(KeyFld1Hdr));
+  KeyFld1Hdr.Key = 1;
+  KeyFld1Hdr.Off_Strt_Key_Info = sizeof(KeyFld1Hdr);
+  KeyFld1Hdr.Number_Entries = numEntries;
+  KeyFld1Hdr.Len_Entry = sizeof(Entry);
+  memset(&KeyFld1OutputHdr, 0, sizeof(KeyFld1OutputHdr));
+  KeyFld1OutputHdr.Tot_Num_Jrn_Rcv = numEntries;
+  KeyFld1OutputHdr.Tot_Size_Jrn_Rcv = SimRcvKB * (numEntries - 1) + 
+                                      SimRcvKB / 2;
+  KeyFld1OutputHdr.Tot_Size_Mult = 1;
+
+  if (offset + (int)sizeof(KeyFld1Hdr) <= *pDataLen) {
+    memcpy(Data + offset, &KeyFld1Hdr, sizeof(KeyFld1Hdr));
+  };
+  offset += sizeof(KeyFld1Hdr);
+  if (offset + (int)sizeof(KeyFld1OutputHdr) <= *pDataLen) {
+    memcpy(Data + offset, &KeyFld1OutputHdr, sizeof(KeyFld1OutputHdr));
+  };
+  offset += sizeof(KeyFld1OutputHdr);
+
+  /*************************************************************************/
+  /* Receiver directory, oldest first, as far as it fits                   */
+  /*************************************************************************/
+  for (count = 1; count <= pJrn->Total; count++) {
+    if (pJrn->State[count] & SIM_DELETED) continue;
+    if (offset + (int)sizeof(Entry) > *pDataLen) break;
+
+    memset(&Entry, ' ', sizeof(Entry));
+    SimReceiverName(count, Entry.Jrn_Rcv_Name);
+    memcpy(Entry.Jrn_Rcv_Lib_Name, pJrn->Lib, 10);
+    sprintf(work, "%05d", count % 100000);
+    memcpy(Entry.Jrn_Rcv_Num, work, 5);
+
+    Attached = SimAttachTime(count);
+    gmtime_r(&Attached, &tm);
+    sprintf(work, "%1d%02d%02d%02d%02d%02d%02d",
+            (tm.tm_year / 100) % 10, tm.tm_year % 100, tm.tm_mon + 1,
+            tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+    memcpy(Entry.Jrn_Rcv_Att_Date_Time, work, 13);
+
+    Entry.Jrn_Rcv_Status = (count == pJrn->Total) ? '1' :
+                           (pJrn->State[count] & SIM_SAVED) ? '3' : '2';
+    Entry.Jrn_Rcv_Size = (count == pJrn->Total) ? SimRcvKB / 2 : SimRcvKB;
+
+    memcpy(Data + offset, &Entry, sizeof(Entry));
+    offset += sizeof(Entry);
+  };
+
+  pRtnJrnInf->Bytes_Returned = (offset < *pDataLen) ? offset : *pDataLen;
+}
+
+/***************************************************************************/
+/* Function:  PlatPointToUserSpace()                                       */
+/***************************************************************************/
+void PlatPointToUserSpace(char *QualSpcName, char **ppSpace,
+                          Qus_EC_t *pErrorData)
+{
+  pthread_mutex_lock(&SimLock);
+  SimPointToUserSpace(QualSpcName, ppSpace, pErrorData);
+  pthread_mutex_unlock(&SimLock);
+}
+
+/***************************************************************************/
+/* Function:  PlatRetrieveJournalInfo()                                    */
+/***************************************************************************/
+void PlatRetrieveJournalInfo(char *Data, _INT4 *pDataLen, char *QualJrnName,
+                             char *KeyData, Qus_EC_t *pErrorData)
+{
+  pthread_mutex_lock(&SimLock);
+  SimRetrieveJournalInfo(Data, pDataLen, QualJrnName, KeyData, pErrorData);
+  pthread_mutex_unlock(&SimLock);
+}
+
+/***************************************************************************/
+/* Function:  SimJournalEntry()                                            */
+/*                                                                         */
+/* Description: The journal entry with sequence number Sequence - two      */
+/*              numbers for each second since the chain started, the       */
+/*              second of them only used at the oldest entry needed and    */
+/*              where its commit cycle ends.  0 if there is no such entry. */
+/*              If JRNSIM_MEDIA object Media holds the oldest entry        */
+/*              needed, the entry is an update of that object outside any  */
+/*              commit cycle.  Objects are in library Lib.                 */
+/*                                                                         */
+/***************************************************************************/
+static int SimJournalEntry(char *Lib, time_t Oldest, int Media,
+                           long long Sequence, struct PlatJrnEntry *pEntry)
+{
+  time_t     Time;
+  long long  Second = (Sequence - 1) / 2;
+  int        Sub = (int)((Sequence - 1) % 2),
+  Millis = 0;
+  struct tm  tm;
+  char       work[64];
+
+  Time = SimBaseTime + (time_t)Second;
+
+  memset(pEntry, ' ', sizeof(struct PlatJrnEntry));
+  pEntry->Sequence = Sequence;
+  pEntry->CommitCycle = 0;
+  sprintf(work, SIM_JOB, (int)(Second % 1000));
+  memcpy(pEntry->Job, work, 26);
+  memcpy(pEntry->Program, "AMQZLAA0", 8);
+  memcpy(pEntry->Object, SIM_OBJ, 10);
+  memcpy(pEntry->Object + 10, Lib, 10);
+
+  if (Time == Oldest && Media > 0) {
+    if (Sub == 1) return 0;
+    Millis = SimEntryMs;
+    pEntry->Code = 'R';
+    memcpy(pEntry->Type, "UP", 2);
+    sprintf(work, SIM_MEDIA_OBJ, Media);
+    memcpy(pEntry->Object, work, strlen(work));
+  }
+  else if (Time == Oldest) {
+    Millis = SimEntryMs;
+    pEntry->CommitCycle = SIM_PIN_CYCLE;
+    memcpy(pEntry->Job, SIM_PIN_JOB, 26);
+    memcpy(pEntry->Program, "AMQRMPPA  ", 10);
+    if (Sub == 0) {
+      pEntry->Code = 'C';
+      memcpy(pEntry->Type, "SC", 2);
+    }
+    else {
+      pEntry->Code = 'R';
+      memcpy(pEntry->Type, "PT", 2);
+      memcpy(pEntry->Object, SIM_PIN_OBJ, 10);
+    };
+  }
+  else if (SimPinEnd > 0 && Time == SimAttachTime(SimPinEnd) + 1) {
+    if (Sub == 0) return 0;
+    pEntry->CommitCycle = SIM_PIN_CYCLE;
+    memcpy(pEntry->Job, SIM_PIN_JOB, 26);
+    memcpy(pEntry->Program, "AMQRMPPA  ", 10);
+    pEntry->Code = 'C';
+    memcpy(pEntry->Type, "CM", 2);
+  }
+  else {
+    if (Sub == 1) return 0;
+    switch (Second % 10) {
+    case 0:
+      pEntry->Code = 'C';
+      memcpy(pEntry->Type, "SC", 2);
+      pEntry->CommitCycle = 1000 + Second / 10;
+      break;
+    case 1:
+      pEntry->Code = 'R';
+      memcpy(pEntry->Type, "PT", 2);
+      pEntry->CommitCycle = 1000 + Second / 10;
+      break;
+    case 2:
+      pEntry->Code = 'C';
+      memcpy(pEntry->Type, "CM", 2);
+      pEntry->CommitCycle = 1000 + Second / 10;
+      break;
+    default:
+      pEntry->Code = 'R';
+      memcpy(pEntry->Type, "UP", 2);
+      break;
+    };
+  };
+
+  if (pEntry->Code == 'C') {
+    memset(pEntry->Object, ' ', 30);           /* Not for an object        */
+  };
+
+  gmtime_r(&Time, &tm);
+  sprintf(work, "%04d%02d%02d%02d%02d%02d%03d",
+          tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+          tm.tm_hour, tm.tm_min, tm.tm_sec, Millis);
+  memcpy(pEntry->Time, work, 17);
+  return 1;
+}
+
+/***************************************************************************/
+/* Function:  PlatRetrieveEntries()                                        */
+/*                                                                         */
+/* Description: Walk the receiver's seconds from where the last call left  */
+/*              off, applying the selection as the API would.  Each call   */
+/*              takes JRNSIM_RTVENT_MS, outside the lock.  Like the API, a */
+/*              call starting after the receiver's last entry is an error. */
+/*                                                                         */
+/***************************************************************************/
+int PlatRetrieveEntries(char *szLibName, char *RcvName, char *FromTime,
+                        char *ToTime, char Code, char *Types, int NumTypes,
+                        long long *pSequence, struct PlatJrnEntry *pEntries,
+                        int MaxEntries, int *pNumEntries, int *pMore,
+                        Qus_EC_t *pErrorData)
+{
+  struct SimJournal *pJrn;
+  struct PlatJrnEntry Entry;
+  int        Number,
+  Media,
+  count;
+  long long  Sequence,
+  Last;
+  time_t     End,
+  Oldest;
+
+  *pNumEntries = 0;
+  *pMore = 0;
+  pthread_mutex_lock(&SimLock);
+  pJrn = SimFindReceiver(szLibName, RcvName, &Number);
+  if (! pJrn) {
+    pthread_mutex_unlock(&SimLock);
+    SimSetError(pErrorData, "CPF7053");
+    return 1;
+  };
+
+  End = SimAttachTime(Number + 1);
+  if (Number == pJrn->Total && End > time(0)) End = time(0);
+  Oldest = SimOldestNeeded(pJrn, &Media);
+  pthread_mutex_unlock(&SimLock);
+
+  if (SimRtvEntMs > 0) {
+    usleep(SimRtvEntMs * 1000);
+  };
+
+  Sequence = (long long)(SimAttachTime(Number) - SimBaseTime) * 2 + 1;
+  Last = (long long)(End - SimBaseTime) * 2;
+  while (Last >= Sequence &&
+         ! SimJournalEntry(pJrn->Lib, Oldest, Media, Last, &Entry)) {
+    Last--;                                    /* Receiver's last entry    */
+  };
+  if (*pSequence >= Sequence) Sequence = *pSequence + 1;
+  if (*pSequence > 0 && Sequence > Last) {
+    SimSetError(pErrorData, "CPF7054");        /* FROMENT not in range    */
+    return 1;
+  };
+
+  for ( ; Sequence <= Last && *pNumEntries < MaxEntries; Sequence++) {
+    if (! SimJournalEntry(pJrn->Lib, Oldest, Media, Sequence, &Entry)) {
+      continue;
+    };
+    if (*pSequence == 0 && FromTime[0] != ' ' &&
+        memcmp(Entry.Time, FromTime, 17) < 0) continue;
+    if (ToTime[0] != ' ' && memcmp(Entry.Time, ToTime, 17) > 0) {
+      Last = 0;
+      break;
+    };
+    if (Code != ' ') {
+      if (Entry.Code != Code) continue;
+      for (count = 0; count < NumTypes; count++) {
+        if (! memcmp(Entry.Type, Types + 2 * count, 2)) break;
+      };
+      if (NumTypes > 0 && count == NumTypes) continue;
+    };
+    pEntries[(*pNumEntries)++] = Entry;
+  };
+  *pMore = Sequence <= Last;
+  if (*pNumEntries > 0) {
+    *pSequence = pEntries[*pNumEntries - 1].Sequence;
+  };
+  return 0;
+}
+
+/***************************************************************************/
+/* Function:  PlatSendMessage()                                            */
+/***************************************************************************/
+void PlatSendMessage(char *Text, int Length, char *QualMsgQ,
+                     Qus_EC_t *pErrorData)
+{
+  printf("%10.10s/%10.10s: %.*s\n", &(QualMsgQ[10]), QualMsgQ,
+         Length, Text);
+}
+
+/***************************************************************************/
+/* Function:  PlatLocalTime()                                              */
+/***************************************************************************/
+void PlatLocalTime(char *LocalDateTime)
+{
+  time_t    now;
+  struct tm tm;
+  char      work[64];
+
+  now = time(0);
+  gmtime_r(&now, &tm);
+  sprintf(work, "%04d%02d%02d%02d%02d%02d000",
+          tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday,
+          tm.tm_hour, tm.tm_min, tm.tm_sec);
+  memcpy(LocalDateTime, work, 17);
+}
+
+/***************************************************************************/
+/* Function:  PlatDeleteReceiver()                                         */
+/*                                                                         */
+/* Description: Delete a receiver from the simulated chain.  Deleting the  */
+/*              attached receiver, or one that is not in the chain, fails  */
+/*              as DLTJRNRCV would.                                        */
+/*                                                                         */
+/***************************************************************************/
+int PlatDeleteReceiver(char *szLibName, char *RcvName, Qus_EC_t *pErrorData)
+{
+  struct SimJournal *pJrn;
+  int        Number,
+  DelayMs;
+
+  pthread_mutex_lock(&SimLock);
+  pJrn = SimFindReceiver(szLibName, RcvName, &Number);
+  if (! pJrn) {
+    pthread_mutex_unlock(&SimLock);
+    SimSetError(pErrorData, "CPF7002");        /* Receiver not found      */
+    return 1;
+  };
+  if (Number == pJrn->Total) {
+    pthread_mutex_unlock(&SimLock);
+    SimSetError(pErrorData, "CPF7021");        /* Receiver is attached    */
+    return 1;
+  };
+  if (Number == SimDeleteFail) {
+    pthread_mutex_unlock(&SimLock);
+    SimSetError(pErrorData, "CPF2189");        /* Not authorized          */
+    return 1;
+  };
+  pJrn->State[Number] |= SIM_DELETED;
+  pthread_mutex_unlock(&SimLock);
+
+  DelayMs = SimIsBusy() ? SimBusyDeleteMs : SimDeleteMs;
+  if (DelayMs > 0) {
+    usleep(DelayMs * 1000);
+  };
+  return 0;
+}
+
+/***************************************************************************/
+/* Function:  PlatSaveReceiver()                                           */
+/*                                                                         */
+/* Description: Mark a receiver of the simulated chain as saved, once the  */
+/*              save delay has passed.  The save library isn't simulated.  */
+/*                                                                         */
+/***************************************************************************/
+int PlatSaveReceiver(char *szLibName, char *RcvName, char *SavLib,
+                     Qus_EC_t *pErrorData)
+{
+  struct SimJournal *pJrn;
+  int        Number;
+
+  pthread_mutex_lock(&SimLock);
+  pJrn = SimFindReceiver(szLibName, RcvName, &Number);
+  if (! pJrn) {
+    pthread_mutex_unlock(&SimLock);
+    SimSetError(pErrorData, "CPF3741");        /* Object not saved        */
+    return 1;
+  };
+  if (Number == SimSaveFail) {
+    pthread_mutex_unlock(&SimLock);
+    SimSetError(pErrorData, "CPF3782");        /* Save file damaged/full  */
+    return 1;
+  };
+  pthread_mutex_unlock(&SimLock);
+
+  if (SimSaveMs > 0) {
+    usleep(SimSaveMs * 1000);
+  };
+
+  if (SimWriteSaveFile(SavLib, RcvName, Number)) {
+    SimSetError(pErrorData, "CPF5101");        /* Can't write save file   */
+    return 1;
+  };
+
+  pthread_mutex_lock(&SimLock);
+  pJrn->State[Number] |= SIM_SAVED;
+  pthread_mutex_unlock(&SimLock);
+  return 0;
+}
+
+/***************************************************************************/
+/* Function:  SimWriteSaveFile()                                           */
+/*                                                                         */
+/* Description: Write the save file for receiver Number - a header of      */
+/*              100 to 400 bytes, then lines for entries Number * Lines to */
+/*              (Number + 2) * Lines, so each save file repeats half of    */
+/*              the one before at a different offset                       */
+/*                                                                         */
+/***************************************************************************/
+static int SimWriteSaveFile(char *SavLib, char *RcvName, int Number)
+{
+  FILE *fp;
+  char  Path[300],
+  Line[128];
+  int   Lines = (SimRcvKB ? SimRcvKB : SIM_SAVF_KB) * 1024 / 2 / 100,
+  entry,
+  len;
+  unsigned int seed;
+
+  PlatSaveFilePath(SavLib, RcvName, Path);
+  fp = fopen(Path, "wb");
+  if (! fp) return 1;
+
+  len = sprintf(Line, "SAVF %10.10s %10.10s ", SavLib, RcvName);
+  fwrite(Line, 1, len, fp);
+  for (len = 100 + Number * 37 % 300 - len; len > 0; len--) {
+    fputc('.', fp);
+  };
+
+  for (entry = Number * Lines; entry < (Number + 2) * Lines; entry++) {
+    seed = entry * 2654435761u;
+    len = sprintf(Line, "%010d %c%c AMQRMPPA  QMQM      %06u "
+                  "Message data %08X%08X SYSTEM.CHANNEL.SYNCQ",
+                  entry, entry % 10 ? 'P' : 'S', entry % 10 ? 'T' : 'C',
+                  seed % 1000000, seed, seed * 69069u + 1);
+    memset(Line + len, ' ', 99 - len);
+    Line[99] = '\n';
+    fwrite(Line, 1, 100, fp);
+  };
+
+  return fclose(fp) ? 1 : 0;
+}
+
+/***************************************************************************/
+/* Function:  PlatSaveFilePath()                                           */
+/*                                                                         */
+/* Description: The simulated save files are ordinary files in             */
+/*              JRNSIM_SAVF_DIR                                            */
+/*                                                                         */
+/***************************************************************************/
+void PlatSaveFilePath(char *SavLib, char *RcvName, char *Path)
+{
+  int   libLen,
+  rcvLen;
+
+  SimConfigure();
+  for (libLen = 10; libLen > 0 && SavLib[libLen - 1] == ' '; libLen--);
+  for (rcvLen = 10; rcvLen > 0 && RcvName[rcvLen - 1] == ' '; rcvLen--);
+  sprintf(Path, "%s/%.*s.%.*s.savf", SimSavfDir, libLen, SavLib, rcvLen,
+          RcvName);
+}
+
+/***************************************************************************/
+/* Function:  PlatDeleteSaveFile()                                         */
+/***************************************************************************/
+int PlatDeleteSaveFile(char *SavLib, char *RcvName, Qus_EC_t *pErrorData)
+{
+  char  Path[300];
+
+  PlatSaveFilePath(SavLib, RcvName, Path);
+  if (unlink(Path)) {
+    SimSetError(pErrorData, "CPF2105");        /* Object not found        */
+    return 1;
+  };
+  return 0;
+}
+
+/***************************************************************************/
+/* Function:  SimFindReceiver()                                            */
+/*                                                                         */
+/* Description: Find the journal and number of a receiver that is still   */
+/*              in its chain - called holding SimLock                      */
+/*                                                                         */
+/***************************************************************************/
+static struct SimJournal *SimFindReceiver(char *szLibName, char *RcvName,
+                                          int *pNumber)
+{
+  struct SimJournal *pJrn;
+  char       Lib[10],
+  szNumber[8];
+
+  memset(Lib, ' ', 10);
+  memcpy(Lib, szLibName, strlen(szLibName) < 10 ? strlen(szLibName) : 10);
+  if (! memcmp(RcvName, "AMQA", 4)) {
+    memcpy(szNumber, &(RcvName[4]), 6);
+    szNumber[6] = '\0';
+  }
+  else if (! memcmp(RcvName, "AMQ", 3)) {
+    memcpy(szNumber, &(RcvName[3]), 7);
+    szNumber[7] = '\0';
+  }
+  else {
+    return 0;
+  };
+  *pNumber = atoi(szNumber);
+
+  pJrn = SimFindJournal(Lib);
+  if (! pJrn || *pNumber < 1 || *pNumber > pJrn->Total || 
+      (pJrn->State[*pNumber] & SIM_DELETED)) {
+    return 0;
+  };
+  return pJrn;
+}
+
+/***************************************************************************/
+/* Function:  PlatChangeJournal()                                          */
+/*                                                                         */
+/* Description: Attach a new receiver to the simulated chain               */
+/*                                                                         */
+/***************************************************************************/
+int PlatChangeJournal(char *szLibName, Qus_EC_t *pErrorData)
+{
+  struct SimJournal *pJrn;
+  char       Lib[10],
+  *pState;
+
+  memset(Lib, ' ', 10);
+  memcpy(Lib, szLibName, strlen(szLibName) < 10 ? strlen(szLibName) : 10);
+
+  pthread_mutex_lock(&SimLock);
+  pJrn = SimFindJournal(Lib);
+  if (! pJrn) {
+    pthread_mutex_unlock(&SimLock);
+    SimSetError(pErrorData, "CPF9801");        /* Journal not found       */
+    return 1;
+  };
+  pState = (char*)realloc(pJrn->State, pJrn->Total + 2);
+  if (! pState) {
+    pthread_mutex_unlock(&SimLock);
+    SimSetError(pErrorData, "CPF7010");        /* Receiver not created    */
+    return 1;
+  };
+  pState[pJrn->Total + 1] = 0;
+  pJrn->State = pState;
+  pJrn->Total++;
+  pthread_mutex_unlock(&SimLock);
+  return 0;
+}
+
+/***************************************************************************/
+/* Function:  PlatFindMQObject()                                           */
+/*                                                                         */
+/* Description: A JRNSIM_MEDIA object's file is its queue, other than      */
+/*              JRNSIM_MEDIA_NOMAP's; no other object is found             */
+/*                                                                         */
+/***************************************************************************/
+int PlatFindMQObject(char *szLibName, char *QmgrName, char *Object,
+                     char *MQName, char *MQType)
+{
+  char       work[32];
+  int        count;
+
+  for (count = 1; count <= SimMedia; count++) {
+    sprintf(work, SIM_MEDIA_OBJ, count);
+    if (! memcmp(Object, work, 10) && count != SimMediaNoMap) {
+      sprintf(MQName, SIM_MEDIA_Q, count);
+      strcpy(MQType, "*Q");
+      return 0;
+    };
+  };
+  return 1;
+}
+
+/***************************************************************************/
+/* Function:  PlatRecordImage()                                            */
+/*                                                                         */
+/* Description: Record a JRNSIM_MEDIA queue's media image, or with *ALL    */
+/*              all of them, so they no longer hold the oldest entry       */
+/*              needed back.  The queue manager name isn't checked; any    */
+/*              other object is not found.                                 */
+/*                                                                         */
+/***************************************************************************/
+int PlatRecordImage(char *szLibName, char *QmgrName, char *ObjName,
+                    char *ObjType, Qus_EC_t *pErrorData)
+{
+  struct SimJournal *pJrn;
+  char       Lib[10],
+  work[32];
+  int        all = ! strcmp(ObjName, "*ALL"),
+  count;
+
+  memset(Lib, ' ', 10);
+  memcpy(Lib, szLibName, strlen(szLibName) < 10 ? strlen(szLibName) : 10);
+
+  pthread_mutex_lock(&SimLock);
+  pJrn = SimFindJournal(Lib);
+  for (count = 1; pJrn && ! all && count <= SimMedia; count++) {
+    sprintf(work, SIM_MEDIA_Q, count);
+    if (! strcmp(work, ObjName) && ! strcmp(ObjType, "*Q")) break;
+  };
+  if (! pJrn || (! all && count > SimMedia)) {
+    pthread_mutex_unlock(&SimLock);
+    SimSetError(pErrorData, "AMQ8147");        /* Object not found        */
+    return 1;
+  };
+  for (count = all ? 1 : count; count <= SimMedia; count++) {
+    pJrn->Media[count] = 0;
+    if (! all) break;
+  };
+  pthread_mutex_unlock(&SimLock);
+
+  if (SimImageMs > 0) {
+    usleep(SimImageMs * 1000);
+  };
+  return 0;
+}
+
+/***************************************************************************/
+/* Function:  PlatRunProbe()                                               */
+/*                                                                         */
+/* Description: The command isn't run - it fails while JRNSIM_BUSY says    */
+/*              the system is busy                                         */
+/*                                                                         */
+/***************************************************************************/
+int PlatRunProbe(char *Command, Qus_EC_t *pErrorData)
+{
+  pthread_mutex_lock(&SimLock);
+  SimConfigure();
+  pthread_mutex_unlock(&SimLock);
+
+  if (SimIsBusy()) {
+    SimSetError(pErrorData, "CPF9898");        /* Escape message sent     */
+    return 1;
+  };
+  return 0;
+}
+
+/***************************************************************************/
+/* Function:  PlatGetAspUsage()                                            */
+/***************************************************************************/
+int PlatGetAspUsage(long long *pCapacityMB, int *pPercentUsed,
+                    Qus_EC_t *pErrorData)
+{
+  pthread_mutex_lock(&SimLock);
+  SimConfigure();
+  *pCapacityMB = SimAspMB;
+  *pPercentUsed = SimAspUsed * 10000;
+  pthread_mutex_unlock(&SimLock);
+  return 0;
+}
+
+/***************************************************************************/
+/* Function:  PlatMicroseconds()                                           */
+/***************************************************************************/
+long long PlatMicroseconds(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return (long long)tv.tv_sec * 1000000 + tv.tv_usec;
+}
@@ -24,6 +24,7 @@
  MQJRNMNT:   CMD        PROMPT('MQ Journal maintenance')
 
              PARM       KWD(QMGRLIB) TYPE(*NAME) LEN(10) MIN(1) +
+                          MAX(50) SNGVAL((*ALL)) +
                           PROMPT('Queue manager library name')
              PARM       KWD(OUTPUT) TYPE(*CHAR) LEN(6) RSTD(*YES) +
                           DFT(*PRINT) VALUES(*PRINT *MSGQ) +
@@ -31,5 +32,82 @@
              PARM       KWD(DLTRCV) TYPE(*CHAR) LEN(4) RSTD(*YES) +
                           DFT(*NO) VALUES(*YES *NO) PROMPT('Delete +
                           receivers')
+             PARM       KWD(THREADS) TYPE(*INT2) DFT(4) RANGE(1 32) +
+                          PROMPT('Queue managers in parallel')
+             PARM       KWD(MODE) TYPE(*CHAR) LEN(9) RSTD(*YES) +
+                          DFT(*ONCE) VALUES(*ONCE *RESIDENT +
+                          *HISTORY *REPLAY *RESTORE) +
+                          PROMPT('Run mode')
+             PARM       KWD(INTERVAL) TYPE(*INT2) DFT(10) +
+                          RANGE(1 3600) PROMPT('Resident check +
+                          interval (seconds)')
+             PARM       KWD(SAVRCV) TYPE(*CHAR) LEN(4) RSTD(*YES) +
+                          DFT(*NO) VALUES(*YES *NO) PROMPT('Save +
+                          receivers before deleting')
+             PARM       KWD(SAVLIB) TYPE(*NAME) LEN(10) +
+                          DFT(*QMGRLIB) SPCVAL((*QMGRLIB)) +
+                          PROMPT('Library for save files')
+             PARM       KWD(DETAIL) TYPE(*CHAR) LEN(9) RSTD(*YES) +
+                          DFT(*DFT) VALUES(*DFT *SUMMARY *RECEIVER) +
+                          PROMPT('Level of detail')
+             PARM       KWD(METRICS) TYPE(*PNAME) LEN(256) +
+                          DFT(*NONE) SPCVAL((*NONE)) +
+                          PROMPT('Metrics file')
+             PARM       KWD(ANALYZE) TYPE(*CHAR) LEN(4) RSTD(*YES) +
+                          DFT(*NO) VALUES(*YES *NO) PROMPT('Forecast +
+                          journal growth')
+             PARM       KWD(ASPTHLD) TYPE(*INT2) DFT(90) RANGE(0 99) +
+                          PROMPT('ASP threshold (percent)')
+             PARM       KWD(CHGJRN) TYPE(*CHAR) LEN(4) RSTD(*YES) +
+                          DFT(*NO) VALUES(*YES *NO) PROMPT('Attach +
+                          a new receiver first')
+             PARM       KWD(FINDPIN) TYPE(*CHAR) LEN(4) RSTD(*YES) +
+                          DFT(*NO) VALUES(*YES *NO) PROMPT('Find +
+                          what holds the oldest receiver')
+             PARM       KWD(HISTORY) TYPE(*PNAME) LEN(256) +
+                          DFT(*NONE) SPCVAL((*NONE)) +
+                          PROMPT('History directory')
+             PARM       KWD(WINDOW) TYPE(*INT2) DFT(24) +
+                          RANGE(1 8784) PROMPT('History window +
+                          (hours)')
+             PARM       KWD(TRACE) TYPE(*PNAME) LEN(256) +
+                          DFT(*NONE) SPCVAL((*NONE)) +
+                          PROMPT('Trace file')
+             PARM       KWD(RETAIN) TYPE(*INT2) DFT(0) +
+                          RANGE(0 9999) PROMPT('Extra receivers to +
+                          keep')
+             PARM       KWD(MINAGE) TYPE(*INT2) DFT(0) +
+                          RANGE(0 8784) PROMPT('Minimum age after +
+                          detach (hours)')
+             PARM       KWD(REQSAVED) TYPE(*CHAR) LEN(4) RSTD(*YES) +
+                          DFT(*NO) VALUES(*YES *NO) PROMPT('Only +
+                          delete saved receivers')
+             PARM       KWD(PROTECT) TYPE(*CHAR) LEN(21) +
+                          DFT(*NONE) SPCVAL((*NONE)) MAX(20) +
+                          PROMPT('Protected receivers')
+             PARM       KWD(ARCHIVE) TYPE(*PNAME) LEN(256) +
+                          DFT(*NONE) SPCVAL((*NONE)) +
+                          PROMPT('Archive directory')
+             PARM       KWD(RSTRCV) TYPE(*NAME) LEN(10) +
+                          DFT(*NONE) SPCVAL((*NONE)) +
+                          PROMPT('Receiver to restore')
+             PARM       KWD(DLTRATE) TYPE(*INT4) DFT(*NOMAX) +
+                          RANGE(1 2147483647) SPCVAL((*NOMAX 0)) +
+                          PROMPT('Delete rate (K per second)')
+             PARM       KWD(DLTPERMIN) TYPE(*INT2) DFT(*NOMAX) +
+                          RANGE(1 3600) SPCVAL((*NOMAX 0)) +
+                          PROMPT('Receivers deleted per minute')
+             PARM       KWD(LOADPROBE) TYPE(*CHAR) LEN(256) +
+                          DFT(*NONE) SPCVAL((*NONE)) CASE(*MIXED) +
+                          PROMPT('Command that fails when busy')
+             PARM       KWD(MEDIAIMG) TYPE(*CHAR) LEN(4) RSTD(*YES) +
+                          DFT(*NO) VALUES(*YES *NO) +
+                          PROMPT('Record pinning media images')
+             PARM       KWD(IMGMAX) TYPE(*INT2) DFT(10) +
+                          RANGE(1 9999) +
+                          PROMPT('Most media images to record')
+             PARM       KWD(IMGWAIT) TYPE(*INT2) DFT(0) +
+                          RANGE(0 3600) +
+                          PROMPT('Seconds between media images')
                           
 /*******************************************************************/
@@ -0,0 +1,98 @@
+#############################################################################
+#                                                                           #
+#  Benchmarks of JRNMAINT against the simulated IBM i APIs                  #
+#  (src/jrnsim.c), from the timings in the METRICS file:                    #
+#                                                                           #
+#    - receiver chains of 10 to 1,000,000 receivers                         #
+#    - many queue managers, one at a time and in parallel                   #
+#    - slow deletes                                                         #
+#    - startup - checking the libraries and reading AMQJRNINF               #
+#                                                                           #
+#  The simulator's own time is included, so compare runs of the same       #
+#  build of it rather than reading the figures as IBM i times.             #
+#                                                                           #
+#  sh test/bench.sh build/jrnmaint                                          #
+#                                                                           #
+#############################################################################
+. "$(dirname "$0")/common.sh"
+
+# Seconds taken by a phase, summed over the queue managers
+phase() {
+  grep -F "phase=\"$1\"}" "$PROM" | grep -v run_seconds |
+    awk '{ total += $2 } END { printf "%.6f", total }'
+}
+
+#############################################################################
+#  Receiver chain length                                                    #
+#############################################################################
+echo "Receiver chain length - the queue manager needs the last 3 receivers"
+printf "%10s %-7s %10s %10s %10s %10s\n" \
+  receivers DLTRCV chain scan delete total
+for Receivers in 10 100 1000 10000 100000 1000000; do
+  for Delete in '*NO' '*YES'; do
+    case_run "chain of $Receivers" DLTRCV="$Delete" METRICS="$PROM" \
+      JRNSIM_RECEIVERS=$Receivers
+    expect_rc 0
+    [ "$Delete" = '*NO' ] || expect_deleted $((Receivers - 3))
+    printf "%10s %-7s %10s %10s %10s %10s\n" $Receivers "$Delete" \
+      $(phase chain) $(phase scan) $(phase delete) \
+      $(metric 'jrnmaint_run_seconds{phase="total"}')
+  done
+done
+
+#############################################################################
+#  Many queue managers, up to the 50 QMGRLIB takes, each with a chain of   #
+#  1000 receivers                                                           #
+#############################################################################
+echo
+echo "Queue managers - 1000 receivers each, DLTRCV(*YES)"
+printf "%10s %7s %10s %10s\n" qmgrs threads delete total
+for Qmgrs in 1 10 50; do
+  Libs=$(awk -v n=$Qmgrs 'BEGIN { for (i = 1; i <= n; i++)
+                                    printf "%sQM%04d", (i > 1 ? "," : ""), i }')
+  for Threads in 1 8; do
+    case_run "$Qmgrs queue managers" QMGRLIB=$Libs THREADS=$Threads \
+      DLTRCV='*YES' METRICS="$PROM" JRNSIM_RECEIVERS=1000
+    expect_rc 0
+    printf "%10s %7s %10s %10s\n" $Qmgrs $Threads $(phase delete) \
+      $(metric 'jrnmaint_run_seconds{phase="total"}')
+  done
+done
+
+#############################################################################
+#  Slow deletes - 4 queue managers of 100 receivers, 5 ms a delete          #
+#############################################################################
+echo
+echo "Slow deletes - 4 queue managers of 100 receivers, 5 ms a DLTJRNRCV"
+printf "%7s %10s %10s\n" threads delete total
+for Threads in 1 2 4; do
+  case_run "slow deletes" QMGRLIB=QMA,QMB,QMC,QMD THREADS=$Threads \
+    DLTRCV='*YES' METRICS="$PROM" JRNSIM_RECEIVERS=100 JRNSIM_DELETE_MS=5
+  expect_rc 0
+  expect_line "4 queue manager(s) processed, 0 failed, 388 receiver(s)"
+  printf "%7s %10s %10s\n" $Threads $(phase delete) \
+    $(metric 'jrnmaint_run_seconds{phase="total"}')
+done
+
+#############################################################################
+#  Startup - the fixed cost of each run: checking each queue manager       #
+#  library exists and reading its AMQJRNINF, before the receiver chains    #
+#  are looked at.  A chain of 3 receivers, so the rest is small.           #
+#############################################################################
+echo
+echo "Startup - microseconds, per queue manager for chkobj and usrspc"
+printf "%10s %10s %10s %10s %10s\n" qmgrs startup chkobj usrspc total
+for Qmgrs in 1 10 50; do
+  Libs=$(awk -v n=$Qmgrs 'BEGIN { for (i = 1; i <= n; i++)
+                                    printf "%sQM%04d", (i > 1 ? "," : ""), i }')
+  case_run "startup, $Qmgrs queue managers" QMGRLIB=$Libs THREADS=1 \
+    METRICS="$PROM" JRNSIM_RECEIVERS=3
+  expect_rc 0
+  awk -v n=$Qmgrs -v startup=$(metric 'jrnmaint_run_seconds{phase="startup"}') \
+      -v chkobj=$(phase chkobj) -v usrspc=$(phase usrspc) \
+      -v total=$(metric 'jrnmaint_run_seconds{phase="total"}') \
+      'BEGIN { printf "%10d %10.0f %10.1f %10.1f %10.0f\n", n, startup * 1e6,
+                      chkobj * 1e6 / n, usrspc * 1e6 / n, total * 1e6 }'
+done
+
+[ "$FAILED" = 0 ]
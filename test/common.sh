@@ -0,0 +1,114 @@
+#############################################################################
+#                                                                           #
+#  Shared by functest.sh and bench.sh - runs JRNMAINT, built with the       #
+#  simulator, and checks what it reported.                                  #
+#                                                                           #
+#  run [PARM=VALUE ...] [JRNSIM_xxx=VALUE ...]                              #
+#    Runs the program with the MQJRNMNT defaults, other than               #
+#    QMGRLIB(QMTEST) and DETAIL(*SUMMARY), changed by the PARM=VALUE        #
+#    arguments, and with the JRNSIM_ environment variables given.  The      #
+#    output is left in $OUT, the return code in $RC and, if METRICS=$PROM   #
+#    is given, the metrics in $PROM.  MODE(*RESIDENT) is ended once it has  #
+#    written the metrics of its first check, or RUNSECS=n seconds after.    #
+#                                                                           #
+#############################################################################
+
+JRNMAINT=${1:?usage: $0 path-to-jrnmaint}
+WORK=$(mktemp -d "${TMPDIR:-/tmp}/jrntest.XXXXXX") || exit 1
+trap 'rm -rf "$WORK"' EXIT
+OUT=$WORK/out
+PROM=$WORK/metrics.prom
+TESTS=0
+FAILED=0
+
+run() (
+  QMGRLIB=QMTEST OUTPUT='*PRINT' DLTRCV='*NO' THREADS=4 MODE='*ONCE'
+  INTERVAL=10 SAVRCV='*NO' SAVLIB='*QMGRLIB' DETAIL='*SUMMARY'
+  METRICS='*NONE' ANALYZE='*NO' ASPTHLD=90 CHGJRN='*NO' FINDPIN='*NO'
+  HISTORY='*NONE' WINDOW=24 TRACE='*NONE' RETAIN=0 MINAGE=0 REQSAVED='*NO'
+  PROTECT='*NONE' ARCHIVE='*NONE' RSTRCV='*NONE' DLTRATE=0 DLTPERMIN=0
+  LOADPROBE='*NONE' MEDIAIMG='*NO' IMGMAX=10 IMGWAIT=0 RUNSECS=0
+  JRNSIM_SAVF_DIR=$WORK
+  export JRNSIM_SAVF_DIR
+
+  for Parm in "$@"; do
+    case "$Parm" in
+      JRNSIM_*=*) export "$Parm" ;;
+      *=*)        eval "${Parm%%=*}=\${Parm#*=}" ;;
+    esac
+  done
+
+  rm -f "$PROM"
+  "$JRNMAINT" "$QMGRLIB" "$OUTPUT" "$DLTRCV" "$THREADS" "$MODE" \
+    "$INTERVAL" "$SAVRCV" "$SAVLIB" "$DETAIL" "$METRICS" "$ANALYZE" \
+    "$ASPTHLD" "$CHGJRN" "$FINDPIN" "$HISTORY" "$WINDOW" "$TRACE" \
+    "$RETAIN" "$MINAGE" "$REQSAVED" "$PROTECT" "$ARCHIVE" "$RSTRCV" \
+    "$DLTRATE" "$DLTPERMIN" "$LOADPROBE" "$MEDIAIMG" "$IMGMAX" \
+    "$IMGWAIT" > "$OUT" 2>&1 &
+  Pid=$!
+
+  # MODE(*RESIDENT) runs until it is ended - end it once the first check
+  # has written the metrics (or after 10 seconds), and RUNSECS after that
+  if [ "$MODE" = '*RESIDENT' ]; then
+    Tries=0
+    while [ ! -f "$PROM" ] && [ $Tries -lt 100 ] &&
+          kill -0 $Pid 2>/dev/null; do
+      sleep 0.1
+      Tries=$((Tries + 1))
+    done
+    sleep "$RUNSECS"
+    kill -TERM $Pid 2>/dev/null
+  fi
+  wait $Pid
+  echo $? > "$WORK/rc"
+)
+
+# Start a test case, and run it
+case_run() {
+  TESTS=$((TESTS + 1))
+  CASE=$1
+  shift
+  run "$@"
+  RC=$(cat "$WORK/rc")
+}
+
+fail() {
+  FAILED=$((FAILED + 1))
+  echo "FAIL: $CASE - $1"
+  sed 's/^/    /' "$OUT" | tail -20
+}
+
+# The output has a line containing this text
+expect_line() {
+  grep -F -q -- "$1" "$OUT" || fail "no line with \"$1\""
+}
+
+# No line in the output contains this text
+expect_no_line() {
+  ! grep -F -q -- "$1" "$OUT" || fail "line with \"$1\""
+}
+
+expect_rc() {
+  [ "$RC" = "$1" ] || fail "return code $RC, expected $1"
+}
+
+# Receivers deleted - for a single queue manager
+expect_deleted() {
+  expect_line "JrnMaint finished - $1 receiver(s) have been deleted."
+}
+
+# The oldest receiver needed
+expect_oldest() {
+  expect_line "** $1 is the oldest *JRNRCV that we need to keep **"
+}
+
+# A metric in $PROM, NAME{LABELS} VALUE
+expect_metric() {
+  Value=$(grep -F -- "$1 " "$PROM" 2>/dev/null | sed 's/.* //')
+  [ "$Value" = "$2" ] || fail "metric $1 is \"$Value\", expected $2"
+}
+
+# A metric's value, to compare
+metric() {
+  grep -F -- "$1 " "$PROM" 2>/dev/null | sed 's/.* //'
+}
@@ -0,0 +1,283 @@
+#############################################################################
+#                                                                           #
+#  Functional tests of JRNMAINT against the simulated IBM i APIs            #
+#  (src/jrnsim.c).  Each case sets up the simulated receiver chain with     #
+#  the JRNSIM_ environment variables, runs the program and checks the      #
+#  oldest receiver it found to be needed, what it deleted and its return   #
+#  code.                                                                    #
+#                                                                           #
+#  sh test/functest.sh build/jrnmaint                                       #
+#                                                                           #
+#############################################################################
+. "$(dirname "$0")/common.sh"
+
+#############################################################################
+#  The oldest receiver needed, and the receivers before it deleted          #
+#############################################################################
+case_run "report only"
+expect_rc 0
+expect_oldest AMQA000018
+expect_line "Keeping 3 receiver(s), 17 older receiver(s) are not needed"
+expect_deleted 0
+
+case_run "delete" DLTRCV='*YES'
+expect_rc 0
+expect_oldest AMQA000018
+expect_deleted 17
+
+case_run "only the attached receiver needed" DLTRCV='*YES' JRNSIM_KEEP=1
+expect_oldest AMQA000020
+expect_deleted 19
+
+case_run "every receiver needed" DLTRCV='*YES' JRNSIM_KEEP=20
+expect_oldest AMQA000001
+expect_deleted 0
+
+case_run "single receiver chain" DLTRCV='*YES' JRNSIM_RECEIVERS=1
+expect_oldest AMQA000001
+expect_deleted 0
+
+# The oldest entry is in the second AMQA000041 was attached, so it may be
+# in AMQA000040
+case_run "receiver attached every second" DLTRCV='*YES' \
+  JRNSIM_RECEIVERS=50 JRNSIM_KEEP=10 JRNSIM_INTERVAL=1
+expect_oldest AMQA000040
+expect_deleted 39
+
+#############################################################################
+#  Long chains - retrieved in one call, sized from the bytes available      #
+#############################################################################
+case_run "chain of 100,000 receivers" DLTRCV='*YES' JRNSIM_RECEIVERS=100000 \
+  METRICS="$PROM"
+expect_rc 0
+expect_oldest AMQA099998
+expect_deleted 99997
+expect_metric 'jrnmaint_chain_receivers{qmgrlib="QMTEST"}' 100000
+expect_metric 'jrnmaint_chain_retrieve_calls{qmgrlib="QMTEST"}' 2
+
+case_run "chain past AMQA999999" DLTRCV='*YES' JRNSIM_RECEIVERS=1000005
+expect_rc 0
+expect_oldest AMQ1000003
+expect_deleted 1000002
+
+#############################################################################
+#  CHGJRN(*YES) attaches a new receiver first, and ANALYZE(*YES) forecasts  #
+#  from the chain.  JRNSIM_RECENT and JRNSIM_RCV_KB=1024 give receivers     #
+#  10 minutes apart written at 1.7 K a second, so the attached one (512 K)  #
+#  is switched in 5 minutes, and a 1000 MB system ASP half used reaches     #
+#  90% in about 240,000 seconds (2 days 18 hours)                           #
+#############################################################################
+case_run "change journal" CHGJRN='*YES' DLTRCV='*YES'
+expect_rc 0
+expect_line "Attached a new receiver to AMQAJRN (CHGJRN JRNRCV(*GEN))"
+expect_line "Attached receiver name: AMQA000021"
+expect_oldest AMQA000019
+expect_deleted 18
+
+case_run "forecast" ANALYZE='*YES' ASPTHLD=90 JRNSIM_RECENT=1 \
+  JRNSIM_RCV_KB=1024 JRNSIM_ASP_MB=1000 JRNSIM_ASP_USED=50
+expect_rc 0
+expect_line "a receiver was attached every 10m 0s over the last 19"
+expect_line "journal write rate 1.7 K/second"
+expect_line "2560 K in the receivers kept, 17408 K can be released"
+expect_line "is likely to be switched in 5m 0s"
+expect_line "system ASP is 50.00% used and will reach 90% in 2d 18h"
+
+case_run "forecast, ASP over the threshold" ANALYZE='*YES' ASPTHLD=90 \
+  JRNSIM_RECENT=1 JRNSIM_RCV_KB=1024 JRNSIM_ASP_MB=1000 JRNSIM_ASP_USED=95
+expect_rc 0
+expect_line "system ASP is 95.00% used, over the 90% threshold"
+
+case_run "forecast, sizes not reported" ANALYZE='*YES' ASPTHLD=90
+expect_rc 0
+expect_line "receiver sizes were not reported, so the write rate is not known"
+expect_line "AMQA000020 was attached"
+expect_line "likely to be switched - it is overdue by"
+expect_line "can't forecast when it will reach 90% without the write rate"
+
+#############################################################################
+#  Errors                                                                   #
+#############################################################################
+case_run "library not found" QMGRLIB=QMNONE JRNSIM_LIBS=QMTEST
+expect_rc 2
+expect_line "Queue manager library QMNONE not found"
+
+case_run "failed delete" DLTRCV='*YES' JRNSIM_DELETE_FAIL=5
+expect_rc 7
+expect_deleted 16
+
+case_run "wrong arguments" TRACE="$WORK/trace" MODE='*RESIDENT'
+expect_rc 1
+expect_line "ERROR: TRACE can only be written with MODE(*ONCE)"
+
+case_run "wrong PROTECT" PROTECT='AMQA0000000001'
+expect_rc 1
+expect_line "ERROR: PROTECT(AMQA0000000001"
+
+#############################################################################
+#  What is holding on to the oldest receiver - an open commit cycle, or    #
+#  an object's media image, named by its library, name and member          #
+#############################################################################
+case_run "pinned by a commit cycle" FINDPIN='*YES'
+expect_oldest AMQA000018
+expect_line "program AMQRMPPA   for object *NONE"
+
+case_run "pinned for media recovery" FINDPIN='*YES' JRNSIM_MEDIA=4
+expect_oldest AMQA000001
+expect_line "program AMQZLAA0   for object QMTEST/SIMMEDIA01"
+expect_line "so it is held for media recovery"
+
+# A receiver whose last entry is a commit entry - the scan ends on the
+# continuation handle rather than asking for entries after the last one
+case_run "pinned, receivers ending in a commit" FINDPIN='*YES' \
+  JRNSIM_INTERVAL=611
+expect_oldest AMQA000018
+expect_line "program AMQRMPPA   for object *NONE"
+expect_no_line "retrieving journal entries"
+
+#############################################################################
+#  MEDIAIMG - the images of the objects holding the oldest receiver back,  #
+#  recorded one at a time, each deleting the receivers it released.  The   #
+#  queue of JRNSIM_MEDIA_NOMAP isn't found from its file, so OBJ(*ALL) is  #
+#  recorded in its place                                                   #
+#############################################################################
+case_run "media images" DLTRCV='*YES' MEDIAIMG='*YES' JRNSIM_MEDIA=4 \
+  JRNSIM_RCV_KB=1024 METRICS="$PROM"
+expect_rc 0
+expect_line "Attached a new receiver to AMQAJRN"
+expect_line "RCDMQMIMG of JRNSIM.MEDIA.QUEUE.01 (*Q) took"
+expect_line "ms, released 4 receiver(s), 4096 K - oldest entry needed now (2024-01-01 00:43:20.000) in AMQA000005"
+expect_line "ms, released 6 receiver(s), 6144 K - oldest entry needed now (2024-01-01 03:05:00.000) in AMQA000019"
+expect_line "ms, released 18 more receiver(s), 18432 K"
+expect_deleted 18
+expect_metric 'jrnmaint_media_images{qmgrlib="QMTEST"}' 4
+
+case_run "media images, queue not found" DLTRCV='*YES' MEDIAIMG='*YES' \
+  JRNSIM_MEDIA=4 JRNSIM_MEDIA_NOMAP=3 METRICS="$PROM"
+expect_rc 0
+expect_line "no MQ object found for the oldest entry needed (object QMTEST/SIMMEDIA03)"
+expect_line "RCDMQMIMG of *ALL (*ALL) took"
+expect_line "ms, released 10 receiver(s)"
+expect_deleted 18
+expect_metric 'jrnmaint_media_images{qmgrlib="QMTEST"}' 3
+
+case_run "media images only once" MEDIAIMG='*YES' MODE='*RESIDENT'
+expect_rc 1
+expect_line "ERROR: MEDIAIMG(*YES) can only be used with MODE(*ONCE)"
+
+#############################################################################
+#  Many queue managers, processed in parallel, with slow deletes            #
+#############################################################################
+case_run "many queue managers" DLTRCV='*YES' THREADS=8 \
+  QMGRLIB=QM01,QM02,QM03,QM04,QM05,QM06,QM07,QM08,QM09,QM10,QM11,QM12 \
+  JRNSIM_DELETE_MS=2 METRICS="$PROM"
+expect_rc 0
+expect_line "12 queue manager(s) processed, 0 failed, 204 receiver(s) have been deleted."
+expect_metric 'jrnmaint_deleted_receivers{qmgrlib="QM12"}' 17
+expect_metric 'jrnmaint_kept_receivers{qmgrlib="QM01"}' 3
+
+#############################################################################
+#  Saving before deleting, and the retention policy                         #
+#############################################################################
+case_run "save and delete" DLTRCV='*YES' SAVRCV='*YES' METRICS="$PROM"
+expect_rc 0
+expect_deleted 17
+expect_metric 'jrnmaint_saved_receivers{qmgrlib="QMTEST"}' 17
+
+case_run "failed save stops the deletes" DLTRCV='*YES' SAVRCV='*YES' \
+  JRNSIM_SAVE_FAIL=5
+expect_rc 8
+expect_deleted 4
+
+mkdir "$WORK/archive"
+case_run "save to an archive and delete" DLTRCV='*YES' SAVRCV='*YES' \
+  ARCHIVE="$WORK/archive"
+expect_rc 0
+expect_deleted 17
+expect_line "17 save file(s) archived"
+
+case_run "restore from the archive" MODE='*RESTORE' ARCHIVE="$WORK/archive" \
+  RSTRCV=AMQA000005
+expect_rc 0
+expect_line "Restored receiver AMQA000005"
+
+case_run "retention policy" DLTRCV='*YES' RETAIN=2 PROTECT=AMQA000003
+expect_rc 0
+expect_oldest AMQA000018
+expect_deleted 14
+
+#############################################################################
+#  HISTORY - a record for each check, other than one that only repeats     #
+#  the last, summarised by MODE(*HISTORY)                                  #
+#############################################################################
+mkdir "$WORK/history"
+case_run "history, report only" HISTORY="$WORK/history"
+expect_rc 0
+case_run "history, delete" HISTORY="$WORK/history" DLTRCV='*YES'
+expect_rc 0
+case_run "history, repeated check" HISTORY="$WORK/history"
+expect_rc 0
+case_run "history summary" MODE='*HISTORY' HISTORY="$WORK/history"
+expect_rc 0
+expect_line "History - 2 check(s) recorded for QMTEST, 2 in the last 24 hour(s)"
+expect_line "(AMQA000018) to 2024-01-01 02:55:00.000 (AMQA000018)"
+expect_line "chain of 20 receiver(s) (at most 20), 17 receiver(s) deleted"
+expect_line "History - average check took"
+
+#############################################################################
+#  Delete pacing - in resident mode, receivers the pace can't delete       #
+#  before the next check are left for it.  JRNSIM_BUSY makes LOADPROBE     #
+#  fail, so each delete halves the pace: the first is deleted, and the     #
+#  second would be 4 minutes later at 1/4 of DLTPERMIN(1).                 #
+#############################################################################
+case_run "paced deletes while busy" MODE='*RESIDENT' INTERVAL=2 \
+  DLTRCV='*YES' DLTPERMIN=1 LOADPROBE='CALL PGM(MYLIB/CHKLOAD)' \
+  JRNSIM_BUSY=0-3600 METRICS="$PROM"
+expect_rc 0
+expect_line "16 receiver(s) from AMQA000002 on are left to be deleted next time"
+expect_metric 'jrnmaint_deleted_receivers{qmgrlib="QMTEST"}' 1
+expect_metric 'jrnmaint_deferred_receivers{qmgrlib="QMTEST"}' 16
+expect_metric 'jrnmaint_delete_pace_divisor{qmgrlib="QMTEST"}' 4
+
+case_run "paced deletes while idle" MODE='*RESIDENT' INTERVAL=2 \
+  DLTRCV='*YES' LOADPROBE='CALL PGM(MYLIB/CHKLOAD)' JRNSIM_BUSY=3600-7200 \
+  METRICS="$PROM"
+expect_rc 0
+expect_metric 'jrnmaint_deleted_receivers{qmgrlib="QMTEST"}' 17
+expect_metric 'jrnmaint_deferred_receivers{qmgrlib="QMTEST"}' 0
+expect_metric 'jrnmaint_delete_pace_divisor{qmgrlib="QMTEST"}' 1
+
+#############################################################################
+#  Resident checks of a chain that grows - a receiver is attached every     #
+#  second, so later checks find more receivers no longer needed.  The      #
+#  cached index is brought up to date with just the new receivers, not     #
+#  rebuilt.                                                                 #
+#############################################################################
+case_run "resident, receivers attached" MODE='*RESIDENT' INTERVAL=1 \
+  DLTRCV='*YES' METRICS="$PROM" RUNSECS=3 JRNSIM_ATTACH_SECS=1
+expect_rc 0
+expect_line "AMQA000018 is the oldest *JRNRCV that we need to keep"
+expect_no_line "rebuilding index"
+Deleted=$(sed -n 's/.*JrnMaint ended - \([0-9]*\) receiver.*/\1/p' "$OUT")
+[ "${Deleted:-0}" -gt 17 ] ||
+  fail "${Deleted:-0} receiver(s) deleted, expected more than 17"
+
+#############################################################################
+#  The trace corpus - captured decisions replayed with MODE(*REPLAY).  The  #
+#  traces in test/traces were written by TRACE() runs of the simulator:     #
+#                                                                           #
+#    delete          the defaults, DLTRCV(*YES)                             #
+#    same-second     a receiver attached every second, JRNSIM_ENTRY_MS=500  #
+#    century         JRNSIM_START=946677600, a chain from 1999 into 2000    #
+#    failed-delete   QMA,QMB,QMC with RETAIN(2) PROTECT(AMQA000003) and     #
+#                    JRNSIM_DELETE_FAIL=5                                   #
+#    long-chain      1000 receivers a minute apart, 100 of them needed      #
+#############################################################################
+for Trace in "$(dirname "$0")"/traces/*.trc; do
+  case_run "replay $(basename "$Trace")" MODE='*REPLAY' TRACE="$Trace"
+  expect_rc 0
+  expect_line " - 0 mismatch(es)"
+done
+
+echo "$TESTS test(s), $FAILED failed"
+[ "$FAILED" = 0 ]
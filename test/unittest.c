@@ -0,0 +1,544 @@
+/***************************************************************************/
+/*                                                                         */
+/*  Program name:   UNITTEST                                               */
+/*  Function:       Unit tests of the JRNMAINT library functions, built    */
+/*                  with the simulated IBM i APIs (src/jrnsim.c)           */
+/*                                                                         */
+/*  jrnlib.c is included rather than linked, so the functions behind the   */
+/*  jrnmaint.h interface can be called directly.                          */
+/*                                                                         */
+/* Copyright (c) 2003,2024 IBM Corp.                                       */
+/*                                                                         */
+/* Licensed under the Apache License, Version 2.0 (the "License");         */
+/* you may not use this file except in compliance with the License.        */
+/* You may obtain a copy of the License at                                 */
+/*                                                                         */
+/*    http://www.apache.org/licenses/LICENSE-2.0                           */
+/*                                                                         */
+/* Unless required by applicable law or agreed to in writing, software     */
+/* distributed under the License is distributed on an "AS IS" BASIS,       */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.*/
+/* See the License for the specific language governing permissions and     */
+/* limitations under the License.                                          */
+/*                                                                         */
+/***************************************************************************/
+#include "../src/jrnlib.c"
+#include <sys/wait.h>
+
+/***************************************************************************/
+/*  Results                                                                */
+/***************************************************************************/
+int Tests = 0;
+int Failed = 0;
+
+#define CHECK(Cond, Desc)                                                 \
+  do {                                                                    \
+    Tests++;                                                              \
+    if (! (Cond)) {                                                       \
+      Failed++;                                                           \
+      printf("FAIL: %s (%s, line %d)\n", Desc, #Cond, __LINE__);          \
+    };                                                                    \
+  } while (0)
+
+/***************************************************************************/
+/*  Function prototypes                                                    */
+/***************************************************************************/
+void AddReceiver(struct RcvIndex *pIndex, char *CYYMMDDHHMMSS);
+JrnTime EntryAt(char *YYYYMMDDHHMMSSmmm);
+void TestTimes(void);
+void TestFindOldestNeeded(void);
+char AskExit(char *QmgrLib, char *RcvName);
+void TestJournalExit(void);
+void TestArchiveVerify(void);
+void TestHistory(void);
+void TestMaintApi(void);
+
+/***************************************************************************/
+/* Function:  main()                                                       */
+/***************************************************************************/
+int main(void)
+{
+  TestTimes();
+  TestFindOldestNeeded();
+  TestJournalExit();
+  TestArchiveVerify();
+  TestHistory();
+  TestMaintApi();
+
+  printf("%d check(s), %d failed\n", Tests, Failed);
+  return Failed ? 1 : 0;
+}
+
+/***************************************************************************/
+/* Function:  AddReceiver()                                                */
+/*                                                                         */
+/* Description: Add a receiver attached at CYYMMDDHHMMSS to the end of the */
+/*              index, as the receiver chain would                         */
+/*                                                                         */
+/***************************************************************************/
+void AddReceiver(struct RcvIndex *pIndex, char *CYYMMDDHHMMSS)
+{
+  Qjo_JN_Repeating_Key_1_Output_t Rcvr;
+  char  Name[24];
+
+  memset(&Rcvr, ' ', sizeof(Rcvr));
+  sprintf(Name, "AMQA%06d", pIndex->Count + 1);
+  memcpy(Rcvr.Jrn_Rcv_Name, Name, 10);
+  memcpy(Rcvr.Jrn_Rcv_Att_Date_Time, CYYMMDDHHMMSS, 13);
+  Rcvr.Jrn_Rcv_Size = 0;
+
+  GrowReceiverIndex(pIndex, pIndex->Count + 1);
+  SetIndexEntry(pIndex, pIndex->Count, &Rcvr);
+  pIndex->Count++;
+}
+
+/***************************************************************************/
+/* Function:  EntryAt()                                                    */
+/*                                                                         */
+/* Description: The time of an oldest journal entry, as AMQJRNINF holds it */
+/*                                                                         */
+/***************************************************************************/
+JrnTime EntryAt(char *YYYYMMDDHHMMSSmmm)
+{
+  struct JrnInf JrnInf;
+
+  memset(&JrnInf, ' ', sizeof(JrnInf));
+  memcpy(JrnInf.CC, YYYYMMDDHHMMSSmmm, 17);
+  return JrnInfTime(&JrnInf);
+}
+
+/***************************************************************************/
+/* Function:  TestTimes()                                                  */
+/*                                                                         */
+/* Description: AMQJRNINF and receiver attach times - milliseconds, the    */
+/*              century digit, and comparing the two                      */
+/*                                                                         */
+/***************************************************************************/
+void TestTimes(void)
+{
+  char  Text[24];
+
+  CHECK(EntryAt("20240101000000001") - EntryAt("20240101000000000") == 1,
+        "AMQJRNINF milliseconds are kept");
+  CHECK(EntryAt("20240101000001000") - EntryAt("20231231235959999") == 1001,
+        "AMQJRNINF times across a year end");
+  CHECK(RcvAttachTime("1240101000000") == EntryAt("20240101000000000"),
+        "attach time century 1 is 20YY, at the start of the second");
+  CHECK(RcvAttachTime("0991231235959") < RcvAttachTime("1000101000000"),
+        "attach time 1999 is before 2000");
+  CHECK(RcvAttachTime("1000101000000") - RcvAttachTime("0991231235959") ==
+        1000, "attach times across the century");
+  CHECK(RcvAttachTime("2000101000000") == EntryAt("21000101000000000"),
+        "attach time century 2 is 21YY");
+  CHECK(RcvAttachTime("1240229120000") + 86400000 ==
+        RcvAttachTime("1240301120000"), "leap day");
+
+  FormatJrnTime(EntryAt("20240229235958123"), TRUE, Text);
+  CHECK(! strcmp(Text, "2024-02-29 23:59:58.123"), "FormatJrnTime");
+  FormatJrnTime(RcvAttachTime("0991231235959"), FALSE, Text);
+  CHECK(! strcmp(Text, "1999-12-31 23:59:59"), "FormatJrnTime 19YY");
+}
+
+/***************************************************************************/
+/* Function:  TestFindOldestNeeded()                                       */
+/*                                                                         */
+/* Description: The receiver holding the oldest entry needed.  Attach      */
+/*              times are only to the second, so a receiver attached in    */
+/*              the same second as the entry may have been attached after  */
+/*              it, and the receiver before it is the one that is needed   */
+/*                                                                         */
+/***************************************************************************/
+void TestFindOldestNeeded(void)
+{
+  struct RcvIndex Index = {0, 0, 0, 0, 0, 0, 0};
+
+  CHECK(FindOldestNeeded(&Index, EntryAt("20240101000000000")) == -1,
+        "empty chain");
+
+  AddReceiver(&Index, "1240101000000");             /* 0 AMQA000001       */
+  AddReceiver(&Index, "1240101001000");             /* 1 AMQA000002       */
+  AddReceiver(&Index, "1240101002000");             /* 2 AMQA000003       */
+  AddReceiver(&Index, "1240101002000");             /* 3 AMQA000004 -     */
+                                                    /*   same second      */
+  AddReceiver(&Index, "1240101003000");             /* 4 AMQA000005       */
+
+  CHECK(FindOldestNeeded(&Index, EntryAt("20231231235959999")) == -1,
+        "cutoff before the first receiver");
+  CHECK(FindOldestNeeded(&Index, EntryAt("20240101000000000")) == -1,
+        "cutoff in the second the first receiver was attached");
+  CHECK(FindOldestNeeded(&Index, EntryAt("20240101000001000")) == 0,
+        "cutoff the second after the first receiver was attached");
+
+  CHECK(FindOldestNeeded(&Index, EntryAt("20240101000959999")) == 0,
+        "cutoff just before an attach");
+  CHECK(FindOldestNeeded(&Index, EntryAt("20240101001000000")) == 0,
+        "cutoff exactly on an attach time");
+  CHECK(FindOldestNeeded(&Index, EntryAt("20240101001000500")) == 0,
+        "cutoff in the same second as an attach, later milliseconds");
+  CHECK(FindOldestNeeded(&Index, EntryAt("20240101001000999")) == 0,
+        "cutoff at the last millisecond of the attach second");
+  CHECK(FindOldestNeeded(&Index, EntryAt("20240101001001000")) == 1,
+        "cutoff the millisecond after the attach second");
+
+  CHECK(FindOldestNeeded(&Index, EntryAt("20240101002000500")) == 1,
+        "two receivers attached in the cutoff's second");
+  CHECK(FindOldestNeeded(&Index, EntryAt("20240101002001000")) == 3,
+        "after two receivers attached in the same second");
+
+  CHECK(FindOldestNeeded(&Index, EntryAt("20240101003000000")) == 3,
+        "cutoff on the attached receiver's attach time");
+  CHECK(FindOldestNeeded(&Index, EntryAt("20240101003001000")) == 4,
+        "cutoff after the last receiver was attached");
+  CHECK(FindOldestNeeded(&Index, EntryAt("20991231235959999")) == 4,
+        "cutoff long after the last receiver was attached");
+
+  FreeReceiverIndex(&Index);
+}
+
+/***************************************************************************/
+/* Function:  AskExit()                                                    */
+/*                                                                         */
+/* Description: Ask the Delete Journal Receiver exit program whether a     */
+/*              receiver of a library's AMQAJRN may be deleted             */
+/*                                                                         */
+/***************************************************************************/
+char AskExit(char *QmgrLib, char *RcvName)
+{
+  struct DRCV0100 ExitInfo;
+  char  ReturnCode = ' ';
+
+  memset(&ExitInfo, ' ', sizeof(ExitInfo));
+  ExitInfo.Length = sizeof(ExitInfo);
+  memcpy(ExitInfo.RcvName, RcvName, strlen(RcvName));
+  memcpy(ExitInfo.RcvLib, QmgrLib, strlen(QmgrLib));
+  memcpy(ExitInfo.JrnName, JRN_NAME, 10);
+  memcpy(ExitInfo.JrnLib, QmgrLib, strlen(QmgrLib));
+  JournalExit((char*)&ExitInfo, &ReturnCode);
+  return ReturnCode;
+}
+
+/***************************************************************************/
+/* Function:  TestJournalExit()                                            */
+/*                                                                         */
+/* Description: The exit program's answers for more queue manager          */
+/*              libraries than it caches, and for libraries that aren't    */
+/*              queue manager libraries.  The simulated chains are the    */
+/*              default 20 receivers, of which the last 3 are needed.     */
+/*                                                                         */
+/***************************************************************************/
+void TestJournalExit(void)
+{
+  char  Lib[24],
+  Desc[80];
+  int   count,
+  pass;
+
+  setenv("JRNSIM_LIBS", "QM01,QM02,QM03,QM04,QM05,QM06,QM07,QM08,QM09,"
+         "QM10,QM11,QM12,QM13,QM14,QM15,QM16,QM17,QM18,QM19,QM20", 1);
+
+  CHECK(Exit.NumCaches == 0, "exit cache starts empty");
+  for (pass = 0; pass < 2; pass++) {
+    for (count = 1; count <= MAX_EXIT_QMGRS + 4; count++) {
+      sprintf(Lib, "QM%02d", count);
+      sprintf(Desc, "%s AMQA000017 can be deleted, pass %d", Lib, pass);
+      CHECK(AskExit(Lib, "AMQA000017") == EXIT_ELIGIBLE, Desc);
+      sprintf(Desc, "%s AMQA000018 is needed, pass %d", Lib, pass);
+      CHECK(AskExit(Lib, "AMQA000018") == EXIT_NOT_ELIGIBLE, Desc);
+    };
+  };
+  CHECK(Exit.NumCaches == MAX_EXIT_QMGRS, "exit cache is full");
+  for (count = 0; count < Exit.NumCaches; count++) {
+    sprintf(Desc, "exit cache holds a recently used library, not %.10s",
+            Exit.Caches[count].Qm.QmgrLib);
+    CHECK(atoi(Exit.Caches[count].Qm.szQmgrLib + 2) > 4, Desc);
+  };
+
+  CHECK(AskExit("NOTAQMGR", "AMQA000018") == EXIT_ELIGIBLE,
+        "library without AMQJRNINF");
+  CHECK(Exit.NumCaches == MAX_EXIT_QMGRS - 1,
+        "library without AMQJRNINF is not cached");
+  CHECK(AskExit("QM01", "AMQA000018") == EXIT_NOT_ELIGIBLE,
+        "needed receiver after a library without AMQJRNINF");
+}
+
+/***************************************************************************/
+/* Function:  TestArchiveVerify()                                          */
+/*                                                                         */
+/* Description: A save file is read back from the archive before it is     */
+/*              recorded.  Two chunks with the same hash are stood in for  */
+/*              by changing the last chunk in chunks.dat, so archiving     */
+/*              data that ends the same finds the changed chunk.  The new  */
+/*              chunks it added are dropped, and the archive stays locked. */
+/*                                                                         */
+/***************************************************************************/
+void TestArchiveVerify(void)
+{
+  struct JrnMaintConfig Config;
+  struct Archive *pArc;
+  struct ArcReceiver Rcv;
+  static const char *ArcFiles[5] = {"archive.lck", "chunks.dat",
+    "chunks.idx", "recipes.dat", "receivers.idx"};
+  struct flock Lock;
+  struct stat Stat;
+  unsigned char Data[65536];
+  char  Dir[] = "/tmp/jrnunitXXXXXX",
+  Path[300];
+  long long DataLen;
+  int   count,
+  fd,
+  mismatch,
+  NumChunks,
+  status;
+  pid_t pid;
+
+  CHECK(mkdtemp(Dir) != 0, "archive directory");
+  sprintf(Path, "%s/QMTEST.AMQA000001.savf", Dir);
+  srand(1);
+  for (count = 0; count < (int)sizeof(Data); count++) {
+    Data[count] = (unsigned char)rand();           /* Doesn't compress    */
+  };
+  fd = open(Path, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+  CHECK(write(fd, Data, sizeof(Data)) == sizeof(Data), "save file");
+  close(fd);
+
+  JrnMaintInitConfig(&Config);
+  Config.LogLevel = LOG_NONE;
+  CHECK(OpenArchive(&Config, Dir) == OK, "OpenArchive");
+  pArc = Config.pArchive;
+  if (! pArc) return;
+
+  memset(&Rcv, 0, sizeof(Rcv));
+  memcpy(Rcv.QmgrLib, "QMTEST    ", 10);
+  memcpy(Rcv.RcvName, "AMQA000001", 10);
+  mismatch = FALSE;
+  CHECK(ArchiveReceiver(&Config, pArc, Path, &Rcv, &mismatch) == OK &&
+        ! mismatch,
+        "save file archived and read back");
+  CHECK(pArc->NumRcvs == 1, "archived receiver recorded");
+
+  CHECK(pwrite(pArc->DataFd, "X", 1, 
+               pArc->Chunks[pArc->NumChunks - 1].Offset + 10) == 1,
+        "chunk changed");
+  NumChunks = pArc->NumChunks;
+  DataLen = pArc->DataLen;
+
+  sprintf(Path, "%s/QMTEST.AMQA000001.savf", Dir);
+  for (count = 0; count < 16384; count++) {
+    Data[count] = (unsigned char)rand();           /* New chunks first    */
+  };
+  fd = open(Path, O_WRONLY | O_TRUNC);
+  CHECK(write(fd, Data, sizeof(Data)) == sizeof(Data), "save file changed");
+  close(fd);
+
+  memset(&Rcv, 0, sizeof(Rcv));
+  memcpy(Rcv.QmgrLib, "QMTEST    ", 10);
+  memcpy(Rcv.RcvName, "AMQA000002", 10);
+  mismatch = FALSE;
+  CHECK(ArchiveReceiver(&Config, pArc, Path, &Rcv, &mismatch) != OK &&
+        mismatch,
+        "save file that doesn't read back the same is refused");
+  CHECK(pArc->NumRcvs == 1 &&
+        FindArchived(pArc, Rcv.QmgrLib, Rcv.RcvName, 0) < 0,
+        "save file that doesn't read back the same isn't recorded");
+  CHECK(Rcv.NewChunks > 0 && pArc->NumChunks == NumChunks &&
+        pArc->DataLen == DataLen && FindChunk(pArc, pArc->Chunks[0].Id,
+        pArc->Chunks[0].RawLen) == 0, "its new chunks are dropped");
+  CHECK(fstat(pArc->DataFd, &Stat) == 0 && Stat.st_size == DataLen,
+        "its new chunks' data is dropped");
+
+  pid = fork();
+  if (pid == 0) {
+    sprintf(Path, "%s/archive.lck", Dir);
+    memset(&Lock, 0, sizeof(Lock));
+    Lock.l_type = F_WRLCK;
+    Lock.l_whence = SEEK_SET;
+    fd = open(Path, O_RDWR);
+    _exit(fd >= 0 && fcntl(fd, F_SETLK, &Lock) != 0 ? 0 : 1);
+  };
+  CHECK(pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) &&
+        WEXITSTATUS(status) == 0, "archive is still locked");
+
+  CloseArchive(&Config);
+  unlink(Path);
+  for (count = 0; count < 5; count++) {
+    sprintf(Path, "%s/%s", Dir, ArcFiles[count]);
+    unlink(Path);
+  };
+  rmdir(Dir);
+}
+
+/***************************************************************************/
+/* Function:  TestHistory()                                                */
+/*                                                                         */
+/* Description: HISTORY records - a check that repeats the last one is     */
+/*              only recorded once HIST_HEARTBEAT has passed, phase times  */
+/*              of over 35 minutes are kept, the ring wraps once it is     */
+/*              full, and a file of another version isn't used             */
+/*                                                                         */
+/***************************************************************************/
+void TestHistory(void)
+{
+  struct JrnMaintConfig Config;
+  struct QmgrMaint *pQm;
+  struct HistRecord *pRing;
+  char  Dir[] = "/tmp/jrnunitXXXXXX",
+  Path[300];
+  int   count;
+
+  CHECK(mkdtemp(Dir) != 0, "history directory");
+  JrnMaintInitConfig(&Config);
+  Config.LogLevel = LOG_NONE;
+  strcpy(Config.HistoryDir, Dir);
+  pQm = JrnMaintCreate(&Config, "QMTEST");
+  if (! pQm) return;
+
+  CHECK(OpenHistory(pQm, TRUE) == OK, "history file created");
+  if (! pQm->pHist) return;
+  pRing = (struct HistRecord*)(pQm->pHist + 1);
+
+  pQm->Metrics.Cutoff = EntryAt("20240101000000000");
+  pQm->Metrics.PhaseMicros[PHASE_DELETE] = 3000000000LL;  /* 50 minutes  */
+  pQm->deletecount = 17;
+  AppendHistory(pQm);
+  CHECK(pQm->pHist->Written == 1 && pRing[0].Deleted == 17, 
+        "check recorded");
+  CHECK(pRing[0].PhaseMicros[PHASE_DELETE] == 3000000000LL,
+        "50 minute delete phase recorded");
+
+  AppendHistory(pQm);
+  CHECK(pQm->pHist->Written == 1, "repeated check not recorded");
+  pRing[0].Time -= HIST_HEARTBEAT * 1000LL;
+  AppendHistory(pQm);
+  CHECK(pQm->pHist->Written == 2 && pRing[1].Deleted == 0,
+        "repeated check recorded after an hour");
+
+  for (count = 2; count < HIST_RECORDS + 3; count++) {
+    pQm->Metrics.Cutoff += 1000;
+    AppendHistory(pQm);
+  };
+  CHECK(pQm->pHist->Written == HIST_RECORDS + 3, "ring full");
+  CHECK(pRing[2].Cutoff == pQm->Metrics.Cutoff &&
+        pRing[3].Cutoff == pQm->Metrics.Cutoff - (HIST_RECORDS - 1) * 1000LL,
+        "newest record replaced the oldest");
+
+  memcpy(pQm->pHist->Magic, "JRNHIST1", 8);
+  CloseHistory(pQm);
+  CHECK(OpenHistory(pQm, FALSE) != OK, "file of another version not used");
+
+  JrnMaintDestroy(pQm);
+  sprintf(Path, "%s/QMTEST.jrnhist", Dir);
+  unlink(Path);
+  rmdir(Dir);
+}
+
+/***************************************************************************/
+/* Function:  TestMaintApi()                                               */
+/*                                                                         */
+/* Description: The jrnmaint.h calls for one simulated queue manager, as a */
+/*              program using the library would make them, with LOG_NONE - */
+/*              nothing is printed, and errors are only returned.  The     */
+/*              chain is the default 20 receivers, of which the last 3 are */
+/*              needed.                                                    */
+/*                                                                         */
+/***************************************************************************/
+void TestMaintApi(void)
+{
+  struct JrnMaintConfig Config;
+  struct JrnMaintState State,
+  Reload,
+  BadState;
+  struct JrnMaintCutoff Cutoff,
+  Recut;
+  struct JrnMaintPlan Plan,
+  Replan;
+  struct JrnMaintResult Result;
+  struct QmgrMaint *pQm,
+  *pBad;
+  struct stat Stat;
+  char  Output[] = "/tmp/jrnunitXXXXXX",
+  LastError[200],
+  Planned[2] = {' ', ' '};
+  int   LoadRc = -1,
+  CutoffRc = -1,
+  PlanRc = -1,
+  ExecuteRc = -1,
+  ReloadRc = -1,
+  ReplanRc = -1,
+  BadRc = -1,
+  ReplayRc = -1,
+  ArchiveRc = -1,
+  fd,
+  saved;
+
+  JrnMaintInitConfig(&Config);
+  Config.LogLevel = LOG_NONE;
+  Config.DeleteReceivers = TRUE;
+  LastError[0] = '\0';
+
+  /*************************************************************************/
+  /* Everything the calls print goes to a file, which must stay empty      */
+  /*************************************************************************/
+  fd = mkstemp(Output);
+  CHECK(fd >= 0, "output file");
+  if (fd < 0) return;
+  fflush(stdout);
+  saved = dup(1);
+  dup2(fd, 1);
+
+  pQm = JrnMaintCreate(&Config, "QM20");
+  if (pQm) {
+    LoadRc = JrnMaintLoad(pQm, &State);
+    CutoffRc = JrnMaintCutoff(pQm, &Cutoff);
+    PlanRc = JrnMaintPlan(pQm, &Plan);
+    if (PlanRc == OK && Plan.NumRcvrs == 20) {
+      Planned[0] = Plan.Rcvrs[16].Plan;        /* Held by the context     */
+      Planned[1] = Plan.Rcvrs[17].Plan;        /* until the next call     */
+    };
+    ExecuteRc = JrnMaintExecute(pQm, &Result);
+    ReloadRc = JrnMaintLoad(pQm, &Reload);
+    ReplanRc = JrnMaintCutoff(pQm, &Recut) == OK ? 
+               JrnMaintPlan(pQm, &Replan) : -1;
+  };
+  pBad = JrnMaintCreate(&Config, "NOTAQMGR");
+  if (pBad) {
+    BadRc = JrnMaintLoad(pBad, &BadState);
+    strcpy(LastError, JrnMaintLastError(pBad));
+  };
+  ReplayRc = ReplayTrace(&Config, "/nonexistent/jrnunit.trace");
+  ArchiveRc = OpenArchive(&Config, "/nonexistent/jrnunit");
+
+  fflush(stdout);
+  dup2(saved, 1);
+  close(saved);
+  CHECK(fstat(fd, &Stat) == 0 && Stat.st_size == 0, "nothing printed");
+  close(fd);
+  unlink(Output);
+
+  CHECK(pQm != 0, "JrnMaintCreate");
+  if (! pQm) return;
+  CHECK(LoadRc == OK && State.NumRcvrs == 20 && State.Changed &&
+        ! memcmp(Reload.AttRcv, "AMQA000020", 10), "JrnMaintLoad");
+  CHECK(CutoffRc == OK && Cutoff.Oldest == 17 && 
+        ! memcmp(Cutoff.OldestRcv, "AMQA000018", 10) && Cutoff.Kept == 3,
+        "JrnMaintCutoff");
+  CHECK(PlanRc == OK && Plan.Eligible == 17 && 
+        Planned[0] == PLAN_DELETE && Planned[1] == PLAN_NEEDED,
+        "JrnMaintPlan");
+  CHECK(ExecuteRc == OK && Result.Retcode == OK && Result.Deleted == 17,
+        "JrnMaintExecute");
+  CHECK(ReloadRc == OK && ! Reload.Changed && Reload.NumRcvrs == 3,
+        "JrnMaintLoad after the deletes");
+  CHECK(ReplanRc == OK && Recut.Oldest == 0 && 
+        Replan.NumRcvrs == 3 && Replan.Eligible == 0 &&
+        ! memcmp(Replan.Rcvrs[0].Name, "AMQA000018", 10),
+        "JrnMaintPlan after the deletes");
+  CHECK(! strcmp(JrnMaintLastError(pQm), ""), "JrnMaintLastError, none");
+  JrnMaintDestroy(pQm);
+
+  CHECK(pBad != 0 && BadRc != OK && ! strncmp(LastError, "ERROR", 5),
+        "JrnMaintLastError after a failed load");
+  JrnMaintDestroy(pBad);
+  CHECK(ReplayRc == ERR_TRACE_FILE, "ReplayTrace error only returned");
+  CHECK(ArchiveRc == ERR_ARCHIVE && ! Config.pArchive, 
+        "OpenArchive error only returned");
+}